@@ -1,32 +1,19 @@
 #include <random>
+#include <string.h>
 
 #include "basic_life.h"
 #include "constants.h"
 
-BasicLife::BasicLife(int size, std::random_device& rd) : size(size), eng(rd()), dist(0, 7) {
-	this->cells = new uint8_t*[size+2];
-	this->nextCells = new uint8_t*[size+2];
-}
+BasicLife::BasicLife(int size, std::random_device& rd) : size(size), eng(rd()), dist(0, 7), rule(CONWAY),
+	cells(nullptr), nextCells(nullptr) {}
 
-BasicLife::~BasicLife() {
-	for (int i = 0; i < size+2; i++) {
-		delete[] cells[i];
-		delete[] nextCells[i];
-	}
-	delete[] cells;
-	delete[] nextCells;
-}
+BasicLife::~BasicLife() {}
 
 void BasicLife::setup() {
-	for (int i = 0; i < size+2; i++) {
-		cells[i] = new uint8_t[size+2];
-		nextCells[i] = new uint8_t[size+2];
-
-		for (int j = 0; j < size+2; j++) {
-			cells[i][j] = 0x0;
-			nextCells[i][j] = 0x0;
-		}
-	}
+	board = RowArena(size+2, size+2);
+	nextBoard = RowArena(size+2, size+2);
+	cells = board.rows();
+	nextCells = nextBoard.rows();
 
 	for (int i = 1; i < size+1; i++) {
 		for (int j = 1; j < size+1; j++) {
@@ -54,7 +41,7 @@ void BasicLife::tick() {
 			neighborCount += (cells[i  ][j+1]) ? 1 : 0;
 			neighborCount += (cells[i+1][j+1]) ? 1 : 0;
 
-			if (neighborCount == 3 || (cells[i][j] && neighborCount == 2)) {
+			if (rule.next(cells[i][j] != 0, neighborCount)) {
 				nextCells[i][j] = 0xFF;
 			} else {
 				nextCells[i][j] = 0x00;
@@ -73,4 +60,39 @@ void BasicLife::draw(char* pixelBuffer) {
 		memcpy(&pixelBuffer[i * WINDOW_SIZE], cells[i+1], WINDOW_SIZE);
 	}
 	swapMutex.unlock();
+}
+
+void BasicLife::drawView(const Viewport& view, uint8_t* out, ViewImage& image) {
+	const int rowLen = (size+7)/8 + 33;
+	if (viewCells.rows() == nullptr) {
+		viewCells = RowArena(size+2, rowLen, 32);
+	}
+	uint8_t** packed = viewCells.rows();
+
+	swapMutex.lock();
+	for (int i = 1; i < size+1; i++) {
+		memset(&packed[i][32], 0, rowLen-32);
+		for (int j = 0; j < size; j++) {
+			packed[i][32 + j/8] |= (cells[i][j+1] != 0) << (7 - j%8);
+		}
+	}
+	swapMutex.unlock();
+
+	renderView(packed, size, view, WINDOW_SIZE, out, image);
+}
+
+bool BasicLife::getCell(int row, int column) const {
+	return cells[row+1][column+1] != 0;
+}
+
+void BasicLife::setCell(int row, int column, bool alive) {
+	cells[row+1][column+1] = alive ? 0xFF : 0x00;
+}
+
+void BasicLife::setRule(const LifeRule& rule) {
+	this->rule = rule;
+}
+
+LifeRule BasicLife::getRule() const {
+	return rule;
 }
\ No newline at end of file
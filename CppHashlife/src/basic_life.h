@@ -4,8 +4,9 @@
 #include <mutex>
 #include <random>
 #include "life.h"
+#include "utility/row_arena.h"
 
-class BasicLife: Life {
+class BasicLife: public Life {
 public:
 	BasicLife(int size, std::random_device& rd);
 	~BasicLife();
@@ -13,14 +14,26 @@ public:
 	void setup();
 	void tick();
 	void draw(char* pixelBuffer);
+	void drawView(const Viewport& view, uint8_t* out, ViewImage& image);
+
+	// row and column from 0, only valid after setup
+	bool getCell(int row, int column) const;
+	void setCell(int row, int column, bool alive);
+
+	void setRule(const LifeRule& rule);
+	LifeRule getRule() const;
 
 private:
 	const int size;
 	std::default_random_engine eng;
 	std::uniform_int_distribution<uint8_t> dist;
+	LifeRule rule;
 
+	RowArena board; // a byte a cell, with a dead border all round
+	RowArena nextBoard;
 	uint8_t** cells;
 	uint8_t** nextCells;
 	std::mutex swapMutex;
+	RowArena viewCells; // the board packed for renderView
 	
 };
\ No newline at end of file
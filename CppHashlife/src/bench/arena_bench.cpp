@@ -0,0 +1,138 @@
+#include <immintrin.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../utility/life_kernel.h"
+#include "../utility/row_arena.h"
+
+// full board generations of SIMDLife's packed rows and BasicLife's byte rows, with the rows allocated one at a time
+// (the way both engines used to, interleaved with the other buffers allocated in the same loop) against one RowArena slab,
+// with and without huge pages
+// usage: arena_bench [sizes, default 4096 16384]
+
+using namespace std;
+using namespace std::chrono;
+
+// ~1 second of work a run at 4096, fewer generations for bigger boards
+const double PACKED_CELLS = 3e10;
+const double BYTE_CELLS = 1.5e9;
+const int REPEATS = 3; // the fastest is kept
+
+// a board's two generations, and the buffers the engine allocated alongside them
+struct Rows {
+	uint8_t** cells;
+	uint8_t** nextCells;
+	vector<RowArena> arenas;
+	vector<uint8_t*> allocations;
+
+	~Rows() {
+		for (uint8_t* p : allocations) _mm_free(p);
+		if (arenas.empty()) {
+			delete[] cells;
+			delete[] nextCells;
+		}
+	}
+};
+
+// per row, with extraRows more allocated for each row like SIMDLife's 3 frames
+static void perRow(Rows& rows, int size, int rowLen, int extraRows) {
+	rows.cells = new uint8_t*[size+2];
+	rows.nextCells = new uint8_t*[size+2];
+	for (int i = 0; i < size+2; i++) {
+		rows.cells[i] = (uint8_t*)_mm_malloc(rowLen, 32);
+		rows.nextCells[i] = (uint8_t*)_mm_malloc(rowLen, 32);
+		memset(rows.cells[i], 0, rowLen);
+		memset(rows.nextCells[i], 0, rowLen);
+		rows.allocations.push_back(rows.cells[i]);
+		rows.allocations.push_back(rows.nextCells[i]);
+		for (int e = 0; e < extraRows; e++) {
+			rows.allocations.push_back((uint8_t*)_mm_malloc(rowLen, 32));
+		}
+	}
+}
+
+static void arena(Rows& rows, int size, int rowLen, int alignedByte, bool huge) {
+	rows.arenas.emplace_back(size+2, rowLen, alignedByte, huge);
+	rows.arenas.emplace_back(size+2, rowLen, alignedByte, huge);
+	rows.cells = rows.arenas[0].rows();
+	rows.nextCells = rows.arenas[1].rows();
+}
+
+static void packedGenerations(Rows& rows, int size, int generations, const LifeKernel* kernel) {
+	const int rowLen = size/8+33;
+	for (int gen = 0; gen < generations; gen++) {
+		for (int i = 1; i < size+1; i++) {
+			for (int j = 32; j < rowLen-1; j += 64*32) {
+				kernel->nextWords(rows.cells, i, j, min(64, (rowLen-1 - j) / 32), &rows.nextCells[i][j]);
+			}
+		}
+		swap(rows.cells, rows.nextCells);
+	}
+}
+
+// BasicLife::tick
+static void byteGenerations(Rows& rows, int size, int generations) {
+	for (int gen = 0; gen < generations; gen++) {
+		uint8_t** cells = rows.cells;
+		for (int i = 1; i < size+1; i++) {
+			for (int j = 1; j < size+1; j++) {
+				int count = (cells[i-1][j-1] != 0) + (cells[i][j-1] != 0) + (cells[i+1][j-1] != 0) + (cells[i-1][j] != 0)
+					+ (cells[i+1][j] != 0) + (cells[i-1][j+1] != 0) + (cells[i][j+1] != 0) + (cells[i+1][j+1] != 0);
+				rows.nextCells[i][j] = (count == 3 || (count == 2 && cells[i][j])) ? 0xFF : 0x00;
+			}
+		}
+		swap(rows.cells, rows.nextCells);
+	}
+}
+
+static void fill(Rows& rows, int size, bool packed) {
+	mt19937_64 eng(1);
+	bernoulli_distribution alive(0.35);
+	for (int i = 1; i < size+1; i++) {
+		for (int j = 0; j < size; j++) {
+			if (!alive(eng)) continue;
+			if (packed) rows.cells[i][32 + j/8] |= 0x80 >> (j%8);
+			else rows.cells[i][j+1] = 0xFF;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	vector<int> sizes;
+	for (int i = 1; i < argc; i++) sizes.push_back(atoi(argv[i]));
+	if (sizes.empty()) sizes = { 4096, 16384 };
+
+	const LifeKernel* kernel = LifeKernel::best();
+	cout << "engine,layout,size,generations,ms_per_generation,cells_per_ns,huge_pages" << endl;
+	for (int size : sizes) {
+		for (bool packed : { true, false }) {
+			const double cells = (double)size * size;
+			const int generations = max(1, (int)((packed ? PACKED_CELLS : BYTE_CELLS) / cells));
+			const int rowLen = packed ? size/8+33 : size+2;
+			for (int layout = 0; layout < 3; layout++) {
+				Rows rows;
+				if (layout == 0) perRow(rows, size, rowLen, packed ? 3 : 0);
+				else arena(rows, size, rowLen, packed ? 32 : 0, layout == 2);
+				fill(rows, size, packed);
+
+				double best = 1e30;
+				for (int r = 0; r < REPEATS; r++) {
+					auto t0 = steady_clock::now();
+					if (packed) packedGenerations(rows, size, generations, kernel);
+					else byteGenerations(rows, size, generations);
+					best = min(best, duration<double, nano>(steady_clock::now() - t0).count() / generations);
+				}
+
+				const char* layouts[] = { "per_row", "arena", "arena_huge" };
+				cout << (packed ? kernel->name() : "basic") << ',' << layouts[layout] << ',' << size << ',' << generations << ',';
+				cout << best * 1e-6 << ',' << cells / best << ',' << (!rows.arenas.empty() && rows.arenas[0].isHuge()) << endl;
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,341 @@
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../life.h"
+#include "../basic_life.h"
+#include "../simd_life.h"
+#include "../hash_life.h"
+
+// headless benchmark of every engine, no window or GL needed
+// usage: life_bench [--engines=basic,simd,simd_stats,simd_sampled,simd_cycles,hash] [--sizes=1024,4096] [--densities=0.1,0.35] [--seeds=1]
+//                   [--rules=B3/S23,B36/S23] [--generations=200] [--warmup=10] [--threads=1] [--gpt=1] [--format=csv|json]
+// every combination of the comma separated lists is run, one result per line (csv) or per object (json)
+// --gpt is generations per tick, HashLife rounds it down to a power of 2
+
+using namespace std;
+using namespace std::chrono;
+
+struct Options {
+	vector<string> engines = { "basic", "simd", "hash" };
+	vector<int> sizes = { 1024, 4096 };
+	vector<double> densities = { 0.35 };
+	vector<int> seeds = { 1 };
+	vector<LifeRule> rules = { CONWAY };
+	vector<int> threads = { 1 };
+	vector<int> generationsPerTick = { 1 };
+	int generations = 200;
+	int warmup = 10;
+	bool json = false;
+};
+
+struct Result {
+	string engine;
+	string rule;
+	int size;
+	double density;
+	int seed;
+	int threads;
+	int generationsPerTick;
+	int ticks;
+	double ticksPerSecond;
+	double cellsPerNs;
+	double p50Us;
+	double p99Us;
+};
+
+// an engine the bench knows how to build, add new engines here
+struct Engine {
+	const char* name;
+	bool (*fits)(int size); // some engines only work on some board sizes
+	Life* (*make)(int size, int threads, int generationsPerTick, random_device& rd);
+	int (*generationsPerTick)(Life* life); // what it actually does per tick, after rounding
+	void (*load)(Life* life, int size, uint8_t** packed);
+};
+
+// setup draws the demo pattern around (400, 400) before the board is replaced
+static const int MIN_PACKED_SIZE = 512;
+
+static bool isPowerOf2(int size) {
+	return size >= MIN_PACKED_SIZE && (size & (size-1)) == 0;
+}
+
+// packed rows in the SIMDLife layout, every engine is seeded from the same board
+static void setCells(Life* life, int size, uint8_t** packed) {
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) {
+			life->setCell(i, j, (packed[i+1][32 + j/8] >> (7 - j%8)) & 1);
+		}
+	}
+}
+
+static const Engine ENGINES[] = {
+	{
+		"basic",
+		[](int size) { return size > 0; },
+		[](int size, int threads, int generationsPerTick, random_device& rd) -> Life* { return new BasicLife(size, rd); },
+		[](Life* life) { return 1; },
+		setCells
+	},
+	{
+		"simd",
+		[](int size) { return size >= MIN_PACKED_SIZE && size % 256 == 0; },
+		[](int size, int threads, int generationsPerTick, random_device& rd) -> Life* {
+			SIMDLife* life = new SIMDLife(size, rd);
+			life->setThreadCount(threads);
+			life->setGenerationsPerTick(generationsPerTick);
+			return life;
+		},
+		[](Life* life) { return ((SIMDLife*)life)->getGenerationsPerTick(); },
+		[](Life* life, int size, uint8_t** packed) { ((SIMDLife*)life)->load(packed); }
+	},
+	{
+		// SIMDLife counting every generation, to see what the counts cost
+		"simd_stats",
+		[](int size) { return size >= MIN_PACKED_SIZE && size % 256 == 0; },
+		[](int size, int threads, int generationsPerTick, random_device& rd) -> Life* {
+			SIMDLife* life = new SIMDLife(size, rd);
+			life->setThreadCount(threads);
+			life->setGenerationsPerTick(generationsPerTick);
+			life->setStatsEnabled(true);
+			life->setStatsEvery(1);
+			return life;
+		},
+		[](Life* life) { return ((SIMDLife*)life)->getGenerationsPerTick(); },
+		[](Life* life, int size, uint8_t** packed) { ((SIMDLife*)life)->load(packed); }
+	},
+	{
+		// SIMDLife counting every DEFAULT_STATS_EVERY ticks, what stats cost as they come
+		"simd_sampled",
+		[](int size) { return size >= MIN_PACKED_SIZE && size % 256 == 0; },
+		[](int size, int threads, int generationsPerTick, random_device& rd) -> Life* {
+			SIMDLife* life = new SIMDLife(size, rd);
+			life->setThreadCount(threads);
+			life->setGenerationsPerTick(generationsPerTick);
+			life->setStatsEnabled(true);
+			return life;
+		},
+		[](Life* life) { return ((SIMDLife*)life)->getGenerationsPerTick(); },
+		[](Life* life, int size, uint8_t** packed) { ((SIMDLife*)life)->load(packed); }
+	},
+	{
+		// SIMDLife hashing the board every generation to look for repeats
+		"simd_cycles",
+		[](int size) { return size >= MIN_PACKED_SIZE && size % 256 == 0; },
+		[](int size, int threads, int generationsPerTick, random_device& rd) -> Life* {
+			SIMDLife* life = new SIMDLife(size, rd);
+			life->setThreadCount(threads);
+			life->setGenerationsPerTick(generationsPerTick);
+			life->setCycleDetection(true);
+			return life;
+		},
+		[](Life* life) { return ((SIMDLife*)life)->getGenerationsPerTick(); },
+		[](Life* life, int size, uint8_t** packed) { ((SIMDLife*)life)->load(packed); }
+	},
+	{
+		"hash",
+		isPowerOf2,
+		[](int size, int threads, int generationsPerTick, random_device& rd) -> Life* {
+			HashLife* life = new HashLife(size, rd);
+			int stepLog2 = 0;
+			while ((2 << stepLog2) <= generationsPerTick) stepLog2++;
+			life->setStepLog2(stepLog2);
+			return life;
+		},
+		[](Life* life) { return 1 << ((HashLife*)life)->getStepLog2(); },
+		[](Life* life, int size, uint8_t** packed) { ((HashLife*)life)->load(packed); }
+	},
+};
+
+template<typename T>
+static vector<T> parseList(const string& value) {
+	vector<T> list;
+	stringstream in(value);
+	string item;
+	while (getline(in, item, ',')) {
+		stringstream itemIn(item);
+		T parsed;
+		itemIn >> parsed;
+		list.push_back(parsed);
+	}
+	return list;
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options) {
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		size_t eq = arg.find('=');
+		if (arg.compare(0, 2, "--") != 0 || eq == string::npos) {
+			cerr << "unknown argument " << arg << endl;
+			return false;
+		}
+		string key = arg.substr(2, eq-2);
+		string value = arg.substr(eq+1);
+
+		if (key == "engines") options.engines = parseList<string>(value);
+		else if (key == "sizes") options.sizes = parseList<int>(value);
+		else if (key == "densities") options.densities = parseList<double>(value);
+		else if (key == "seeds") options.seeds = parseList<int>(value);
+		else if (key == "rules") {
+			options.rules.clear();
+			for (const string& text : parseList<string>(value)) {
+				LifeRule rule;
+				string error;
+				if (!LifeRule::parse(text, rule, error)) {
+					cerr << error << endl;
+					return false;
+				}
+				options.rules.push_back(rule);
+			}
+		}
+		else if (key == "threads") options.threads = parseList<int>(value);
+		else if (key == "gpt") options.generationsPerTick = parseList<int>(value);
+		else if (key == "generations") options.generations = atoi(value.c_str());
+		else if (key == "warmup") options.warmup = atoi(value.c_str());
+		else if (key == "format") options.json = value == "json";
+		else {
+			cerr << "unknown option " << key << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+static uint8_t** randomBoard(int size, double density, int seed) {
+	int rowLen = size/8+33;
+	uint8_t** packed = new uint8_t*[size+2];
+	mt19937_64 eng(seed);
+	bernoulli_distribution alive(density);
+	for (int i = 0; i < size+2; i++) {
+		packed[i] = new uint8_t[rowLen];
+		memset(packed[i], 0, rowLen);
+		for (int j = 0; j < size && i > 0 && i < size+1; j++) {
+			if (alive(eng)) packed[i][32 + j/8] |= 0x80 >> (j%8);
+		}
+	}
+	return packed;
+}
+
+static void freeBoard(int size, uint8_t** packed) {
+	for (int i = 0; i < size+2; i++) {
+		delete[] packed[i];
+	}
+	delete[] packed;
+}
+
+static double percentile(vector<double>& sorted, double p) {
+	int i = min((int)sorted.size()-1, (int)(p * sorted.size()));
+	return sorted[i];
+}
+
+static Result run(const Engine& engine, const Options& options, const LifeRule& rule, int size, double density, int seed,
+		int threads, int generationsPerTick) {
+	random_device rd;
+	Life* life = engine.make(size, threads, generationsPerTick, rd);
+	life->setup();
+	life->setRule(rule);
+	uint8_t** packed = randomBoard(size, density, seed);
+	engine.load(life, size, packed);
+	freeBoard(size, packed);
+
+	int actualGenerationsPerTick = engine.generationsPerTick(life);
+	int ticks = max(1, options.generations / actualGenerationsPerTick);
+
+	for (int i = 0; i < options.warmup; i++) {
+		life->tick();
+	}
+
+	vector<double> latencies(ticks);
+	auto start = steady_clock::now();
+	for (int i = 0; i < ticks; i++) {
+		auto t0 = steady_clock::now();
+		life->tick();
+		latencies[i] = duration<double, micro>(steady_clock::now() - t0).count();
+	}
+	double totalNs = duration<double, nano>(steady_clock::now() - start).count();
+	delete life;
+
+	sort(latencies.begin(), latencies.end());
+	Result result;
+	result.engine = engine.name;
+	result.rule = rule.toString();
+	result.size = size;
+	result.density = density;
+	result.seed = seed;
+	result.threads = threads;
+	result.generationsPerTick = actualGenerationsPerTick;
+	result.ticks = ticks;
+	result.ticksPerSecond = ticks / (totalNs * 1e-9);
+	result.cellsPerNs = (double)size * size * ticks * actualGenerationsPerTick / totalNs;
+	result.p50Us = percentile(latencies, 0.50);
+	result.p99Us = percentile(latencies, 0.99);
+	return result;
+}
+
+static void printCsvHeader() {
+	cout << "engine,rule,size,density,seed,threads,generations_per_tick,ticks,ticks_per_s,cells_per_ns,p50_us,p99_us" << endl;
+}
+
+static void printCsv(const Result& r) {
+	cout << r.engine << ',' << r.rule << ',' << r.size << ',' << r.density << ',' << r.seed << ',' << r.threads << ',';
+	cout << r.generationsPerTick << ',' << r.ticks << ',' << r.ticksPerSecond << ',' << r.cellsPerNs << ',';
+	cout << r.p50Us << ',' << r.p99Us << endl;
+}
+
+static void printJson(const Result& r, bool first) {
+	cout << (first ? "[\n" : ",\n");
+	cout << "  {\"engine\": \"" << r.engine << "\", \"rule\": \"" << r.rule << "\", \"size\": " << r.size << ", \"density\": " << r.density;
+	cout << ", \"seed\": " << r.seed << ", \"threads\": " << r.threads << ", \"generations_per_tick\": " << r.generationsPerTick;
+	cout << ", \"ticks\": " << r.ticks << ", \"ticks_per_s\": " << r.ticksPerSecond << ", \"cells_per_ns\": " << r.cellsPerNs;
+	cout << ", \"p50_us\": " << r.p50Us << ", \"p99_us\": " << r.p99Us << "}";
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		return 1;
+	}
+
+	if (!options.json) printCsvHeader();
+	bool first = true;
+	for (const string& name : options.engines) {
+		const Engine* engine = nullptr;
+		for (const Engine& e : ENGINES) {
+			if (name == e.name) engine = &e;
+		}
+		if (engine == nullptr) {
+			cerr << "unknown engine " << name << endl;
+			return 1;
+		}
+
+		for (int size : options.sizes) {
+			if (!engine->fits(size)) {
+				cerr << "skipping " << name << " at size " << size << endl;
+				continue;
+			}
+			for (const LifeRule& rule : options.rules) {
+				for (double density : options.densities) {
+					for (int seed : options.seeds) {
+						for (int threads : options.threads) {
+							for (int generationsPerTick : options.generationsPerTick) {
+								Result result = run(*engine, options, rule, size, density, seed, threads, generationsPerTick);
+								if (options.json) printJson(result, first);
+								else printCsv(result);
+								first = false;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	if (options.json) cout << (first ? "[]" : "\n]") << endl;
+
+	return 0;
+}
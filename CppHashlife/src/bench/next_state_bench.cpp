@@ -0,0 +1,162 @@
+#include <immintrin.h>
+#include <x86intrin.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <random>
+
+#include "../utility/life_kernel.h"
+
+// cycles per 256 cells of every LifeKernel this cpu supports, against the kernel they replaced
+// the old kernel needed a scalar pre-pass filling a corners array (which it then ignored),
+// and rebuilt the bits crossing 16 bit and 128 bit boundaries from scalar reads on every shift
+
+using namespace std;
+
+const int SIZE = 4096;
+const int ROW_LEN = SIZE/8+33;
+const int ROWS = 64;
+const int REPEATS = 2000;
+
+#define CMP_SWAP(i, j) { \
+	auto x = neighbors[i]; \
+	neighbors[i] = _mm256_or_si256(x, neighbors[j]); \
+	neighbors[j] = _mm256_and_si256(x, neighbors[j]); \
+}
+
+static void legacyShiftLeft(uint8_t* rawBits, const __m256i& bits, __m256i& shiftedBits, bool rightmostBit) {
+	auto removeRightBit = _mm256_set1_epi16(0xFEFF);
+	auto rightBitMask = _mm256_set1_epi16(0x0100);
+
+	auto leftedBits = _mm256_slli_epi16(bits, 1);
+	auto sadBits = _mm256_srli_epi16(bits, 15);
+	auto leftNoBorder = _mm256_or_si256(leftedBits, sadBits);
+	leftNoBorder = _mm256_and_si256(leftNoBorder, removeRightBit);
+
+	auto borderBit = _mm256_and_si256(leftedBits, rightBitMask);
+	borderBit = _mm256_srli_si256(borderBit, 2);
+	auto leftWithBorder = _mm256_or_si256(leftNoBorder, borderBit);
+
+	uint64_t midBit = (rawBits[16] & 0x80) ? 0x0100000000000000LL : 0x0LL;
+	uint64_t endBit = rightmostBit ? 0x0100000000000000LL : 0x0LL;
+	auto holeVec = _mm256_set_epi64x(endBit, 0x0, midBit, 0x0);
+	shiftedBits = _mm256_or_si256(leftWithBorder, holeVec);
+}
+
+static void legacyShiftRight(uint8_t* rawBits, const __m256i& bits, __m256i& shiftedBits, bool leftmostBit) {
+	auto removeLeftBit = _mm256_set1_epi16(0xFF7F);
+	auto leftBitMask = _mm256_set1_epi16(0x0080);
+
+	auto rightedBits = _mm256_srli_epi16(bits, 1);
+	auto sadBits = _mm256_slli_epi16(bits, 15);
+	auto rightNoBorder = _mm256_or_si256(rightedBits, sadBits);
+	rightNoBorder = _mm256_and_si256(rightNoBorder, removeLeftBit);
+
+	auto borderBit = _mm256_and_si256(rightedBits, leftBitMask);
+	borderBit = _mm256_slli_si256(borderBit, 2);
+	auto rightWithBorder = _mm256_or_si256(rightNoBorder, borderBit);
+
+	uint64_t midBit = (rawBits[15] & 0x01) ? 0x0000000000000080LL : 0x0LL;
+	uint64_t endBit = leftmostBit ? 0x0000000000000080LL : 0x0LL;
+	auto holeVec = _mm256_set_epi64x(0x0, midBit, 0x0, endBit);
+	shiftedBits = _mm256_or_si256(rightWithBorder, holeVec);
+}
+
+static void legacyNextState(uint8_t** cells, int row, int column, __m256i& nextCells) {
+	auto state = _mm256_load_si256((__m256i *)&cells[row][column]);
+
+	__m256i neighbors[8];
+	neighbors[1] = _mm256_load_si256((__m256i *)(&cells[row-1][column]));
+	neighbors[6] = _mm256_load_si256((__m256i *)(&cells[row+1][column]));
+	legacyShiftRight(&cells[row-1][column], neighbors[1], neighbors[0], (cells[row-1][column-1 ] & 0x01));
+	legacyShiftLeft (&cells[row-1][column], neighbors[1], neighbors[2], (cells[row-1][column+32] & 0x80));
+	legacyShiftRight(&cells[row  ][column], state,        neighbors[3], (cells[row  ][column-1 ] & 0x01));
+	legacyShiftLeft (&cells[row  ][column], state,        neighbors[4], (cells[row  ][column+32] & 0x80));
+	legacyShiftRight(&cells[row+1][column], neighbors[6], neighbors[5], (cells[row+1][column-1 ] & 0x01));
+	legacyShiftLeft (&cells[row+1][column], neighbors[6], neighbors[7], (cells[row+1][column+32] & 0x80));
+
+	CMP_SWAP(3, 7); CMP_SWAP(2, 6); CMP_SWAP(1, 5); CMP_SWAP(0, 4);
+	CMP_SWAP(5, 7); CMP_SWAP(4, 6); CMP_SWAP(1, 3); CMP_SWAP(0, 2); CMP_SWAP(3, 5); CMP_SWAP(2, 4);
+	CMP_SWAP(6, 7); CMP_SWAP(4, 5); CMP_SWAP(2, 3); CMP_SWAP(0, 1);
+	CMP_SWAP(3, 6); CMP_SWAP(1, 4); CMP_SWAP(5, 6); CMP_SWAP(3, 4); CMP_SWAP(1, 2);
+
+	auto twoMaybeThree = _mm256_and_si256(neighbors[1], neighbors[0]);
+	twoMaybeThree = _mm256_andnot_si256(neighbors[3], twoMaybeThree);
+	auto exactlyThree = _mm256_and_si256(twoMaybeThree, neighbors[2]);
+	nextCells = _mm256_or_si256(exactlyThree, _mm256_and_si256(twoMaybeThree, state));
+}
+
+// the pre-pass the old tick ran before the kernel, one bit at a time
+static void legacyCorners(uint8_t** cells, uint8_t* corners) {
+	int cornerI = 0;
+	for (int i = 0; i < ROWS+2; i++) {
+		for (int j = 32; j < ROW_LEN-1; j += 32) {
+			corners[cornerI >> 3] |= (cells[i][j-1] & 0x01) << (cornerI & 7);
+			cornerI++;
+			corners[cornerI >> 3] |= ((cells[i][j+32] & 0x80) >> 7) << (cornerI & 7);
+			cornerI++;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	mt19937 eng(1234);
+	uint8_t** cells = new uint8_t*[ROWS+2];
+	uint8_t** nextCells = new uint8_t*[ROWS+2];
+	uint8_t** legacyCells = new uint8_t*[ROWS+2];
+	for (int i = 0; i < ROWS+2; i++) {
+		cells[i] = (uint8_t*)_mm_malloc(ROW_LEN, 32);
+		nextCells[i] = (uint8_t*)_mm_malloc(ROW_LEN, 32);
+		legacyCells[i] = (uint8_t*)_mm_malloc(ROW_LEN, 32);
+		memset(cells[i], 0, ROW_LEN);
+		for (int j = 32; j < ROW_LEN-1 && i > 0 && i < ROWS+1; j++) {
+			cells[i][j] = eng() & eng();
+		}
+	}
+	uint8_t* corners = new uint8_t[(ROWS+2) * SIZE/128 / 8 + 1];
+
+	__m256i nextState;
+	const double words = (double)REPEATS * ROWS * (SIZE/256);
+
+	uint64_t t0 = __rdtsc();
+	for (int r = 0; r < REPEATS; r++) {
+		memset(corners, 0, (ROWS+2) * SIZE/128 / 8 + 1);
+		legacyCorners(cells, corners);
+		for (int i = 1; i < ROWS+1; i++) {
+			for (int j = 32; j < ROW_LEN-1; j += 32) {
+				legacyNextState(cells, i, j, nextState);
+				_mm256_store_si256((__m256i*)&legacyCells[i][j], nextState);
+			}
+		}
+	}
+	uint64_t t1 = __rdtsc();
+	cout << "legacy: " << (t1 - t0) / words << " cycles per 256 cells (corners pre-pass + scalar carries)" << endl;
+
+	const LifeKernel* kernels[8];
+	int kernelCount = LifeKernel::supported(kernels);
+	bool same = true;
+	for (int k = 0; k < kernelCount; k++) {
+		for (int i = 1; i < ROWS+1; i++) {
+			memset(nextCells[i], 0, ROW_LEN);
+		}
+
+		uint64_t start = __rdtsc();
+		for (int r = 0; r < REPEATS; r++) {
+			for (int i = 1; i < ROWS+1; i++) {
+				kernels[k]->nextWords(cells, i, 32, SIZE/256, &nextCells[i][32]);
+			}
+		}
+		uint64_t stop = __rdtsc();
+
+		bool kernelSame = true;
+		for (int i = 1; i < ROWS+1; i++) {
+			kernelSame = kernelSame && memcmp(&nextCells[i][32], &legacyCells[i][32], ROW_LEN-33) == 0;
+		}
+		same = same && kernelSame;
+
+		cout << kernels[k]->name() << ": " << (stop - start) / words << " cycles per 256 cells, results ";
+		cout << (kernelSame ? "match" : "DO NOT match") << endl;
+	}
+
+	return same ? 0 : 1;
+}
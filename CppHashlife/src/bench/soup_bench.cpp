@@ -0,0 +1,95 @@
+#include <stdlib.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../soup_search.h"
+#include "../utility/life_kernel.h"
+
+// soups run to stabilization per second, for each arena size and kernel
+// usage: soup_bench [--arenas=64,256] [--soups=5000] [--soup-size=16] [--threads=1] [--seed=1] [--max-generations=100000]
+//                   [--census=census.csv]
+// the census of the last run (every soup's seed, when it settled, its period and population) goes to --census if given
+
+using namespace std;
+using namespace std::chrono;
+
+int main(int argc, char* argv[]) {
+	vector<int> arenas = { 64, 256 };
+	int soups = 5000;
+	int soupSize = 16;
+	int threads = 1;
+	uint64_t seed = 1;
+	int64_t maxGenerations = 100000;
+	string censusPath;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		size_t eq = arg.find('=');
+		if (arg.compare(0, 2, "--") != 0 || eq == string::npos) {
+			cerr << "unknown argument " << arg << endl;
+			return 1;
+		}
+		string key = arg.substr(2, eq-2);
+		string value = arg.substr(eq+1);
+		if (key == "arenas") {
+			arenas.clear();
+			stringstream in(value);
+			string item;
+			while (getline(in, item, ',')) arenas.push_back(atoi(item.c_str()));
+		}
+		else if (key == "soups") soups = atoi(value.c_str());
+		else if (key == "soup-size") soupSize = atoi(value.c_str());
+		else if (key == "threads") threads = atoi(value.c_str());
+		else if (key == "seed") seed = strtoull(value.c_str(), nullptr, 10);
+		else if (key == "max-generations") maxGenerations = atoll(value.c_str());
+		else if (key == "census") censusPath = value;
+		else {
+			cerr << "unknown option " << key << endl;
+			return 1;
+		}
+	}
+
+	cout << "arena,kernel,threads,soups,arenas_per_strip,soups_per_s,generations_per_soup,unsettled" << endl;
+	vector<SoupResult> results;
+	const LifeKernel* kernels[8];
+	int kernelCount = LifeKernel::supported(kernels);
+	for (int arena : arenas) {
+		if (arena < 64 || arena % 64 != 0) {
+			cerr << "skipping arena " << arena << ", it has to be a multiple of 64" << endl;
+			continue;
+		}
+		for (int k = 0; k < kernelCount; k++) {
+			SoupSearch search(arena, soupSize, kernels[k]);
+			search.setThreadCount(threads);
+			search.setMaxGenerations(maxGenerations);
+
+			auto t0 = steady_clock::now();
+			results = search.run(seed, soups);
+			double seconds = duration<double>(steady_clock::now() - t0).count();
+
+			// a soup which settled was run for one period past where its cycle started
+			double generations = 0;
+			int unsettled = 0;
+			for (const SoupResult& result : results) {
+				generations += result.period ? result.stabilized + result.period : maxGenerations;
+				unsettled += result.period == 0;
+			}
+			cout << arena << "," << kernels[k]->name() << "," << threads << "," << soups << "," << search.getArenasPerStrip();
+			cout << "," << soups / seconds << "," << generations / max(1, soups) << "," << unsettled << endl;
+		}
+	}
+
+	if (!censusPath.empty()) {
+		ofstream census(censusPath);
+		SoupSearch::writeCensus(census, results);
+		if (!census) {
+			cerr << "couldn't write " << censusPath << endl;
+			return 1;
+		}
+	}
+	return 0;
+}
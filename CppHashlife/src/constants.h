@@ -4,4 +4,9 @@ const int WINDOW_SIZE = 1024;
 const int PIXEL_COUNT = WINDOW_SIZE * WINDOW_SIZE;
 
 const int CELL_WIDTH = 1; // code in draw is hard-coded to have CELL_WIDTH = 1
-const int CELLS_SIZE = WINDOW_SIZE*4 / CELL_WIDTH;
\ No newline at end of file
+const int CELLS_SIZE = WINDOW_SIZE*4 / CELL_WIDTH;
+
+// the pattern every engine starts with, drawn with its top left corner at DEMO_ROW, DEMO_COLUMN
+const char* const DEMO_RLE = "38bo$38b2o$39b2o$34b2o2b2o$11bo$2o8b2o$2o7b2o$10b2o2b2o18b2o2b2o$39b2o7b2o$38b2o8b2o$38bo$10b2o2b2o$9b2o$10b2o$11bo!";
+const int DEMO_ROW = 386;
+const int DEMO_COLUMN = 400;
\ No newline at end of file
@@ -67,6 +67,11 @@ public:
         AVX_STORE(out, chunks);
     }
 
+    // from 32 bytes at any alignment, the reverse of getAll
+    void setAll(const void *in) {
+        chunks = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+    }
+
     void zero() {
         chunks = _mm256_set1_epi8(0x00);
     }
@@ -102,6 +107,49 @@ public:
         return this;
     }
 
+    // index i moves to AVX_SIZE-1-i: the bytes in reverse order, then the bits in each byte
+    AvxBitArray* reverse() {
+        const __m256i byteReverse = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+            15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        const __m256i nibbleReverse = _mm256_setr_epi8(0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15,
+            0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15);
+        const __m256i lowNibbles = _mm256_set1_epi8(0x0F);
+        chunks = _mm256_shuffle_epi8(chunks, byteReverse);
+        chunks = _mm256_permute2x128_si256(chunks, chunks, 1);
+        auto low = _mm256_shuffle_epi8(nibbleReverse, _mm256_and_si256(chunks, lowNibbles));
+        auto high = _mm256_shuffle_epi8(nibbleReverse, _mm256_and_si256(_mm256_srli_epi16(chunks, 4), lowNibbles));
+        chunks = _mm256_or_si256(_mm256_slli_epi16(low, 4), high);
+        return this;
+    }
+
+    // index i moves to i with its 8 bits in reverse order, swapping index bits 0 and 7, 1 and 6, 2 and 5, 3 and 4
+    AvxBitArray* reverseIndexBits() {
+        const long long even = 0x5555555555555555LL; // index bit 0 clear
+        const long long odd = ~even;
+        const long long evenPairs = 0x3333333333333333LL; // index bit 1 clear
+        const long long oddPairs = ~evenPairs;
+
+        // index bit 7 picks the 128 bit half, the bits which move come from the same place in the other half
+        auto swapped = _mm256_permute4x64_epi64(chunks, 0x4E);
+        auto kept = _mm256_and_si256(chunks, _mm256_setr_epi64x(even, even, odd, odd));
+        auto down = _mm256_slli_epi64(_mm256_and_si256(swapped, _mm256_setr_epi64x(even, even, 0, 0)), 1);
+        auto up = _mm256_srli_epi64(_mm256_and_si256(swapped, _mm256_setr_epi64x(0, 0, odd, odd)), 1);
+        chunks = _mm256_or_si256(kept, _mm256_or_si256(down, up));
+
+        // index bit 6 picks the 64 bits within a half
+        swapped = _mm256_permute4x64_epi64(chunks, 0xB1);
+        kept = _mm256_and_si256(chunks, _mm256_setr_epi64x(evenPairs, oddPairs, evenPairs, oddPairs));
+        down = _mm256_slli_epi64(_mm256_and_si256(swapped, _mm256_setr_epi64x(evenPairs, 0, evenPairs, 0)), 2);
+        up = _mm256_srli_epi64(_mm256_and_si256(swapped, _mm256_setr_epi64x(0, oddPairs, 0, oddPairs)), 2);
+        chunks = _mm256_or_si256(kept, _mm256_or_si256(down, up));
+
+        // the other two pairs are within each 64 bits, a delta swap each: the bits with the lower index bit set and
+        // the higher clear trade places with the ones shift above them
+        chunks = deltaSwap(chunks, 0x00000000F0F0F0F0LL, 28);
+        chunks = deltaSwap(chunks, 0x0000FF000000FF00LL, 8);
+        return this;
+    }
+
     AvxBitArray operator~() const {
         AvxBitArray out(*this);
         out.invert();
@@ -275,6 +323,13 @@ public:
         return out;
     }
 
+private:
+    static __m256i deltaSwap(__m256i x, long long mask, int shift) {
+        auto t = _mm256_and_si256(_mm256_xor_si256(_mm256_srli_epi64(x, shift), x), _mm256_set1_epi64x(mask));
+        return _mm256_xor_si256(x, _mm256_xor_si256(t, _mm256_slli_epi64(t, shift)));
+    }
+
+public:
     // adaptation of MurmurHash (https://github.com/aappleby/smhasher/blob/master/src/MurmurHash3.cpp)
     uint64_t hash() const {
         const uint32_t seed = 0xdc5a1d43; // randomly generated
@@ -307,4 +362,10 @@ public:
         uint64_t hHigh = _mm256_extract_epi32(hs, 4);
         return (hHigh << 32) | (hLow & 0xFFFFFFFF);
     }
+};
+
+struct AvxBitArrayHasher {
+    size_t operator()(const AvxBitArray& bitArray) const {
+        return bitArray.hash();
+    }
 };
\ No newline at end of file
@@ -1,41 +1,49 @@
 #pragma once
+#include <string.h>
 #include "compressed_bit_array.h"
 
+// every output space is 256 bits, but the ones the search stores are mostly the 20-32 outputs left several swaps in,
+// spread over every popcount, so listing them a byte each is as big as the bitmap and the whole space is kept.
+// with COMPRESSED_KEYS it's cut to a fingerprint instead: AvxBitArray::hash, which also places it in the table,
+// and a second 64 bit hash over all four words
 class BitArrayCompressor {
 public:
     CompressedBitArray compress(const AvxBitArray& bitArray) const {
-        CompressedBitArray compressed(doCompress(bitArray).getData());
-        return compressed;
-    }
-
-    CompressedBitArray findable(const AvxBitArray& bitArray) const {
-        CompressedBitArray out(bitArray.hash(), &bitArray);
-        return out;
+        return doCompress(bitArray, bitArray.hash());
     }
 
-    void ensureInitialized(CompressedBitArray& bitArray) {
-        if (bitArray.lazyGroupedBitArray.instantiated()) return;
-        GroupedBitArray b = doCompress(bitArray.lazyGroupedBitArray.findable.uncompressedBitArray);
-        bitArray.lazyGroupedBitArray.data = b.getData();
+    // hash is bitArray.hash(), for callers which have it already
+    CompressedBitArray compress(const AvxBitArray& bitArray, uint64_t hash) const {
+        return doCompress(bitArray, hash);
     }
 
 private:
-    GroupedBitArray doCompress(const AvxBitArray& bitArray) const {
-        GroupedBitArray compressed(256);
+    CompressedBitArray doCompress(const AvxBitArray& bitArray, uint64_t hash) const {
+        alignas(32) uint64_t words[4];
+        bitArray.getAll(words);
+        CompressedBitArray compressed;
+        #ifdef COMPRESSED_KEYS
+            compressed.words[0] = hash;
+            compressed.words[1] = fingerprint(words);
+        #else
+            memcpy(compressed.words, words, sizeof(words));
+        #endif
         return compressed;
     }
-};
 
-class CompressedBitArrayEquality {
-private:
-    BitArrayCompressor* compressor;
-
-public:
-    CompressedBitArrayEquality(BitArrayCompressor* compressor): compressor(compressor) {}
+    // MurmurHash3's 64 bit finalizer, chained so every bit of every word reaches every bit of the result
+    static uint64_t mix64(uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xFF51AFD7ED558CCDULL;
+        k ^= k >> 33;
+        k *= 0xC4CEB9FE1A85EC53ULL;
+        k ^= k >> 33;
+        return k;
+    }
 
-    bool operator()(CompressedBitArray& key1, CompressedBitArray& key2) const {
-        compressor->ensureInitialized(key1);
-        compressor->ensureInitialized(key2);
-        return GroupedBitArray(key1.lazyGroupedBitArray.data) == GroupedBitArray(key2.lazyGroupedBitArray.data);
+    static uint64_t fingerprint(const uint64_t* words) {
+        uint64_t h = 0x9E3779B97F4A7C15ULL;
+        for (int i = 0; i < 4; i++) h = mix64(h ^ words[i]) + i;
+        return h;
     }
-};
\ No newline at end of file
+};
@@ -1,25 +1,45 @@
 #pragma once
-#include "grouped_bit_array.h"
+#include <stdint.h>
 #include "avx_bit_array.h"
 
+// define COMPRESSED_KEYS to key the explored table on a 128 bit fingerprint of each output space instead of the
+// whole 256 bits, 24 byte slots instead of 40. two different spaces getting the same fingerprint is ~2^-96 per pair,
+// so the odd wrong answer in a search of billions of spaces is possible but wildly unlikely
+// #define COMPRESSED_KEYS
+
+// an output space as the explored table keeps it, see BitArrayCompressor
 class CompressedBitArray {
 public:
-    GroupedBitArray::Lazy lazyGroupedBitArray;
+    #ifdef COMPRESSED_KEYS
+        static const int WORDS = 2;
+    #else
+        static const int WORDS = 4;
+    #endif
 
-public:
-    CompressedBitArray(uint64_t hash, const AvxBitArray* bitArray) {
-        this->lazyGroupedBitArray.findable.hash = hash;
-        this->lazyGroupedBitArray.findable.uncompressedBitArray = bitArray;
+    uint64_t words[WORDS];
+
+    bool operator==(const CompressedBitArray& other) const {
+        bool same = true;
+        for (int i = 0; i < WORDS; i++) same &= words[i] == other.words[i];
+        return same;
     }
 
-    CompressedBitArray(GroupedBitArray::Data data) {
-        this->lazyGroupedBitArray.data = data;
+    bool operator!=(const CompressedBitArray& other) const {
+        return !(*this == other);
     }
 };
 
+// the same hash the output space it came from has, so a table can find it from the uncompressed space
+// without compressing it first, and the first word of a fingerprint is that hash
 class CompressedBitArrayHasher {
 public:
     uint64_t operator()(const CompressedBitArray& key) const {
-        return 0;
+        #ifdef COMPRESSED_KEYS
+            return key.words[0];
+        #else
+            AvxBitArray bitArray(false);
+            bitArray.setAll(key.words);
+            return bitArray.hash();
+        #endif
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,416 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "avx_bit_array.h"
+#include "bit_array_compressor.h"
+
+struct Swap {
+    uint8_t i;
+    uint8_t j;
+
+    Swap(): Swap(0, 0) {}
+    Swap(int i, int j): i(i), j(j) {}
+};
+
+// a success is the fewest swaps (height) this output space needs and the first of them,
+// a failure is that it can't be done in height swaps
+struct ExploredSpace {
+    Swap swap;
+    uint8_t height;
+    bool success = false;
+};
+
+// explored output spaces shared by every search thread, split into shards by hash which are each locked on their own
+// so threads only wait on each other when they hit the same shard at the same time.
+// each shard is an open addressing table with linear probing, the compressed space and what's known about it are
+// stored inline in the slot so a lookup is one hash and (usually) one cache line.
+// the slots can be a file instead (see mapFile), which a later search for the same outputs picks up where this one left.
+// a file, or a table given a memory budget, has a fixed number of slots, and once a shard's full a new space takes the
+// place of the failure near where it goes which rules out the fewest swaps (see replace). a success is never dropped
+// in memory, a shard of only successes goes past the budget for it
+class ExploredTable {
+public:
+    static const int SHARD_COUNT_LOG_2 = 6;
+    static const int SHARD_COUNT = 1 << SHARD_COUNT_LOG_2;
+    static const size_t INITIAL_SLOTS = 1024; // per shard, a power of 2
+    static const int MAX_LOAD_PERCENT = 70; // probe chains get long quickly past this
+    static const int HEADER_BYTES = 4096; // a page, so the slots after it are page aligned
+    static const uint32_t VERSION = 1;
+    static const int REPLACE_WINDOW = 8; // slots from where a space goes in a full shard it can take the place of
+
+    struct Stats {
+        uint64_t entries = 0;
+        uint64_t slots = 0;
+        uint64_t bytes = 0; // all the slots, used or not
+        uint64_t lookups = 0;
+        uint64_t inserts = 0;
+        uint64_t capacity = 0; // the most slots there'll be, 0 if the table can grow as big as it likes (see keepSuccess)
+        uint64_t replaced = 0; // spaces which took another's slot in a full shard
+        uint64_t dropped = 0; // spaces a full shard had no failure near where they go to give up for
+    };
+
+    ExploredTable() {
+        for (Shard& shard : shards) {
+            shard.owned.resize(INITIAL_SLOTS);
+            shard.slots = shard.owned.data();
+            shard.size = INITIAL_SLOTS;
+        }
+    }
+
+    ~ExploredTable() {
+        #ifdef __linux__
+            if (mapped != nullptr) munmap(mapped, mappedBytes);
+        #endif
+    }
+
+    // shards stop growing at their share of bytes, the slots only, rounded down to a power of 2 each and never less
+    // than INITIAL_SLOTS. growing one briefly needs its old slots as well, 1/SHARD_COUNT of the budget at most
+    void setMemoryBudget(uint64_t bytes) {
+        maxShardSlots = INITIAL_SLOTS;
+        while (SHARD_COUNT * maxShardSlots * 2 * sizeof(Slot) <= bytes) maxShardSlots *= 2;
+    }
+
+    ExploredTable(const ExploredTable&) = delete;
+    ExploredTable& operator=(const ExploredTable&) = delete;
+
+    // keeps the slots in the file at path from now on, mapped shared, so everything stored is written back to it
+    // (even when the search is killed, the kernel has the pages) and whatever it held is found again. a new file is
+    // made as big as fits in bytes, an existing one keeps its size, and has to have been made for the same identity,
+    // which the caller makes up from whatever changes what a stored space means. a file never grows, see replace.
+    // it replaces what's in memory, so it's for before the first search. false with an error if it can't
+    bool mapFile(const std::string& path, uint64_t bytes, uint64_t identity, std::string& error) {
+        static_assert(std::is_trivially_copyable<Slot>::value, "slots are read and written as raw bytes");
+        #ifdef __linux__
+            int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd < 0) {
+                error = "can't open " + path;
+                return false;
+            }
+            struct stat st;
+            fstat(fd, &st);
+
+            FileHeader header;
+            bool fresh = st.st_size == 0;
+            if (fresh) {
+                uint64_t shardSlots = INITIAL_SLOTS;
+                while (HEADER_BYTES + SHARD_COUNT * shardSlots * 2 * sizeof(Slot) <= bytes) shardSlots *= 2;
+                makeHeader(header, shardSlots, identity);
+                if (ftruncate(fd, HEADER_BYTES + SHARD_COUNT * shardSlots * sizeof(Slot)) != 0 ||
+                        pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+                    close(fd);
+                    error = "can't make " + path;
+                    return false;
+                }
+            } else {
+                FileHeader expected;
+                bool read = pread(fd, &header, sizeof(header), 0) == sizeof(header);
+                makeHeader(expected, read ? header.shardSlots : 0, identity);
+                if (!read || memcmp(&header, &expected, sizeof(header)) != 0 ||
+                        (uint64_t)st.st_size != HEADER_BYTES + SHARD_COUNT * header.shardSlots * sizeof(Slot)) {
+                    close(fd);
+                    error = path + " isn't an explored table for this search";
+                    return false;
+                }
+            }
+
+            const size_t fileBytes = HEADER_BYTES + SHARD_COUNT * header.shardSlots * sizeof(Slot);
+            void* p = mmap(nullptr, fileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (p == MAP_FAILED) {
+                error = "can't map " + path;
+                return false;
+            }
+            if (mapped != nullptr) munmap(mapped, mappedBytes);
+            mapped = p;
+            mappedBytes = fileBytes;
+
+            Slot* slots = (Slot*)((uint8_t*)p + HEADER_BYTES);
+            for (int s = 0; s < SHARD_COUNT; s++) {
+                Shard& shard = shards[s];
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                std::vector<Slot>().swap(shard.owned);
+                shard.slots = slots + s * header.shardSlots;
+                shard.size = header.shardSlots;
+                shard.count = 0;
+                for (size_t i = 0; i < shard.size; i++) shard.count += shard.slots[i].used;
+            }
+            return true;
+        #else
+            error = "explored table files need mmap";
+            return false;
+        #endif
+    }
+
+    bool isMapped() const {
+        return mapped != nullptr;
+    }
+
+    bool isBounded() const {
+        return mapped != nullptr || maxShardSlots != UNBOUNDED;
+    }
+
+    bool find(const AvxBitArray& outputSpace, ExploredSpace& out) {
+        const uint64_t rawHash = outputSpace.hash();
+        const CompressedBitArray key = compressor.compress(outputSpace, rawHash);
+        const uint64_t hash = spread(rawHash);
+        Shard& shard = shardFor(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.lookups++;
+        const Slot& slot = probe(shard, key, hash);
+        if (!slot.used) return false;
+        out = slot.explored;
+        return true;
+    }
+
+    // a success replaces a failure, but the first success for a space is kept, they're all best possible
+    // so it doesn't matter which one the network is rebuilt from
+    void putSuccess(const AvxBitArray& outputSpace, const ExploredSpace& found) {
+        const uint64_t rawHash = outputSpace.hash();
+        const CompressedBitArray key = compressor.compress(outputSpace, rawHash);
+        const uint64_t hash = spread(rawHash);
+        Shard& shard = shardFor(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        Slot* slot = insert(shard, key, hash, found, true);
+        if (slot != nullptr && !slot->explored.success) slot->explored = found;
+    }
+
+    // only ever raises a failure's height, and never overwrites a success another thread stored meanwhile
+    void putFailure(const AvxBitArray& outputSpace, uint8_t height) {
+        const uint64_t rawHash = outputSpace.hash();
+        const CompressedBitArray key = compressor.compress(outputSpace, rawHash);
+        const uint64_t hash = spread(rawHash);
+        Shard& shard = shardFor(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ExploredSpace failed;
+        failed.height = height;
+        Slot* slot = insert(shard, key, hash, failed, false);
+        if (slot != nullptr && !slot->explored.success && slot->explored.height < height) slot->explored.height = height;
+    }
+
+    size_t size() {
+        return stats().entries;
+    }
+
+    Stats stats() {
+        Stats total;
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total.entries += shard.count;
+            total.slots += shard.size;
+            total.lookups += shard.lookups;
+            total.inserts += shard.inserts;
+            total.replaced += shard.replaced;
+            total.dropped += shard.dropped;
+        }
+        total.bytes = total.slots * sizeof(Slot);
+        if (mapped != nullptr) total.capacity = total.slots;
+        else if (maxShardSlots != UNBOUNDED) total.capacity = SHARD_COUNT * maxShardSlots;
+        return total;
+    }
+
+private:
+    struct Slot {
+        CompressedBitArray key;
+        ExploredSpace explored;
+        bool used = false;
+    };
+
+    // a cache line each so threads locking neighbouring shards don't fight over it
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<Slot> owned; // the slots when they're in memory
+        Slot* slots; // a power of 2 of them
+        size_t size;
+        uint64_t count = 0;
+        uint64_t lookups = 0;
+        uint64_t inserts = 0;
+        uint64_t replaced = 0;
+        uint64_t dropped = 0;
+    };
+    Shard shards[SHARD_COUNT];
+    BitArrayCompressor compressor;
+    void* mapped = nullptr;
+    size_t mappedBytes = 0;
+    static const uint64_t UNBOUNDED = ~0ULL;
+    uint64_t maxShardSlots = UNBOUNDED;
+
+    // the start of a table file, the rest of its page is zero. everything a slot's bytes depend on is in it, so a file
+    // from a build with other keys or another layout isn't misread
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t slotBytes;
+        uint32_t keyWords;
+        uint32_t shardCount;
+        uint64_t shardSlots;
+        uint64_t identity;
+    };
+
+    static void makeHeader(FileHeader& header, uint64_t shardSlots, uint64_t identity) {
+        static const char MAGIC[8] = { 'N', 'F', 'T', 'A', 'B', 'L', 'E', '\n' };
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.slotBytes = sizeof(Slot);
+        header.keyWords = CompressedBitArray::WORDS;
+        header.shardCount = SHARD_COUNT;
+        header.shardSlots = shardSlots;
+        header.identity = identity;
+    }
+
+    Shard& shardFor(uint64_t hash) {
+        // the slot comes from the low bits, so the shard comes from the high ones
+        return shards[hash >> (64 - SHARD_COUNT_LOG_2)];
+    }
+
+    // AvxBitArray::hash is a 32 bit hash of each half of the space side by side, and a few swaps from the end the
+    // upper half hardly changes, so on its own its high bits put almost everything in a few shards.
+    // a multiply carries every bit up into the high ones and the fold brings them back down for the slot
+    static uint64_t spread(uint64_t hash) {
+        hash *= 0x9E3779B97F4A7C15ULL;
+        return hash ^ (hash >> 29);
+    }
+
+    // the slot holding key, or the empty one where it would go
+    static Slot& probe(Shard& shard, const CompressedBitArray& key, uint64_t hash) {
+        const size_t mask = shard.size - 1;
+        size_t index = hash & mask;
+        while (shard.slots[index].used && shard.slots[index].key != key) index = (index + 1) & mask;
+        return shard.slots[index];
+    }
+
+    // the slot holding key, taking an empty one (and counting it) with initial in it if it isn't there yet.
+    // a shard which can't grow any more only takes an empty one for a success while there's more than one left
+    // (probing needs an empty one to stop at), past that it's replace, nullptr if that doesn't store it either
+    Slot* insert(Shard& shard, const CompressedBitArray& key, uint64_t hash, const ExploredSpace& initial, bool success) {
+        bool full = (shard.count + 1) * 100 > shard.size * MAX_LOAD_PERCENT;
+        if (full && mapped == nullptr && shard.size * 2 <= maxShardSlots) {
+            grow(shard);
+            full = false;
+        }
+        Slot& slot = probe(shard, key, hash);
+        if (slot.used) return &slot;
+        if (full && (!success || shard.count + 2 > shard.size)) return replace(shard, key, hash, initial, success);
+
+        slot.key = key;
+        slot.explored = initial;
+        // used last, so a search killed part way through never leaves a half written slot in a file
+        std::atomic_signal_fence(std::memory_order_release);
+        slot.used = true;
+        shard.count++;
+        shard.inserts++;
+        return &slot;
+    }
+
+    // key takes the place of the failure worth least in the REPLACE_WINDOW slots from where it would go. when that's on
+    // key's chain it takes the failure's slot, which is still used after, so every other chain through it is unchanged
+    // and the failure just isn't found. past the end of key's chain key goes in the empty slot ending it and the
+    // failure is removed, so the shard stays as full as it was. with only successes there, which the network is
+    // rebuilt from, a failure is dropped. a success is too, only if the shard is a file with nothing but successes
+    Slot* replace(Shard& shard, const CompressedBitArray& key, uint64_t hash, const ExploredSpace& initial, bool success) {
+        const size_t mask = shard.size - 1;
+        Slot* end = nullptr;
+        size_t victim = 0;
+        bool found = false;
+        for (int k = 0; k < REPLACE_WINDOW; k++) {
+            const size_t index = (hash + k) & mask;
+            const Slot& slot = shard.slots[index];
+            if (!slot.used) {
+                if (end == nullptr) end = &shard.slots[index];
+                continue;
+            }
+            if (!slot.explored.success && (!found || slot.explored.height < shard.slots[victim].explored.height)) {
+                victim = index;
+                found = true;
+            }
+        }
+        if (!found && success) return keepSuccess(shard, key, hash, initial);
+        if (!found) {
+            shard.dropped++;
+            return nullptr;
+        }
+
+        const bool onChain = end == nullptr || ((victim - hash) & mask) < (size_t)((end - shard.slots - hash) & mask);
+        Slot* slot = onChain ? &shard.slots[victim] : end;
+        // unused while it changes, a search killed part way through loses the chain past it rather than
+        // finding a half written slot
+        slot->used = false;
+        std::atomic_signal_fence(std::memory_order_release);
+        slot->key = key;
+        slot->explored = initial;
+        std::atomic_signal_fence(std::memory_order_release);
+        slot->used = true;
+        if (!onChain) remove(shard, victim);
+        shard.replaced++;
+        return slot;
+    }
+
+    // a success with no failure near where it goes takes the place of the first one further on, in memory a shard
+    // of nothing but successes grows past the budget for it. nullptr only for a file, where it can't
+    Slot* keepSuccess(Shard& shard, const CompressedBitArray& key, uint64_t hash, const ExploredSpace& initial) {
+        const size_t mask = shard.size - 1;
+        for (size_t k = REPLACE_WINDOW; k < shard.size; k++) {
+            const size_t index = (hash + k) & mask;
+            if (!shard.slots[index].used || shard.slots[index].explored.success) continue;
+            remove(shard, index);
+            Slot& slot = probe(shard, key, hash); // where key's chain ends now the failure's gone
+            slot.key = key;
+            slot.explored = initial;
+            std::atomic_signal_fence(std::memory_order_release);
+            slot.used = true;
+            shard.replaced++;
+            return &slot;
+        }
+        if (mapped != nullptr) {
+            shard.dropped++;
+            return nullptr;
+        }
+        grow(shard);
+        return insert(shard, key, hash, initial, true); // half full now
+    }
+
+    // empties slot index, moving back whatever after it would no longer be found with a gap in its chain
+    // (Knuth's algorithm R for linear probing). a search killed part way through has at worst a space in two slots
+    static void remove(Shard& shard, size_t index) {
+        const size_t mask = shard.size - 1;
+        CompressedBitArrayHasher hasher;
+        shard.slots[index].used = false;
+        for (size_t next = (index + 1) & mask; shard.slots[next].used; next = (next + 1) & mask) {
+            const size_t home = spread(hasher(shard.slots[next].key)) & mask;
+            // next can fill the gap unless its chain starts after the gap, on the way to next
+            if (((next - home) & mask) < ((next - index) & mask)) continue;
+            Slot& gap = shard.slots[index];
+            gap.key = shard.slots[next].key;
+            gap.explored = shard.slots[next].explored;
+            std::atomic_signal_fence(std::memory_order_release);
+            gap.used = true;
+            std::atomic_signal_fence(std::memory_order_release);
+            shard.slots[next].used = false;
+            index = next;
+        }
+    }
+
+    static void grow(Shard& shard) {
+        std::vector<Slot> old(shard.size * 2);
+        old.swap(shard.owned);
+        shard.slots = shard.owned.data();
+        shard.size = shard.owned.size();
+        CompressedBitArrayHasher hasher;
+        for (const Slot& slot : old) {
+            if (slot.used) probe(shard, slot.key, spread(hasher(slot.key))) = slot;
+        }
+    }
+};
@@ -25,15 +25,20 @@ public:
 	struct Data {
 		CHUNK_DTYPE* chunks;
 		uint32_t size;
-		const uint32_t zeros = 0; // used to check Data vs Findable
 	};
 
-	union Lazy {
-		Data data; // contains actualy GroupedBitArray data
-		Findable findable; // contains only enough data to find GroupedBitArray in a map, and to create it when required
+	// which half of the union is in use is kept next to it, anything inside it would overlap findable's pointer
+	struct Lazy {
+		bool hasData = false;
+		union {
+			Data data; // contains actualy GroupedBitArray data
+			Findable findable; // contains only enough data to find GroupedBitArray in a map, and to create it when required
+		};
+
+		Lazy(): findable() {}
 
 		bool instantiated() const {
-			return data.zeros == 0;
+			return hasData;
 		}
 	};
 
@@ -1,31 +1,36 @@
 #include "net_finder.h"
+#include <stdlib.h>
 #include <iostream>
+#include <thread>
 
-#include "grouped_bit_array.h"
+#include "../utility/life_rule.h"
 
 using namespace std;
 
-#define IS_ALLOWED conwayAllowed
+#define IS_ALLOWED ruleAllowed
 
-bool conwayAllowed(bool* neighbors) {
+// the rule the network is searched for, the first argument in B/S notation, Conway by default
+LifeRule rule = CONWAY;
+
+bool ruleAllowed(bool* neighbors) {
     int neighborCount = 0;
     for (int i = 0; i < 8; i++) {
         if (neighbors[i]) neighborCount++;
     }
 
     for (int state = 0; state < 2; state++) {
-        // get state according to robust conways rules
-        bool wantedState = false;
-        if (state == 1 && neighborCount >= 2 && neighborCount <= 3) {
-            wantedState = true;
-        } else if (neighborCount == 3) {
-            wantedState = true;
-        }
+        bool wantedState = rule.next(state, neighborCount);
 
-        // get bit magic result for this set of neighbors
-        bool gte2_lte3 = neighbors[0] && neighbors[1] && !neighbors[3];
-		bool eq3 = neighbors[2] && !neighbors[3];
-		bool newState = eq3 || (gte2_lte3 && state);
+        // the same logic the kernels use, output k is taken as "more than k neighbors",
+        // so exactly k neighbors is output k-1 set and output k clear
+        uint16_t mask = state ? rule.survival : rule.birth;
+        bool newState = false;
+        for (int k = 0; k <= 8; k++) {
+            if (!((mask >> k) & 1)) continue;
+            bool atLeast = k == 0 || neighbors[k-1];
+            bool atMost = k == 8 || !neighbors[k];
+            newState = newState || (atLeast && atMost);
+        }
 
         // fail out if bit magic result doesn't match correct result
         if (newState != wantedState) return false;
@@ -35,11 +40,20 @@ bool conwayAllowed(bool* neighbors) {
 }
 
 int main(int argc, char *argv[]) {
-    std::cout << "GroupedBitArray: " << sizeof(GroupedBitArray) << std::endl;
-    std::cout << "AvxBitArray: " << sizeof(AvxBitArray) << std::endl;
-    std::cout << "__m256i: " << sizeof(__m256i) << std::endl;
-
-    return 0;
+    if (argc > 1) {
+        std::string error;
+        if (!LifeRule::parse(argv[1], rule, error)) {
+            cout << error << endl;
+            return 1;
+        }
+    }
+    // the second argument is how many threads search, all of them by default
+    int threadCount = argc > 2 ? atoi(argv[2]) : std::thread::hardware_concurrency();
+    cout << "Rule: " << rule.toString() << ", " << threadCount << " threads" << endl;
+    // the third is a file to keep the explored spaces in, carried on from if it's there, - for memory,
+    // and the fourth how many MB they can take either way
+    std::string tablePath = argc > 3 && std::string(argv[3]) != "-" ? argv[3] : "";
+    uint64_t tableMegabytes = argc > 4 ? atoll(argv[4]) : 4096;
 
     AvxBitArray allowedOutputSpace;
     bool neighbors[NEIGHBOR_COUNT];
@@ -70,7 +84,18 @@ int main(int argc, char *argv[]) {
     // correctSwaps.push_back(Swap(5, 6));
 
     MaskFactory maskFactory;
-    NetFinder finder(correctSwaps, 17, &maskFactory, ~allowedOutputSpace);
+    NetFinder finder(correctSwaps, 17, &maskFactory, ~allowedOutputSpace, threadCount);
+    if (!tablePath.empty()) {
+        std::string error;
+        if (!finder.useTableFile(tablePath, tableMegabytes << 20, error)) {
+            cout << error << endl;
+            return 1;
+        }
+        cout << "Explored spaces in " << tablePath << ", " << finder.exploredCount() << " from earlier searches" << endl;
+    } else {
+        finder.setMemoryBudget(tableMegabytes << 20);
+    }
+    cout << "Allowed outputs are " << (finder.isSymmetric() ? "" : "not ") << "their own mirror image" << endl;
     std::vector<Swap> gotSwaps = finder.findBest();
 
     cout << "Height: " << gotSwaps.size() << endl;
@@ -34,12 +34,13 @@ public:
         }
     }
 
-    const AvxBitArray& maskForPair(int i, int j) {
-        return pairMasks[index(i, j)];
+    // const, and at() rather than [], so any number of search threads can read the masks at once
+    const AvxBitArray& maskForPair(int i, int j) const {
+        return pairMasks.at(index(i, j));
     }
 
-    const AvxBitArray& invertedMaskForPair(int i, int j) {
-        return invertedPairMasks[index(i, j)];
+    const AvxBitArray& invertedMaskForPair(int i, int j) const {
+        return invertedPairMasks.at(index(i, j));
     }
 
 private:
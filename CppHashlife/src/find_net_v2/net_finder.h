@@ -1,4 +1,8 @@
 #pragma once
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 #include <iostream>
@@ -11,33 +15,25 @@
 #ifdef WINDOWS
     #include "windows.h"
     #include "psapi.h"
+#elif defined(__linux__)
+    #include <stdio.h>
+    #include <unistd.h>
 #endif
 
 #include "constants.h"
 #include "avx_bit_array.h"
-#include "compressed_bit_array.h"
-#include "bit_array_compressor.h"
+#include "explored_table.h"
 #include "mask_factory.h"
 #include "utility.h"
+#include "../utility/thread_pool.h"
 
 #define LOGGING
 
-struct Swap {
-    uint8_t i;
-    uint8_t j;
-
-    Swap(): Swap(0, 0) {}
-    Swap(int i, int j): i(i), j(j) {}
-};
-
-struct ExploredSpace {
-    Swap swap;
-    uint8_t height;
-    bool success = false;
-};
-
 const int totalPairs = (NEIGHBOR_COUNT - 1) * NEIGHBOR_COUNT / 2;
-double pairPercent = 1.0 / (double)totalPairs;
+
+// the top TASK_LEVELS swaps after the start swaps are tried up front, each subtree under them is a task,
+// a few hundred of them so threads which finish early have something left to take
+const int TASK_LEVELS = 2;
 
 class NetFinder {
 private:
@@ -45,53 +41,173 @@ private:
     int totalMaxSwaps;
     MaskFactory* maskFactory;
     AvxBitArray disallowedOutputSpace;
-    AvxBitArray tempMemory;
-    std::vector<AvxBitArray> stackTempMemory;
+    ThreadPool pool;
+
+    ExploredTable exploredOutputSpaces;
+    // the most swaps a network can have and still be worth finding, lowered by whichever thread finds one first
+    // so every other thread stops looking for anything longer
+    std::atomic<int> sharedMaxSwaps;
+
+    // with the allowed space its own mirror image (see mirror) a space and its mirror image take the same number
+    // of swaps, so they're stored as one, whichever of the two is lower
+    bool symmetric;
+    bool symmetryReduction = true;
+
+    // swaps on four different wires give the same space in either order. once a swap has been tried from a space,
+    // trying it again further down, after swaps it commutes with, only gets to spaces the first try already got to,
+    // so it's left asleep until a swap sharing a wire with it wakes it up. these are by pair, in the order they're
+    // tried, and commutingPairs[p] are the pairs sharing no wire with pair p
+    bool partialOrderReduction = true;
+    uint32_t commutingPairs[totalPairs];
+    std::atomic<uint64_t> nodeCount;
+
+    // the fewest swaps one network needs to make both of two outputs allowed, worked out for every pair of outputs
+    // up front (the same output twice is that output on its own). a space needs at least as many swaps as its worst
+    // pair, whatever else is in it. needMore[left][x] are the outputs which can't be made allowed along with x in
+    // left swaps, up to the most any pair that can be done needs, the level past that is the pairs no swaps will do
+    static const int UNFIXABLE_SWAPS = 1000;
+    bool lowerBounds = true;
+    int maxPairSwaps;
+    bool anyUnfixable;
+    std::vector<std::array<AvxBitArray, OUTPUT_SPACE_SIZE>> needMore;
+
+    // search for a network of every length in turn from the lower bound up, instead of taking the first one found
+    // and looking for something shorter. nothing longer than the best is ever searched, the spaces which failed
+    // on one length are in the table for the next
+    bool iterativeDeepening = false;
+
+    struct Task {
+        std::vector<Swap> swaps; // the start swaps, then the ones this task starts from
+        AvxBitArray outputSpace;
+    };
+    std::vector<Task> tasks;
+    std::atomic<int> tasksDone;
+
+    // what the table had done at the last progress report, for its rates since then
+    std::mutex logMutex;
+    std::chrono::steady_clock::time_point lastLogTime;
+    ExploredTable::Stats lastLogStats;
 
 public:
-    NetFinder(std::vector<Swap> startSwaps, int totalMaxSwaps, MaskFactory* maskFactory, AvxBitArray disallowedOutputSpace) {
+    NetFinder(std::vector<Swap> startSwaps, int totalMaxSwaps, MaskFactory* maskFactory, AvxBitArray disallowedOutputSpace,
+            int threadCount = 1): pool(std::max(1, threadCount)) {
         this->startSwaps = startSwaps;
         this->totalMaxSwaps = totalMaxSwaps;
         this->maskFactory = maskFactory;
         this->disallowedOutputSpace = disallowedOutputSpace;
-    }
+        symmetric = mirror(disallowedOutputSpace) == disallowedOutputSpace;
 
-    std::vector<Swap> findBest() {
-        for (int i = 0; i < totalMaxSwaps; i++) {
-            AvxBitArray a;
-            stackTempMemory.push_back(a);
+        std::vector<Swap> pairs;
+        for (int i = 0; i < NEIGHBOR_COUNT - 1; i++) {
+            for (int j = i + 1; j < NEIGHBOR_COUNT; j++) pairs.push_back(Swap(i, j));
+        }
+        for (int p = 0; p < totalPairs; p++) {
+            commutingPairs[p] = 0;
+            for (int q = 0; q < totalPairs; q++) {
+                bool disjoint = pairs[p].i != pairs[q].i && pairs[p].i != pairs[q].j && pairs[p].j != pairs[q].i && pairs[p].j != pairs[q].j;
+                if (disjoint) commutingPairs[p] |= 1u << q;
+            }
         }
 
-        uint64_t iterCount = 0;
-        std::vector<Swap> swaps;
-        BitArrayCompressor compressor;
-        std::unordered_map<CompressedBitArray, ExploredSpace, CompressedBitArrayHasher> exploredOutputSpaces;
+        makePairBounds();
+    }
+
+    // on by default, it only does anything when the allowed space is its own mirror image
+    void setSymmetryReduction(bool enabled) {
+        symmetryReduction = enabled;
+    }
+
+    bool isSymmetric() const {
+        return symmetric;
+    }
+
+    // on by default
+    void setPartialOrderReduction(bool enabled) {
+        partialOrderReduction = enabled;
+    }
+
+    // on by default
+    void setLowerBounds(bool enabled) {
+        lowerBounds = enabled;
+    }
+
+    // off by default, see iterativeDeepening
+    void setIterativeDeepening(bool enabled) {
+        iterativeDeepening = enabled;
+    }
+
+    // keeps the explored spaces in a file of about bytes (see ExploredTable::mapFile) instead of memory, so a search for the same
+    // allowed outputs with any start swaps or bound, or one which was interrupted, starts from everything earlier
+    // ones found. after the set* methods, mirror images being stored as one or not changes what's in the file
+    bool useTableFile(const std::string& path, uint64_t bytes, std::string& error) {
+        uint64_t identity = disallowedOutputSpace.hash() + (symmetric && symmetryReduction);
+        return exploredOutputSpaces.mapFile(path, bytes, identity, error);
+    }
+
+    // the most the explored spaces can take in memory, see ExploredTable::setMemoryBudget, unlimited by default
+    void setMemoryBudget(uint64_t bytes) {
+        exploredOutputSpaces.setMemoryBudget(bytes);
+    }
+
+    ExploredTable::Stats tableStats() {
+        return exploredOutputSpaces.stats();
+    }
+
+    size_t exploredCount() {
+        return exploredOutputSpaces.size();
+    }
+
+    // calls to findSwaps in the last findBest, over every length tried
+    uint64_t getNodeCount() const {
+        return nodeCount;
+    }
+
+    std::vector<Swap> findBest() {
         AvxBitArray outputSpace;
         for (int i = 0; i < startSwaps.size(); i++) {
-            Swap swap(startSwaps[i].i, startSwaps[i].j);
-            compareSwap(outputSpace, swap.i, swap.j);
-            swaps.push_back(swap);
+            compareSwap(outputSpace, startSwaps[i].i, startSwaps[i].j);
         }
-        for (int i = startSwaps.size(); i < totalMaxSwaps; i++) {
-            Swap a;
-            swaps.push_back(a);
+
+        // one thread searches the whole tree as a single task, the same order as splitting it would
+        tasks.clear();
+        int taskLevels = pool.size() == 1 ? 0 : std::max(0, std::min(TASK_LEVELS, totalMaxSwaps - (int)startSwaps.size()));
+        makeTasks(outputSpace, startSwaps, taskLevels, 0);
+
+        nodeCount = 0;
+        lastLogTime = std::chrono::steady_clock::now();
+        lastLogStats = exploredOutputSpaces.stats();
+        std::vector<ExploredSpace> found(tasks.size());
+        int maxSwaps = iterativeDeepening ? (int)startSwaps.size() + lowerBound(outputSpace) : totalMaxSwaps;
+        for (; maxSwaps <= totalMaxSwaps; maxSwaps++) {
+            if (runTasks(maxSwaps, found)) break;
         }
 
-        ExploredSpace best = findSwaps(outputSpace, swaps, startSwaps.size(), exploredOutputSpaces, iterCount, totalMaxSwaps, compressor);
-        std::vector<Swap> goodSwaps;
-        for (int i = 0; i < startSwaps.size(); i++) {
-            goodSwaps.push_back(startSwaps[i]);
+        // the shortest, the first task in search order if there's a tie
+        int best = -1;
+        for (int t = 0; t < tasks.size(); t++) {
+            if (!found[t].success) continue;
+            if (best < 0 || tasks[t].swaps.size() + found[t].height < tasks[best].swaps.size() + found[best].height) best = t;
         }
+        if (best < 0) return startSwaps;
 
-        while (best.success && best.height > 0) {
-            goodSwaps.push_back(best.swap);
-            compareSwap(outputSpace, best.swap.i, best.swap.j);
-            if (isAllowed(outputSpace)) {
-                break;
-            } else {
-                best = exploredOutputSpaces[compressor.findable(outputSpace)];
-            }
+        // each swap after the task's is the success stored for the space before it, which findSwaps finds straight away.
+        // a table file with a full shard of successes might not have kept one, then findSwaps searches for the rest
+        // again, it's known to fit in what's left
+        std::vector<Swap> goodSwaps = tasks[best].swaps;
+        outputSpace = tasks[best].outputSpace;
+        ExploredSpace explored = found[best];
+        const int length = goodSwaps.size() + explored.height;
+        sharedMaxSwaps = length;
+        std::vector<Swap> swaps(goodSwaps);
+        swaps.resize(std::max(totalMaxSwaps, length));
+        uint64_t iterCount = 0;
+        while (explored.success && explored.height > 0) {
+            swaps[goodSwaps.size()] = explored.swap;
+            goodSwaps.push_back(explored.swap);
+            compareSwap(outputSpace, explored.swap.i, explored.swap.j);
+            explored = findSwaps(outputSpace, swaps, goodSwaps.size(), iterCount, length, 0);
         }
+        nodeCount += iterCount;
 
         return goodSwaps;
     }
@@ -108,58 +224,198 @@ public:
         std::cout << std::endl;
     }
 
+private:
+    // every task searched for a network of at most maxSwaps, true if any of them found one
+    bool runTasks(int maxSwaps, std::vector<ExploredSpace>& found) {
+        sharedMaxSwaps = maxSwaps;
+        tasksDone = 0;
+        pool.run(tasks.size(), [this, &found](int t, int thread) {
+            std::vector<Swap> swaps = tasks[t].swaps;
+            swaps.resize(std::max(totalMaxSwaps, (int)swaps.size()));
+            uint64_t iterCount = 0;
+            found[t] = findSwaps(tasks[t].outputSpace, swaps, tasks[t].swaps.size(), iterCount, sharedMaxSwaps, 0);
+            nodeCount += iterCount;
+            tasksDone++;
+        });
+        for (const ExploredSpace& explored : found) {
+            if (explored.success) return true;
+        }
+        return false;
+    }
+
+    // every output space levels swaps below this one, pruned the way findSwaps prunes, stopping early at a space
+    // which is already allowed. a task starts with nothing asleep, the tasks before it may not have run yet, so the
+    // sleeping swaps here only drop tasks which start from the same space as an earlier one
+    void makeTasks(const AvxBitArray& outputSpace, std::vector<Swap>& swaps, int levels, uint32_t sleeping) {
+        if (levels == 0 || isAllowed(outputSpace)) {
+            tasks.push_back({ swaps, outputSpace });
+            return;
+        }
+        int pair = 0;
+        for (uint8_t i = 0; i < NEIGHBOR_COUNT - 1; i++) {
+            for (uint8_t j = i + 1; j < NEIGHBOR_COUNT; j++, pair++) {
+                bool mightChange = (swaps.empty() || !(i == swaps.back().i && j == swaps.back().j));
+                if (mightChange && !((sleeping >> pair) & 1) && willChange(outputSpace, i, j)) {
+                    AvxBitArray newOutputSpace = outputSpace;
+                    compareSwap(newOutputSpace, i, j);
+                    swaps.push_back(Swap(i, j));
+                    makeTasks(newOutputSpace, swaps, levels - 1, childSleeping(sleeping, pair));
+                    swaps.pop_back();
+                }
+            }
+        }
+    }
+
+    // what's asleep after pair: whatever was, and every pair tried before it here, as long as it commutes with pair
+    uint32_t childSleeping(uint32_t sleeping, int pair) const {
+        if (!partialOrderReduction) return 0;
+        return (sleeping | ((1u << pair) - 1)) & commutingPairs[pair];
+    }
+
+    void logProgress() {
+        std::lock_guard<std::mutex> lock(logMutex);
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::max(1e-9, std::chrono::duration<double>(now - lastLogTime).count());
+        ExploredTable::Stats stats = exploredOutputSpaces.stats();
+        std::cout << "Finished " << tasksDone << " of " << tasks.size() << " tasks, looking for at most ";
+        std::cout << sharedMaxSwaps << " swaps" << std::endl;
+        std::cout << "exploredOutputSpaces length = " << stats.entries << ", " << (double)stats.bytes / std::max<uint64_t>(1, stats.entries);
+        std::cout << " bytes/entry, " << (uint64_t)((stats.lookups - lastLogStats.lookups) / seconds) << " lookups/s, ";
+        std::cout << (uint64_t)((stats.inserts - lastLogStats.inserts) / seconds) << " inserts/s" << std::endl;
+        std::cout << "table " << (stats.bytes >> 20) << " mb";
+        if (exploredOutputSpaces.isBounded()) {
+            std::cout << ", " << stats.entries * 100 / stats.capacity << "% of all the slots it can have used, ";
+            std::cout << (uint64_t)((stats.replaced - lastLogStats.replaced) / seconds) << " replaced/s, ";
+            std::cout << (uint64_t)((stats.dropped - lastLogStats.dropped) / seconds) << " dropped/s";
+        }
+        std::cout << std::endl;
+        uint64_t memory = usedMemory();
+        if (memory > 0) std::cout << "Currently used memory: " << (memory / 1000000) << " mb" << std::endl;
+        std::cout << std::endl;
+        lastLogTime = now;
+        lastLogStats = stats;
+    }
+
+    // private bytes on Windows, the resident set on Linux, 0 anywhere else
+    static uint64_t usedMemory() {
+        #ifdef WINDOWS
+            PROCESS_MEMORY_COUNTERS_EX pmc;
+            GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&pmc, sizeof(pmc));
+            return pmc.PrivateUsage;
+        #elif defined(__linux__)
+            unsigned long long pages = 0;
+            unsigned long long resident = 0;
+            FILE* statm = fopen("/proc/self/statm", "r");
+            if (statm == nullptr) return 0;
+            if (fscanf(statm, "%llu %llu", &pages, &resident) != 2) resident = 0;
+            fclose(statm);
+            return resident * sysconf(_SC_PAGESIZE);
+        #else
+            return 0;
+        #endif
+    }
+
+    // every pair's fewest swaps, from the pairs which are both allowed outwards: a swap turns a pair into another
+    // pair, and a pair needs one more swap than the best pair it can be turned into. swaps only ever lower an output,
+    // so going through the outputs in order usually has it settled in a pass or two
+    void makePairBounds() {
+        const uint8_t UNKNOWN = 255;
+        std::vector<uint8_t> pairSwaps(OUTPUT_SPACE_SIZE * OUTPUT_SPACE_SIZE);
+        for (int a = 0; a < OUTPUT_SPACE_SIZE; a++) {
+            for (int b = 0; b < OUTPUT_SPACE_SIZE; b++) {
+                bool allowed = !disallowedOutputSpace.get(a) && !disallowedOutputSpace.get(b);
+                pairSwaps[a * OUTPUT_SPACE_SIZE + b] = allowed ? 0 : UNKNOWN;
+            }
+        }
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int a = 0; a < OUTPUT_SPACE_SIZE; a++) {
+                for (int b = a; b < OUTPUT_SPACE_SIZE; b++) {
+                    int best = pairSwaps[a * OUTPUT_SPACE_SIZE + b];
+                    for (int i = 0; i < NEIGHBOR_COUNT - 1; i++) {
+                        for (int j = i + 1; j < NEIGHBOR_COUNT; j++) {
+                            int a2 = swapOutput(a, i, j);
+                            int b2 = swapOutput(b, i, j);
+                            int next = pairSwaps[a2 * OUTPUT_SPACE_SIZE + b2];
+                            if ((a2 != a || b2 != b) && next != UNKNOWN) best = std::min(best, next + 1);
+                        }
+                    }
+                    if (best < pairSwaps[a * OUTPUT_SPACE_SIZE + b]) {
+                        pairSwaps[a * OUTPUT_SPACE_SIZE + b] = pairSwaps[b * OUTPUT_SPACE_SIZE + a] = best;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        maxPairSwaps = 0;
+        anyUnfixable = false;
+        for (uint8_t swaps : pairSwaps) {
+            if (swaps == UNKNOWN) anyUnfixable = true;
+            else maxPairSwaps = std::max(maxPairSwaps, (int)swaps);
+        }
+        needMore.resize(maxPairSwaps + 1);
+        for (int left = 0; left <= maxPairSwaps; left++) {
+            for (int a = 0; a < OUTPUT_SPACE_SIZE; a++) {
+                needMore[left][a].zero();
+                for (int b = 0; b < OUTPUT_SPACE_SIZE; b++) {
+                    needMore[left][a].set(b, pairSwaps[a * OUTPUT_SPACE_SIZE + b] > left);
+                }
+            }
+        }
+    }
+
+    // output after swap (i, j)
+    static int swapOutput(int output, int i, int j) {
+        bool swapped = !((output >> i) & 1) && ((output >> j) & 1);
+        return swapped ? output ^ ((1 << i) | (1 << j)) : output;
+    }
+
+    // a network of totalSwaps has been found, nothing longer is worth looking for any more
+    void lowerMaxSwaps(int totalSwaps) {
+        int current = sharedMaxSwaps.load(std::memory_order_relaxed);
+        while (totalSwaps < current && !sharedMaxSwaps.compare_exchange_weak(current, totalSwaps, std::memory_order_relaxed)) {}
+    }
+
 public:
     ExploredSpace findSwaps(
         const AvxBitArray& outputSpace,
         std::vector<Swap>& swaps, // for logging only
         int swapsCount,
-        std::unordered_map<CompressedBitArray, ExploredSpace, CompressedBitArrayHasher>& exploredOutputSpaces,
         uint64_t& iterCount,
         int maxSwaps,
-        BitArrayCompressor& compressor
+        uint32_t sleeping // pairs not worth trying from here, see partialOrderReduction
     ) {
         iterCount++;
         #ifdef LOGGING
-            if (iterCount >= 5000000) {
-                iterCount = 0;
-                uint64_t exploredCount = 0;
-                double percentDone = 0;
-                for (size_t k = startSwaps.size(); k < swapsCount; k++) {
-                    uint64_t donePairs = totalPairs - remainingPairs(swaps[k].i, swaps[k].j);
-                    percentDone += (double)donePairs * (pow(pairPercent, k - startSwaps.size() + 1));
-                    exploredCount += donePairs * nodesInTree(NEIGHBOR_COUNT, totalMaxSwaps - k - 1);
-                }
-                
-                percentDone = round(percentDone * 100.0 * 10000.0) / 10000.0;
-                std::cout << "Explored " << exploredCount << " (" << percentDone << "%)" << std::endl;
-                std::cout << "exploredOutputSpaces length = " << exploredOutputSpaces.size() << std::endl;
-                #ifdef WINDOWS
-                    PROCESS_MEMORY_COUNTERS_EX pmc;
-                    GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&pmc, sizeof(pmc));
-                    std::cout << "Currently used memory: " << (pmc.PrivateUsage / 1000000) << " mb" << std::endl << std::endl;
-                #endif
-                std::cout << std::endl;
-            }
+            if (iterCount % 5000000 == 0) logProgress();
         #endif
 
         ExploredSpace exploredOut;
-        if (swapsCount > maxSwaps) {
+        maxSwaps = std::min(maxSwaps, sharedMaxSwaps.load(std::memory_order_relaxed));
+        if (swapsCount > maxSwaps || cantFinishIn(outputSpace, maxSwaps - swapsCount)) {
             return exploredOut;
         }
 
-        const CompressedBitArray findable = compressor.findable(outputSpace);
-        auto exploredIt = exploredOutputSpaces.find(findable);
-        if (exploredIt != exploredOutputSpaces.end()) {
-            ExploredSpace explored = exploredIt->second;
+        bool mirrored;
+        const AvxBitArray key = canonical(outputSpace, mirrored);
+        ExploredSpace explored;
+        if (exploredOutputSpaces.find(key, explored)) {
             // fail if:
 			// we find a success (which is best possible) which will take too many swaps OR
 			// we find a failure which took as many (or more) swaps as we have time for, therefore we cannot find a success for this state
             bool failed = (explored.success && swapsCount + explored.height > maxSwaps) || (!explored.success && explored.height >= maxSwaps - swapsCount);
             if (failed) return exploredOut;
-            if (explored.success) return explored; // successes in explored_output_spaces are always best possible, so exit immediately
+            if (explored.success) {
+                lowerMaxSwaps(swapsCount + explored.height);
+                if (mirrored) explored.swap = mirrorSwap(explored.swap);
+                return explored; // successes in explored_output_spaces are always best possible, so exit immediately
+            }
         }
 
         if (isAllowed(outputSpace)) {
+            lowerMaxSwaps(swapsCount);
             exploredOut.success = true;
             exploredOut.height = 0;
             return exploredOut;
@@ -167,19 +423,27 @@ public:
 
         if (swapsCount == maxSwaps) return exploredOut;
 
+        // maxSwaps only comes down from other threads, anything found here lowers childMaxSwaps instead, to look for
+        // something shorter. once another thread has beaten what's been found here (so maxSwaps is below it)
+        // it isn't stored as the best this space can do, it might not be.
+        // a sleeping swap still doesn't make what's stored wrong: it was tried from a space above this one with at
+        // least as many swaps left, and anything it leads to from here is as many swaps further on from there,
+        // so it can't beat what was found there, or fit in what's left here when nothing was
         ExploredSpace found;
+        int pair = 0;
         for (uint8_t i = 0; i < NEIGHBOR_COUNT - 1; i++) {
-            for (uint8_t j = i + 1; j < NEIGHBOR_COUNT; j++) {
+            for (uint8_t j = i + 1; j < NEIGHBOR_COUNT; j++, pair++) {
                 bool mightChange = (swapsCount == 0 || !(i == swaps[swapsCount-1].i && j == swaps[swapsCount-1].j));
-                if (mightChange && willChange(outputSpace, i, j)) {
-                    AvxBitArray newOutputSpace = stackTempMemory[swapsCount];
-                    newOutputSpace.setAll(outputSpace);
+                if (mightChange && !((sleeping >> pair) & 1) && willChange(outputSpace, i, j)) {
+                    maxSwaps = std::min(maxSwaps, sharedMaxSwaps.load(std::memory_order_relaxed));
+                    int childMaxSwaps = found.success ? std::min(maxSwaps, swapsCount + found.height - 1) : maxSwaps;
+                    AvxBitArray newOutputSpace = outputSpace;
                     compareSwap(newOutputSpace, i, j);
                     swaps[swapsCount].i = i;
                     swaps[swapsCount].j = j;
-                    ExploredSpace maybeFound = findSwaps(newOutputSpace, swaps, swapsCount + 1, exploredOutputSpaces, iterCount, maxSwaps, compressor);
+                    ExploredSpace maybeFound = findSwaps(newOutputSpace, swaps, swapsCount + 1, iterCount, childMaxSwaps,
+                        childSleeping(sleeping, pair));
                     if (maybeFound.success) {
-                        maxSwaps = swapsCount + maybeFound.height;
                         found.height = maybeFound.height + 1;
                         found.swap.i = i;
                         found.swap.j = j;
@@ -189,48 +453,104 @@ public:
             }
         }
 
-        if (found.success) {
-            exploredOutputSpaces[compressor.compress(outputSpace)] = found;
+        maxSwaps = std::min(maxSwaps, sharedMaxSwaps.load(std::memory_order_relaxed));
+        if (found.success && swapsCount + found.height <= maxSwaps) {
+            ExploredSpace stored = found;
+            if (mirrored) stored.swap = mirrorSwap(found.swap);
+            exploredOutputSpaces.putSuccess(key, stored);
             return found;
         }
-        
-        exploredIt = exploredOutputSpaces.find(findable);
-        if (exploredIt != exploredOutputSpaces.end()) {
-            if (exploredIt->second.height < maxSwaps - swapsCount) {
-                exploredIt->second.height = maxSwaps - swapsCount;
-            }
-        } else {
-            
-            exploredOutputSpaces[findable].height = maxSwaps - swapsCount;
-            exploredOutputSpaces[findable].success = false;
-        }
 
+        // every child was searched with at least this many swaps left, whatever was found took more
+        if (maxSwaps >= swapsCount) exploredOutputSpaces.putFailure(key, maxSwaps - swapsCount);
         return exploredOut;
     }
 
-    void compareSwap(AvxBitArray& outputSpace, uint8_t i, uint8_t j) {
+    void compareSwap(AvxBitArray& outputSpace, uint8_t i, uint8_t j) const {
         #ifdef DEBUG
             assert(i < j);
             assert(j < NEIGHBOR_COUNT);
         #endif
+        AvxBitArray selected(false);
         auto zeroOneMask = maskFactory->maskForPair(i, j);
-        outputSpace.and_out(zeroOneMask, tempMemory);// only select ..0..1.. indices
-        tempMemory <<= ((1 << j) - (1 << i)); // this shift is equivalent of swaping i and j for each index 
-        outputSpace |= tempMemory; // selected ..1..0.. outputs are now possible
+        outputSpace.and_out(zeroOneMask, selected);// only select ..0..1.. indices
+        selected <<= ((1 << j) - (1 << i)); // this shift is equivalent of swaping i and j for each index
+        outputSpace |= selected; // selected ..1..0.. outputs are now possible
         outputSpace &= maskFactory->invertedMaskForPair(i, j); // all ..0..1.. outputs are now impossible
     }
 
-    bool willChange(const AvxBitArray& outputSpace, uint8_t i, uint8_t j) {
+    bool willChange(const AvxBitArray& outputSpace, uint8_t i, uint8_t j) const {
         #ifdef DEBUG
             assert(i < j);
             assert(j < NEIGHBOR_COUNT);
         #endif
-        outputSpace.and_out(maskFactory->maskForPair(i, j), tempMemory);
-        return !tempMemory.none();
+        AvxBitArray selected(false);
+        outputSpace.and_out(maskFactory->maskForPair(i, j), selected);
+        return !selected.none();
     }
 
-    bool isAllowed(const AvxBitArray& outputSpace) {
-        outputSpace.and_out(disallowedOutputSpace, tempMemory);
-        return tempMemory.none();
+    // the network turned upside down and every wire inverted: wire k becomes wire NEIGHBOR_COUNT-1-k and
+    // each output has all its bits flipped. swap (i, j) of one does the same as swap (N-1-j, N-1-i) of the other,
+    // still lower wire first, so a space needs as many swaps as its mirror image needs to reach the mirror image of
+    // the allowed space. it's the only relabelling of the wires that keeps every swap the right way round,
+    // the board's rotations and reflections would need swaps which put the larger value on the lower wire
+    AvxBitArray mirror(const AvxBitArray& outputSpace) const {
+        AvxBitArray out = outputSpace;
+        out.reverseIndexBits(); // wire k is now wire NEIGHBOR_COUNT-1-k
+        out.reverse(); // output o moves to OUTPUT_SPACE_SIZE-1-o, all its bits flipped
+        return out;
     }
-};
\ No newline at end of file
+
+    static Swap mirrorSwap(Swap swap) {
+        return Swap(NEIGHBOR_COUNT - 1 - swap.j, NEIGHBOR_COUNT - 1 - swap.i);
+    }
+
+    // what outputSpace is stored as, mirrored is set if that's its mirror image
+    AvxBitArray canonical(const AvxBitArray& outputSpace, bool& mirrored) const {
+        mirrored = false;
+        if (!symmetric || !symmetryReduction) return outputSpace;
+        AvxBitArray mirrorImage = mirror(outputSpace);
+        alignas(32) uint64_t words[4];
+        alignas(32) uint64_t mirrorWords[4];
+        outputSpace.getAll(words);
+        mirrorImage.getAll(mirrorWords);
+        for (int w = 3; w >= 0; w--) {
+            if (words[w] != mirrorWords[w]) {
+                mirrored = mirrorWords[w] < words[w];
+                break;
+            }
+        }
+        return mirrored ? mirrorImage : outputSpace;
+    }
+
+    // no network from outputSpace is shorter than this, see needMore
+    int lowerBound(const AvxBitArray& outputSpace) const {
+        for (int left = 0; left <= maxPairSwaps; left++) {
+            if (!cantFinishIn(outputSpace, left)) return left;
+        }
+        return UNFIXABLE_SWAPS;
+    }
+
+    // some pair in outputSpace needs more than left swaps. far enough from the end that no pair needs that many,
+    // it's only pairs which can't be done at all, which there usually aren't
+    bool cantFinishIn(const AvxBitArray& outputSpace, int left) const {
+        if (!lowerBounds || (left >= maxPairSwaps && !anyUnfixable)) return false;
+        const std::array<AvxBitArray, OUTPUT_SPACE_SIZE>& outputsNeedMore = needMore[std::min(left, maxPairSwaps)];
+        alignas(32) uint64_t words[4];
+        outputSpace.getAll(words);
+        AvxBitArray selected(false);
+        for (int w = 0; w < 4; w++) {
+            for (uint64_t bits = words[w]; bits; bits &= bits - 1) {
+                outputSpace.and_out(outputsNeedMore[w * 64 + __builtin_ctzll(bits)], selected);
+                if (!selected.none()) return true;
+            }
+        }
+        return false;
+    }
+
+    bool isAllowed(const AvxBitArray& outputSpace) const {
+        AvxBitArray selected(false);
+        outputSpace.and_out(disallowedOutputSpace, selected);
+        return selected.none();
+    }
+};
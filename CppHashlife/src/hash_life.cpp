@@ -0,0 +1,585 @@
+#include "hash_life.h"
+#include <assert.h>
+#include <immintrin.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include <sstream>
+
+#include "utility/pattern_io.h"
+
+static uint64_t mix(uint64_t h) {
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static int log2Size(int size) {
+	int level = 0;
+	while ((1 << level) < size) {
+		level++;
+	}
+	return level;
+}
+
+HashLife::HashLife(int size, std::random_device& rd) :
+	eng(rd()), dist(0, 255), size(size), level(log2Size(size)),
+	buckets(1 << 16, nullptr), nodeCount(0), nodeLimit(DEFAULT_NODE_LIMIT), keptNodes(0),
+	root(nullptr), stepLog2(0), generation(0),
+	scratchRowLen(LEAF_SIZE*2/8+64), kernel(LifeKernel::best()), drawingRoot(nullptr), viewCells(nullptr)
+{
+	// build and save go through all 2^level rows of a size+2 row board, anything else reads and writes past it
+	assert(size >= BASE_SIZE && (size & (size-1)) == 0);
+	this->scratch = new uint8_t*[BASE_SIZE+2];
+	this->nextScratch = new uint8_t*[BASE_SIZE+2];
+	for (int i = 0; i < BASE_SIZE+2; i++) {
+		scratch[i] = (uint8_t*)_mm_malloc(sizeof(uint8_t)*scratchRowLen, 32);
+		nextScratch[i] = (uint8_t*)_mm_malloc(sizeof(uint8_t)*scratchRowLen, 32);
+		memset(scratch[i], 0, scratchRowLen);
+		memset(nextScratch[i], 0, scratchRowLen);
+	}
+}
+
+HashLife::~HashLife() {
+	for (size_t i = 0; i < buckets.size(); i++) {
+		Node* n = buckets[i];
+		while (n != nullptr) {
+			Node* next = n->next;
+			delete n;
+			n = next;
+		}
+	}
+
+	for (int i = 0; i < BASE_SIZE+2; i++) {
+		_mm_free(scratch[i]);
+		_mm_free(nextScratch[i]);
+	}
+	if (viewCells != nullptr) {
+		for (int i = 0; i < size+2; i++) {
+			delete[] viewCells[i];
+		}
+		delete[] viewCells;
+	}
+	delete[] scratch;
+	delete[] nextScratch;
+}
+
+void HashLife::setup() {
+	// draw into a flat board with the same layout as SIMDLife, then hash it into a tree
+	int rowLen = size/8+33;
+	uint8_t** cells = new uint8_t*[size+2];
+	for (int i = 0; i < size+2; i++) {
+		cells[i] = new uint8_t[rowLen];
+		memset(cells[i], 0, rowLen);
+		// for (int j = 32; j < rowLen-1; j++) cells[i][j] = (dist(eng) & dist(eng)) & 0xFF;
+	}
+
+	std::istringstream demo(DEMO_RLE);
+	PackedSink sink(cells, size, size, DEMO_ROW, DEMO_COLUMN);
+	PatternInfo info;
+	readRLE(demo, sink, info);
+
+	load(cells);
+
+	for (int i = 0; i < size+2; i++) {
+		delete[] cells[i];
+	}
+	delete[] cells;
+}
+
+void HashLife::load(uint8_t** cells) {
+	empty(level+1); // make sure draw never sees emptyNodes grow
+	Node* built = build(cells, level, 0, 0);
+
+	swapMutex.lock();
+	root = built;
+	generation = 0;
+	swapMutex.unlock();
+}
+
+void HashLife::tick() {
+	// everything outside of the board is dead, so the board is placed in the middle of an empty node twice its size
+	// the result of that is exactly the board again, moved forward in time
+	// (with big steps, cells which leave the board still affect it until the end of the step)
+	if (nodeCount > std::max(nodeLimit, 2*keptNodes)) collect();
+	Node* next = result(centered(root), stepLog2);
+
+	swapMutex.lock();
+	root = next;
+	generation += 1ULL << stepLog2;
+	swapMutex.unlock();
+}
+
+void HashLife::draw(char* pixelBuffer) {
+	swapMutex.lock();
+	Node* drawRoot = root;
+	drawingRoot = drawRoot;
+	swapMutex.unlock();
+
+	// collect keeps drawingRoot's nodes, so the tree can be walked without holding the lock
+	drawNode(drawRoot, 0, 0, pixelBuffer);
+
+	swapMutex.lock();
+	drawingRoot = nullptr;
+	swapMutex.unlock();
+}
+
+void HashLife::drawView(const Viewport& view, uint8_t* out, ViewImage& image) {
+	swapMutex.lock();
+	Node* drawRoot = root;
+	drawingRoot = drawRoot;
+	swapMutex.unlock();
+
+	if (viewCells == nullptr) {
+		viewCells = new uint8_t*[size+2];
+		for (int i = 0; i < size+2; i++) {
+			viewCells[i] = new uint8_t[size/8+33];
+			memset(viewCells[i], 0, size/8+33);
+		}
+	}
+
+	// only the nodes which can be seen are written out
+	int64_t visible = view.visibleCells(WINDOW_SIZE);
+	int top = (int)std::max<int64_t>(0, view.row);
+	int bottom = (int)std::min<int64_t>(size, view.row + visible);
+	int left = (int)std::max<int64_t>(0, view.column);
+	int right = (int)std::min<int64_t>(size, view.column + visible);
+	for (int i = top; i < bottom; i++) {
+		memset(viewCells[i+1], 0, size/8+33);
+	}
+	saveVisibleNode(drawRoot, 0, 0, top, bottom, left, right, viewCells);
+	swapMutex.lock();
+	drawingRoot = nullptr;
+	swapMutex.unlock();
+
+	renderView(viewCells, size, view, WINDOW_SIZE, out, image);
+}
+
+bool HashLife::getCell(int row, int column) const {
+	Node* n = root;
+	while (n->level > LEAF_LEVEL) {
+		int half = 1 << (n->level - 1);
+		n = n->children[(row >= half ? 2 : 0) + (column >= half ? 1 : 0)];
+		row %= half;
+		column %= half;
+	}
+	return (n->bits[row*2 + column/8] >> (7 - column%8)) & 1;
+}
+
+void HashLife::setCell(int row, int column, bool alive) {
+	Node* next = withCell(root, row, column, alive);
+
+	swapMutex.lock();
+	root = next;
+	swapMutex.unlock();
+}
+
+void HashLife::setRule(const LifeRule& rule) {
+	setKernel(LifeKernel::best(rule));
+}
+
+LifeRule HashLife::getRule() const {
+	return kernel->getRule();
+}
+
+void HashLife::setKernel(const LifeKernel* kernel) {
+	if (kernel->getRule() != this->kernel->getRule()) {
+		for (Node* bucket : buckets) {
+			for (Node* n = bucket; n != nullptr; n = n->next) {
+				n->result = nullptr;
+			}
+		}
+	}
+	this->kernel = kernel;
+}
+
+const LifeKernel* HashLife::getKernel() const {
+	return kernel;
+}
+
+void HashLife::save(uint8_t** cells) {
+	swapMutex.lock();
+	Node* saveRoot = root;
+	swapMutex.unlock();
+
+	for (int i = 0; i < size+2; i++) {
+		memset(cells[i], 0, size/8+33);
+	}
+	saveNode(saveRoot, 0, 0, cells);
+}
+
+void HashLife::setStepLog2(int stepLog2) {
+	this->stepLog2 = std::max(0, std::min(stepLog2, level-1));
+}
+
+int HashLife::getStepLog2() const {
+	return stepLog2;
+}
+
+uint64_t HashLife::getGeneration() const {
+	return generation;
+}
+
+uint64_t HashLife::getNodeCount() const {
+	return nodeCount;
+}
+
+void HashLife::setNodeLimit(uint64_t nodes) {
+	nodeLimit = nodes;
+}
+
+uint64_t HashLife::getNodeLimit() const {
+	return nodeLimit;
+}
+
+// mark and sweep, holding the lock so draw can't start on a root which isn't marked
+void HashLife::collect() {
+	std::lock_guard<std::mutex> lock(swapMutex);
+	for (Node* e : emptyNodes) {
+		if (e != nullptr) mark(e);
+	}
+	if (root != nullptr) mark(root);
+	if (drawingRoot != nullptr) mark(drawingRoot);
+
+	for (size_t i = 0; i < buckets.size(); i++) {
+		Node** link = &buckets[i];
+		while (*link != nullptr) {
+			Node* n = *link;
+			if (n->marked) {
+				n->marked = false;
+				link = &n->next;
+			} else {
+				*link = n->next;
+				delete n;
+				nodeCount--;
+			}
+		}
+	}
+	keptNodes = nodeCount;
+}
+
+// a marked node's children and result are marked already, leaves have bits instead of children
+void HashLife::mark(Node* n) {
+	if (n->marked) return;
+	n->marked = true;
+	if (n->level > LEAF_LEVEL) {
+		for (Node* child : n->children) mark(child);
+	}
+	if (n->result != nullptr) mark(n->result);
+}
+
+HashLife::Node* HashLife::leaf(const uint8_t* bits) {
+	const uint64_t* words = (const uint64_t*)bits;
+	uint64_t hash = mix(words[0]) ^ mix(words[1] + 1) ^ mix(words[2] + 2) ^ mix(words[3] + 3);
+
+	for (Node* n = buckets[hash & (buckets.size()-1)]; n != nullptr; n = n->next) {
+		if (n->hash == hash && n->level == LEAF_LEVEL && memcmp(n->bits, bits, 32) == 0) {
+			return n;
+		}
+	}
+
+	Node* n = new Node;
+	memcpy(n->bits, bits, 32);
+	n->result = nullptr;
+	n->hash = hash;
+	n->level = LEAF_LEVEL;
+	n->resultStep = 0;
+	n->marked = false;
+	insert(n);
+	return n;
+}
+
+HashLife::Node* HashLife::node(Node* nw, Node* ne, Node* sw, Node* se) {
+	uint64_t hash = mix((uint64_t)nw) ^ mix((uint64_t)ne + 1) ^ mix((uint64_t)sw + 2) ^ mix((uint64_t)se + 3);
+
+	for (Node* n = buckets[hash & (buckets.size()-1)]; n != nullptr; n = n->next) {
+		if (n->hash == hash && n->level == nw->level + 1 &&
+			n->children[0] == nw && n->children[1] == ne && n->children[2] == sw && n->children[3] == se
+		) {
+			return n;
+		}
+	}
+
+	Node* n = new Node;
+	n->children[0] = nw;
+	n->children[1] = ne;
+	n->children[2] = sw;
+	n->children[3] = se;
+	n->result = nullptr;
+	n->hash = hash;
+	n->level = nw->level + 1;
+	n->resultStep = 0;
+	n->marked = false;
+	insert(n);
+	return n;
+}
+
+HashLife::Node* HashLife::empty(int level) {
+	while ((int)emptyNodes.size() <= level) {
+		int l = emptyNodes.size();
+		if (l < LEAF_LEVEL) {
+			emptyNodes.push_back(nullptr); // no nodes smaller than a leaf
+		} else if (l == LEAF_LEVEL) {
+			alignas(32) uint8_t bits[32] = {0};
+			emptyNodes.push_back(leaf(bits));
+		} else {
+			Node* e = emptyNodes[l-1];
+			emptyNodes.push_back(node(e, e, e, e));
+		}
+	}
+	return emptyNodes[level];
+}
+
+void HashLife::insert(Node* n) {
+	if (nodeCount >= buckets.size()) {
+		grow();
+	}
+	uint64_t bucket = n->hash & (buckets.size()-1);
+	n->next = buckets[bucket];
+	buckets[bucket] = n;
+	nodeCount++;
+}
+
+void HashLife::grow() {
+	std::vector<Node*> newBuckets(buckets.size() * 2, nullptr);
+	for (size_t i = 0; i < buckets.size(); i++) {
+		Node* n = buckets[i];
+		while (n != nullptr) {
+			Node* next = n->next;
+			uint64_t bucket = n->hash & (newBuckets.size()-1);
+			n->next = newBuckets[bucket];
+			newBuckets[bucket] = n;
+			n = next;
+		}
+	}
+	buckets.swap(newBuckets);
+}
+
+HashLife::Node* HashLife::build(uint8_t** cells, int level, int row, int column) {
+	if (level == LEAF_LEVEL) {
+		alignas(32) uint8_t bits[32];
+		for (int i = 0; i < LEAF_SIZE; i++) {
+			bits[i*2  ] = cells[row+i+1][column/8+32];
+			bits[i*2+1] = cells[row+i+1][column/8+33];
+		}
+		return leaf(bits);
+	}
+
+	int half = 1 << (level-1);
+	return node(
+		build(cells, level-1, row, column),
+		build(cells, level-1, row, column+half),
+		build(cells, level-1, row+half, column),
+		build(cells, level-1, row+half, column+half)
+	);
+}
+
+HashLife::Node* HashLife::centered(Node* n) {
+	Node* e = empty(n->level-1);
+	return node(
+		node(e, e, e, n->children[0]),
+		node(e, e, n->children[1], e),
+		node(e, n->children[2], e, e),
+		node(n->children[3], e, e, e)
+	);
+}
+
+// the middle half of a node without moving forward in time
+HashLife::Node* HashLife::centerOf(Node* n) {
+	Node* nw = n->children[0];
+	Node* ne = n->children[1];
+	Node* sw = n->children[2];
+	Node* se = n->children[3];
+
+	if (n->level == BASE_LEVEL) {
+		alignas(32) uint8_t bits[32];
+		for (int i = 0; i < LEAF_SIZE/2; i++) {
+			bits[i*2  ] = nw->bits[(i+LEAF_SIZE/2)*2+1];
+			bits[i*2+1] = ne->bits[(i+LEAF_SIZE/2)*2  ];
+			bits[(i+LEAF_SIZE/2)*2  ] = sw->bits[i*2+1];
+			bits[(i+LEAF_SIZE/2)*2+1] = se->bits[i*2  ];
+		}
+		return leaf(bits);
+	}
+
+	return node(nw->children[3], ne->children[2], sw->children[1], se->children[0]);
+}
+
+// the middle half of a node, 2^step generations later
+// step is at most level-2, and for a given stepLog2 every node is only ever asked for one step, so one result is cached per node
+HashLife::Node* HashLife::result(Node* n, int step) {
+	if (n->result != nullptr && n->resultStep == step) {
+		return n->result;
+	}
+
+	Node* r;
+	if (n == empty(n->level)) {
+		r = empty(n->level-1);
+	} else if (n->level == BASE_LEVEL) {
+		r = baseResult(n, step);
+	} else {
+		Node* nw = n->children[0];
+		Node* ne = n->children[1];
+		Node* sw = n->children[2];
+		Node* se = n->children[3];
+
+		// 9 overlapping sub-squares, each half the size of n
+		Node* sub[9] = {
+			nw,
+			node(nw->children[1], ne->children[0], nw->children[3], ne->children[2]),
+			ne,
+			node(nw->children[2], nw->children[3], sw->children[0], sw->children[1]),
+			node(nw->children[3], ne->children[2], sw->children[1], se->children[0]),
+			node(ne->children[2], ne->children[3], se->children[0], se->children[1]),
+			sw,
+			node(sw->children[1], se->children[0], sw->children[3], se->children[2]),
+			se
+		};
+
+		// if the step is as big as possible, both halves of the step move forward in time
+		// otherwise only the second half does
+		bool fullStep = step == n->level-2;
+		int subStep = fullStep ? step-1 : step;
+		Node* c[9];
+		for (int i = 0; i < 9; i++) {
+			c[i] = fullStep ? result(sub[i], subStep) : centerOf(sub[i]);
+		}
+
+		r = node(
+			result(node(c[0], c[1], c[3], c[4]), subStep),
+			result(node(c[1], c[2], c[4], c[5]), subStep),
+			result(node(c[3], c[4], c[6], c[7]), subStep),
+			result(node(c[4], c[5], c[7], c[8]), subStep)
+		);
+	}
+
+	n->result = r;
+	n->resultStep = step;
+	return r;
+}
+
+// 32x32 cells is small enough to just run the AVX kernel on it directly
+HashLife::Node* HashLife::baseResult(Node* n, int step) {
+	const int half = LEAF_SIZE;
+	for (int i = 0; i < half; i++) {
+		memset(&scratch[i+1][32], 0, 32);
+		memset(&scratch[i+half+1][32], 0, 32);
+		scratch[i+1][32] = n->children[0]->bits[i*2];
+		scratch[i+1][33] = n->children[0]->bits[i*2+1];
+		scratch[i+1][34] = n->children[1]->bits[i*2];
+		scratch[i+1][35] = n->children[1]->bits[i*2+1];
+		scratch[i+half+1][32] = n->children[2]->bits[i*2];
+		scratch[i+half+1][33] = n->children[2]->bits[i*2+1];
+		scratch[i+half+1][34] = n->children[3]->bits[i*2];
+		scratch[i+half+1][35] = n->children[3]->bits[i*2+1];
+	}
+
+	// the edges of the 32x32 square are wrong after a few generations, but the middle 16x16 can't see them in time
+	for (int gen = 0; gen < (1 << step); gen++) {
+		for (int i = 1; i < BASE_SIZE+1; i++) {
+			kernel->nextWords(scratch, i, 32, 1, &nextScratch[i][32]);
+		}
+		std::swap(scratch, nextScratch);
+	}
+
+	alignas(32) uint8_t bits[32];
+	for (int i = 0; i < LEAF_SIZE; i++) {
+		bits[i*2  ] = scratch[i+LEAF_SIZE/2+1][33];
+		bits[i*2+1] = scratch[i+LEAF_SIZE/2+1][34];
+	}
+	return leaf(bits);
+}
+
+// nodes can't be changed in place, so every node on the path to the cell is rebuilt
+HashLife::Node* HashLife::withCell(Node* n, int row, int column, bool alive) {
+	if (n->level == LEAF_LEVEL) {
+		alignas(32) uint8_t bits[32];
+		memcpy(bits, n->bits, 32);
+		uint8_t bit = 0x80 >> (column%8);
+		if (alive) bits[row*2 + column/8] |= bit;
+		else bits[row*2 + column/8] &= ~bit;
+		return leaf(bits);
+	}
+
+	int half = 1 << (n->level - 1);
+	int quadrant = (row >= half ? 2 : 0) + (column >= half ? 1 : 0);
+	Node* children[4] = { n->children[0], n->children[1], n->children[2], n->children[3] };
+	children[quadrant] = withCell(children[quadrant], row % half, column % half, alive);
+	return node(children[0], children[1], children[2], children[3]);
+}
+
+void HashLife::saveNode(Node* n, int row, int column, uint8_t** cells) const {
+	if ((int)emptyNodes.size() > n->level && n == emptyNodes[n->level]) {
+		return;
+	}
+
+	if (n->level == LEAF_LEVEL) {
+		for (int i = 0; i < LEAF_SIZE; i++) {
+			cells[row+i+1][column/8+32] = n->bits[i*2];
+			cells[row+i+1][column/8+33] = n->bits[i*2+1];
+		}
+		return;
+	}
+
+	int half = 1 << (n->level - 1);
+	saveNode(n->children[0], row, column, cells);
+	saveNode(n->children[1], row, column+half, cells);
+	saveNode(n->children[2], row+half, column, cells);
+	saveNode(n->children[3], row+half, column+half, cells);
+}
+
+void HashLife::saveVisibleNode(Node* n, int row, int column, int top, int bottom, int left, int right, uint8_t** cells) const {
+	int nodeSize = 1 << n->level;
+	if (row >= bottom || row + nodeSize <= top || column >= right || column + nodeSize <= left) {
+		return;
+	}
+	if (n->level == LEAF_LEVEL) {
+		saveNode(n, row, column, cells);
+		return;
+	}
+	if ((int)emptyNodes.size() > n->level && n == emptyNodes[n->level]) {
+		return;
+	}
+
+	int half = nodeSize / 2;
+	saveVisibleNode(n->children[0], row, column, top, bottom, left, right, cells);
+	saveVisibleNode(n->children[1], row, column+half, top, bottom, left, right, cells);
+	saveVisibleNode(n->children[2], row+half, column, top, bottom, left, right, cells);
+	saveVisibleNode(n->children[3], row+half, column+half, top, bottom, left, right, cells);
+}
+
+void HashLife::drawNode(Node* n, int row, int column, char* pixelBuffer) const {
+	if (row >= WINDOW_SIZE || column >= WINDOW_SIZE) {
+		return;
+	}
+
+	int nodeSize = 1 << n->level;
+	if ((int)emptyNodes.size() > n->level && n == emptyNodes[n->level]) {
+		int width = std::min(nodeSize, WINDOW_SIZE - column);
+		int height = std::min(nodeSize, WINDOW_SIZE - row);
+		for (int i = 0; i < height; i++) {
+			memset(&pixelBuffer[(row+i) * WINDOW_SIZE + column], 0x00, width);
+		}
+		return;
+	}
+
+	if (n->level == LEAF_LEVEL) {
+		int height = std::min(nodeSize, WINDOW_SIZE - row);
+		for (int i = 0; i < height; i++) {
+			uint16_t rowBits = (n->bits[i*2] << 8) | n->bits[i*2+1];
+			for (int j = 0; j < LEAF_SIZE && column+j < WINDOW_SIZE; j++) {
+				pixelBuffer[(row+i) * WINDOW_SIZE + column+j] = (rowBits & (0x8000 >> j)) ? 0xFF : 0x00;
+			}
+		}
+		return;
+	}
+
+	int half = nodeSize / 2;
+	drawNode(n->children[0], row, column, pixelBuffer);
+	drawNode(n->children[1], row, column+half, pixelBuffer);
+	drawNode(n->children[2], row+half, column, pixelBuffer);
+	drawNode(n->children[3], row+half, column+half, pixelBuffer);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "life.h"
+#include "constants.h"
+#include "utility/life_kernel.h"
+
+// C++ version of hashlife.py
+// nodes are hash-consed, so any two identical squares of the board are the same Node*,
+// and each node remembers its own result, so repeated patterns are only ever stepped once.
+// once there are too many nodes, the ones the board and their results aren't made of are freed (see collect)
+class HashLife: public Life {
+public:
+	// size has to be a power of 2 and at least 32 (BASE_SIZE), the tree is always a whole square of that size
+	HashLife(int size, std::random_device& rd);
+	~HashLife();
+
+	void setup();
+	void tick();
+	void draw(char* pixelBuffer);
+	void drawView(const Viewport& view, uint8_t* out, ViewImage& image);
+
+	// row and column from 0, only valid after setup
+	bool getCell(int row, int column) const;
+	void setCell(int row, int column, bool alive);
+
+	// replaces the board with size+2 packed rows in the same layout as SIMDLife (size/8+33 bytes, data from byte 32)
+	void load(uint8_t** cells);
+	void save(uint8_t** cells);
+
+	// the kernel used for the base case, setting the rule picks the fastest one this cpu supports for it,
+	// changing the rule throws away every memoized result
+	void setRule(const LifeRule& rule);
+	LifeRule getRule() const;
+	void setKernel(const LifeKernel* kernel);
+	const LifeKernel* getKernel() const;
+
+	// each tick advances 2^stepLog2 generations, up to 2^(level-1) for the whole board
+	void setStepLog2(int stepLog2);
+	int getStepLog2() const;
+	uint64_t getGeneration() const;
+	uint64_t getNodeCount() const;
+
+	// a tick collects first once there are more than this many nodes, or twice as many as were kept last time,
+	// DEFAULT_NODE_LIMIT to start with
+	void setNodeLimit(uint64_t nodes);
+	uint64_t getNodeLimit() const;
+	// frees every node which the board (or the one being drawn) isn't made of and isn't the result of one that is,
+	// so the results which will be asked for again are kept and everything from earlier generations goes
+	void collect();
+
+private:
+	static const int LEAF_LEVEL = 4; // leaves are 16x16 cells, 256 bits
+	static const int LEAF_SIZE = 1 << LEAF_LEVEL;
+	static const int BASE_LEVEL = LEAF_LEVEL + 1; // smallest node with a result, it's result is a leaf
+	static const int BASE_SIZE = 1 << BASE_LEVEL;
+	static const uint64_t DEFAULT_NODE_LIMIT = 1 << 22; // 256 mb of nodes
+
+	struct alignas(32) Node {
+		union {
+			Node* children[4]; // nw, ne, sw, se
+			uint8_t bits[32]; // leaves only, 16 rows of 2 bytes in the same packed layout as SIMDLife
+		};
+		Node* result;
+		Node* next; // next node in the same hash bucket
+		uint64_t hash;
+		uint8_t level;
+		uint8_t resultStep;
+		bool marked; // only during collect
+	};
+
+	std::default_random_engine eng;
+	std::uniform_int_distribution<uint8_t> dist;
+	const int size;
+	const int level;
+
+	std::vector<Node*> buckets;
+	uint64_t nodeCount;
+	uint64_t nodeLimit;
+	uint64_t keptNodes; // by the last collect
+	std::vector<Node*> emptyNodes; // canonical empty node for each level
+
+	Node* root;
+	int stepLog2;
+	uint64_t generation;
+
+	// scratch board for the base case, a 32x32 square placed in a row of 256 cells,
+	// each row long enough for the whole 32 byte vector the step loads and stores at byte 32 and the one after it
+	const int scratchRowLen;
+	uint8_t** scratch;
+	uint8_t** nextScratch;
+	const LifeKernel* kernel;
+
+	std::mutex swapMutex;
+	Node* drawingRoot; // what draw is walking, kept by collect, under swapMutex
+	uint8_t** viewCells; // the visible part of the board, packed for renderView
+
+	Node* leaf(const uint8_t* bits);
+	Node* node(Node* nw, Node* ne, Node* sw, Node* se);
+	Node* empty(int level);
+	void insert(Node* n);
+	void grow();
+	void mark(Node* n);
+
+	Node* build(uint8_t** cells, int level, int row, int column);
+	Node* centered(Node* n);
+	Node* centerOf(Node* n);
+	Node* result(Node* n, int step);
+	Node* baseResult(Node* n, int step);
+	Node* withCell(Node* n, int row, int column, bool alive);
+
+	void drawNode(Node* n, int row, int column, char* pixelBuffer) const;
+	void saveVisibleNode(Node* n, int row, int column, int top, int bottom, int left, int right, uint8_t** cells) const;
+	void saveNode(Node* n, int row, int column, uint8_t** cells) const;
+
+};
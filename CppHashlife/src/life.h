@@ -1,9 +1,24 @@
 #pragma once
 
+#include <stdint.h>
+
+#include "utility/life_rule.h"
+#include "utility/viewport.h"
+
 class Life {
 public:
+	virtual ~Life() {}
+
 	virtual void setup() = 0;
 	virtual void tick() = 0;
 	virtual void draw(char* pixelBuffer) = 0;
+	// the part of the board view says into out (WINDOW_SIZE*WINDOW_SIZE bytes) for PackedRenderer, see renderView
+	virtual void drawView(const Viewport& view, uint8_t* out, ViewImage& image) = 0;
+
+	virtual bool getCell(int row, int column) const = 0;
+	virtual void setCell(int row, int column, bool alive) = 0;
+
+	virtual void setRule(const LifeRule& rule) = 0;
+	virtual LifeRule getRule() const = 0;
 	
 };
\ No newline at end of file
@@ -1,105 +1,82 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <stdlib.h>
+#include <atomic>
 #include <thread>
 #include <iostream>
 #include <chrono>
 #include <random>
+#include <fstream>
+#include <string.h>
 
 #include "simd_life.h"
 #include "basic_life.h"
+#include "hash_life.h"
 #include "life.h"
+#include "packed_renderer.h"
+#include "utility/pattern_io.h"
+#include "utility/checkpoint.h"
 
 using namespace std::chrono;
 using namespace std;
 
-static const GLfloat SQUARE_VERTECIES[] = {
-	-1.0f, -1.0f, 0.0f,
-	-1.0f, 1.0f, 0.0f,
-	1.0f, -1.0f, 0.0f,
-	1.0f, -1.0f, 0.0f,
-	1.0f, 1.0f, 0.0f,
-	-1.0f, 1.0f, 0.0f,
+// where s (and every CHECKPOINT_SECONDS) saves the board, pass it as the third argument to carry on from it
+const char* const CHECKPOINT_PATH = "life.hlck";
+const int CHECKPOINT_SECONDS = 600;
+
+// mouse state for moving the viewport around, the window's user pointer
+struct ViewControl {
+	Viewport view;
+	int boardSize = CELLS_SIZE; // of the frame last drawn, a growing board gets bigger
+	int growth = 0;
+	bool dragging = false;
+	double lastX = 0;
+	double lastY = 0;
+	double panX = 0; // drag not yet turned into whole pixels of pan
+	double panY = 0;
+	atomic<bool> saveRequested { false }; // read by the physics thread between ticks
 };
 
-bool createShader(char const* code, GLenum shaderType, GLuint& id) {
-	GLuint shaderID = glCreateShader(shaderType);
-	glShaderSource(shaderID, 1, &code, NULL);
-	glCompileShader(shaderID);
-
-	GLint result;
-	int logLength;
-	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &result);
-	glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
-	if (logLength > 0) {
-		char* logInfo = new char[logLength+1];
-		glGetShaderInfoLog(shaderID, logLength, NULL, logInfo);
-		printf("%s\n", logInfo);
-		delete[] logInfo;
-		return false;
-	}
-
-	id = shaderID;
-	return true;
+// scrolling zooms in and out around the pointer
+static void onScroll(GLFWwindow* window, double dx, double dy) {
+	ViewControl* control = (ViewControl*)glfwGetWindowUserPointer(window);
+	double x, y;
+	glfwGetCursorPos(window, &x, &y);
+	int steps = dy > 0 ? 1 : (dy < 0 ? -1 : 0);
+	control->view.zoomAt((int)x, WINDOW_SIZE-1 - (int)y, steps, control->boardSize, WINDOW_SIZE);
 }
 
-GLuint createProgram(GLuint const* shaders, int count) {
-	GLuint programID = glCreateProgram();
-	GLint result;
-	int logLength;
-	
-	for (int i = 0; i < count; i++) {
-		glAttachShader(programID, shaders[i]);
-
-		glGetProgramiv(programID, GL_COMPILE_STATUS, &result);
-		glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
-		if (logLength > 0) {
-			char* logInfo = new char[logLength+1];
-			glGetShaderInfoLog(shaders[i], logLength, NULL, logInfo);
-			printf("%s\n", logInfo);
-			delete[] logInfo;
-		}
-	}
-	glLinkProgram(programID);
-
-	for (int i = 0; i < count; i++) {
-		glDetachShader(programID, shaders[i]);
-		glDeleteShader(shaders[i]);
-	}
-
-	return programID;
+static void onMouseButton(GLFWwindow* window, int button, int action, int mods) {
+	ViewControl* control = (ViewControl*)glfwGetWindowUserPointer(window);
+	if (button != GLFW_MOUSE_BUTTON_LEFT) return;
+	control->dragging = action == GLFW_PRESS;
+	glfwGetCursorPos(window, &control->lastX, &control->lastY);
 }
 
-GLuint setupShaderProgram() {
-	const int shaderCount = 2;
-	GLuint shaderIds[shaderCount];
-
-	createShader( // Maps x/y pos directly to UV to draw 2d image
-		"#version 330 core\n\
-		layout(location = 0) in vec3 vertexPos;\
-		out vec2 UV;\
-		void main() {\
-			gl_Position.xyz = vertexPos;\
-			gl_Position.w = 1.0;\
-			UV = vec2(gl_Position.x/2 + 0.5, gl_Position.y/2 + 0.5);\
-		}",
-		GL_VERTEX_SHADER,
-		shaderIds[0]
-	);
-	createShader(
-		"#version 330 core\n\
-		in vec2 UV;\
-		out vec3 color;\
-		uniform sampler2D textureSampler;\
-		void main() {\
-			color = texture(textureSampler, UV).rgb;\
-		}", 
-		GL_FRAGMENT_SHADER,
-		shaderIds[1]
-	);
-
-	return createProgram(shaderIds, shaderCount);
+// dragging moves the board with the pointer, row 0 is at the bottom of the window so y is flipped
+static void onCursor(GLFWwindow* window, double x, double y) {
+	ViewControl* control = (ViewControl*)glfwGetWindowUserPointer(window);
+	if (!control->dragging) return;
+	control->panX += control->lastX - x;
+	control->panY += y - control->lastY;
+	control->lastX = x;
+	control->lastY = y;
+
+	int pixelsPerCell = control->view.zoom > 0 ? 1 << control->view.zoom : 1;
+	int dx = (int)(control->panX / pixelsPerCell) * pixelsPerCell;
+	int dy = (int)(control->panY / pixelsPerCell) * pixelsPerCell;
+	control->view.pan(dx, dy, control->boardSize, WINDOW_SIZE);
+	control->panX -= dx;
+	control->panY -= dy;
+}
 
+static void onKey(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	ViewControl* control = (ViewControl*)glfwGetWindowUserPointer(window);
+	if (action != GLFW_PRESS) return;
+	if (key == GLFW_KEY_D) control->view.density = !control->view.density;
+	if (key == GLFW_KEY_S) control->saveRequested = true;
+	if (key == GLFW_KEY_EQUAL) control->view.zoomAt(WINDOW_SIZE/2, WINDOW_SIZE/2, 1, control->boardSize, WINDOW_SIZE);
+	if (key == GLFW_KEY_MINUS) control->view.zoomAt(WINDOW_SIZE/2, WINDOW_SIZE/2, -1, control->boardSize, WINDOW_SIZE);
 }
 
 #define CMP_SWAP(i, j) { \
@@ -113,8 +90,7 @@ int main(int argc, char* argv[]) {
 
 	// Drawing code is as simple as possible while still being fast here.
 	// All I have is a plane that fills the entire window, and a texture on that plane
-	// Then I simply write individual pixels to that texture from PIXEL_BUFFER_A
-	// This seems to be plenty fast for my purposes.
+	// The texture is the packed cells themselves, the fragment shader picks out each cell's bit
 
 	GLFWwindow* window;
 
@@ -123,7 +99,17 @@ int main(int argc, char* argv[]) {
 		return -1;
 	}
 
+	// 4.4 for a persistently mapped upload buffer, 3.3 is enough for the shader
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
 	window = glfwCreateWindow(WINDOW_SIZE, WINDOW_SIZE, "Hash-ish Life", NULL, NULL);
+	if (!window) {
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		window = glfwCreateWindow(WINDOW_SIZE, WINDOW_SIZE, "Hash-ish Life", NULL, NULL);
+	}
 	if (!window) {
 		glfwTerminate();
 		return -1;
@@ -133,37 +119,131 @@ int main(int argc, char* argv[]) {
 	gladLoadGL();
 	glfwSwapInterval(1);
 
-	GLuint shaderProgram = setupShaderProgram();
-	
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_2D, textureID);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-	GLuint vertexBuffer;
-	glGenBuffers(1, &vertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(SQUARE_VERTECIES), SQUARE_VERTECIES, GL_STATIC_DRAW);
+	PackedRenderer* renderer = new PackedRenderer(WINDOW_SIZE, WINDOW_SIZE);
+	cout << "drawing with " << glGetString(GL_RENDERER) << (renderer->isPersistent() ? ", persistent" : ", orphaned");
+	cout << " upload buffer" << endl;
 
 	random_device rd;
 	SIMDLife* life = new SIMDLife(CELLS_SIZE, rd);
 	// BasicLife* life = new BasicLife(CELLS_SIZE, rd);
+	// HashLife* life = new HashLife(CELLS_SIZE, rd);
 	life->setup();
 
-	thread PHYSICS_THREAD([life]() {
+	// first argument is the number of threads to tick with, defaults to every core
+	// second argument is the number of generations each tick moves forward, in cache sized tiles
+	int threadCount = argc > 1 ? atoi(argv[1]) : thread::hardware_concurrency();
+	life->setThreadCount(threadCount);
+	life->setGenerationsPerTick(argc > 2 ? atoi(argv[2]) : 1);
+
+	// fifth argument is what's past the edge: bounded (dead cells), torus or grow
+	if (argc > 5) {
+		string topology = argv[5];
+		if (topology == "torus") life->setTopology(SIMDLife::TORUS);
+		else if (topology == "grow") life->setTopology(SIMDLife::GROWING);
+		else if (topology != "bounded") {
+			cout << "unknown topology " << topology << ", use bounded, torus or grow" << endl;
+			return -1;
+		}
+	}
+
+	// third argument is a pattern file (rle, plaintext, life 1.06 or macrocell) to start with instead of the demo,
+	// run with the rule the file gives unless a fourth argument (like B36/S23) overrides it,
+	// or a checkpoint, which carries on with its own size, rule and topology
+	Checkpoint saved;
+	string error;
+	if (argc > 3 && readCheckpointInfo(argv[3], saved, error)) {
+		if (!life->restore(argv[3], error)) {
+			cout << "couldn't restore " << argv[3] << ": " << error << endl;
+			return -1;
+		}
+		cout << "restored generation " << life->getGeneration() << " of a " << life->getSize() << " board" << endl;
+	} else if (argc > 3) {
+		uint8_t** cells = new uint8_t*[CELLS_SIZE+2];
+		for (int i = 0; i < CELLS_SIZE+2; i++) {
+			cells[i] = new uint8_t[CELLS_SIZE/8+33];
+			memset(cells[i], 0, CELLS_SIZE/8+33);
+		}
+
+		ifstream file(argv[3]);
+		PackedSink sink(cells, CELLS_SIZE, CELLS_SIZE, DEMO_ROW, DEMO_COLUMN);
+		PatternInfo info;
+		if (!file || !readPattern(file, sink, info)) {
+			cout << "couldn't read " << argv[3] << ": " << (file ? info.error : "can't open file") << endl;
+			return -1;
+		}
+		cout << "loaded " << info.format << " pattern";
+		if (sink.getClipped() > 0) cout << " (" << sink.getClipped() << " cells didn't fit)";
+		cout << endl;
+		life->load(cells);
+
+		string ruleText = argc > 4 ? argv[4] : info.rule;
+		if (!ruleText.empty()) {
+			LifeRule rule;
+			string error;
+			if (!LifeRule::parse(ruleText, rule, error)) {
+				cout << error << endl;
+				return -1;
+			}
+			life->setRule(rule);
+		}
+
+		for (int i = 0; i < CELLS_SIZE+2; i++) {
+			delete[] cells[i];
+		}
+		delete[] cells;
+	}
+	cout << "using the " << life->getKernel()->name() << " kernel for " << life->getRule().toString() << endl;
+
+	life->setCycleDetection(true);
+
+	ViewControl control;
+	thread PHYSICS_THREAD([life, &control]() {
 		high_resolution_clock timer;
 		int count = 0;
 		const int maxCount = 512;
+		uint64_t reportedPeriod = 0;
 
 		auto t0 = timer.now();
+		auto lastSave = timer.now();
 		while (true) {
+			// only the generation reported on is counted, so the rest don't pay for it
+			life->setStatsEnabled(count == maxCount-1);
 			life->tick();
 			count++;
 
+			// said once, it's forgotten again if the board is changed
+			if (life->getPeriod() != reportedPeriod) {
+				reportedPeriod = life->getPeriod();
+				if (reportedPeriod != 0) {
+					cout << "the board repeats every " << reportedPeriod << " generations from generation " << life->getCycleStart() << endl;
+				}
+			}
+
+			// written on another thread, if the last one is still going this tries again next tick
+			bool due = duration_cast<seconds>(timer.now() - lastSave).count() >= CHECKPOINT_SECONDS;
+			if ((due || control.saveRequested) && life->checkpoint(CHECKPOINT_PATH)) {
+				cout << "saving generation " << life->getGeneration() << " to " << CHECKPOINT_PATH << endl;
+				control.saveRequested = false;
+				lastSave = timer.now();
+			}
+
 			if (count == maxCount) {
 				long dt = duration_cast<microseconds>(timer.now() - t0).count();
-				cout << (dt / maxCount) << " microsecond tick" << endl;
+				cout << (dt / maxCount) << " microsecond tick (" << life->getThreadCount() << " threads, ";
+				cout << life->getActiveTileCount() << " active tiles)" << endl;
+
+				SIMDLife::GenerationStats stats = life->getStats();
+				cout << "generation " << stats.generation << ": " << stats.population << " alive, " << stats.births << " born, ";
+				cout << stats.deaths << " died";
+				if (stats.top >= 0) {
+					cout << ", rows " << stats.top << " to " << stats.bottom << ", columns " << stats.left << " to " << stats.right;
+				}
+				cout << endl;
+
+				FrameStats frames = life->getFrameStats();
+				cout << frames.published << " frames published, " << frames.drawn << " drawn, " << frames.dropped << " dropped, ";
+				cout << frames.skipped << " generations not drawn, " << (frames.publishNs / max<uint64_t>(1, frames.published));
+				cout << " ns per publish, " << (frames.acquireNs / max<uint64_t>(1, frames.drawn)) << " ns per acquire" << endl;
 				count = 0;
 				t0 = timer.now();
 			}
@@ -173,22 +253,32 @@ int main(int argc, char* argv[]) {
 
 	high_resolution_clock timer;
 	const long nanoPerFrame = 16666666; // 60 fps
-	char* pixelBuffer = (char*)_mm_malloc(sizeof(char)*PIXEL_COUNT, 32);
+
+	glfwSetWindowUserPointer(window, &control);
+	glfwSetScrollCallback(window, onScroll);
+	glfwSetMouseButtonCallback(window, onMouseButton);
+	glfwSetCursorPosCallback(window, onCursor);
+	glfwSetKeyCallback(window, onKey);
+	cout << "scroll or +/- to zoom, drag to pan, d to switch between density and any alive when zoomed out, s to save" << endl;
 
 	glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
 	while (glfwGetKey(window, GLFW_KEY_ESCAPE ) != GLFW_PRESS && glfwWindowShouldClose(window) == 0) {
 
 		auto t0 = timer.now();
 
-		life->draw(pixelBuffer);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, WINDOW_SIZE, WINDOW_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, pixelBuffer);
-
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-		glUseProgram(shaderProgram);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glDisableVertexAttribArray(0);
+		ViewImage image;
+		life->drawView(control.view, renderer->map(), image);
+		if (life->getFrameGrowth() != control.growth || life->getFrameSize() != control.boardSize) {
+			// everything moved down and right when the board grew, so move the view with it
+			int moved = life->getFrameGrowth() - control.growth;
+			control.growth = life->getFrameGrowth();
+			control.boardSize = life->getFrameSize();
+			control.view.row += moved;
+			control.view.column += moved;
+			control.view.clamp(control.boardSize, WINDOW_SIZE);
+		}
+		renderer->upload(image);
+		renderer->draw();
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
@@ -200,7 +290,7 @@ int main(int argc, char* argv[]) {
 	}
 
 	PHYSICS_THREAD.detach();
-	delete[] pixelBuffer;
+	delete renderer;
 	delete life;
 
 	glfwDestroyWindow(window);
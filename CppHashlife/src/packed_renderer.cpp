@@ -0,0 +1,207 @@
+#include "packed_renderer.h"
+#include <stdio.h>
+
+static const GLfloat SQUARE_VERTECIES[] = {
+	-1.0f, -1.0f, 0.0f,
+	-1.0f, 1.0f, 0.0f,
+	1.0f, -1.0f, 0.0f,
+	1.0f, -1.0f, 0.0f,
+	1.0f, 1.0f, 0.0f,
+	-1.0f, 1.0f, 0.0f,
+};
+
+static bool createShader(char const* code, GLenum shaderType, GLuint& id) {
+	GLuint shaderID = glCreateShader(shaderType);
+	glShaderSource(shaderID, 1, &code, NULL);
+	glCompileShader(shaderID);
+
+	GLint result;
+	int logLength;
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &result);
+	glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+	if (logLength > 0) {
+		char* logInfo = new char[logLength+1];
+		glGetShaderInfoLog(shaderID, logLength, NULL, logInfo);
+		printf("%s\n", logInfo);
+		delete[] logInfo;
+	}
+
+	id = shaderID;
+	return result == GL_TRUE;
+}
+
+static GLuint createProgram(GLuint const* shaders, int count) {
+	GLuint programID = glCreateProgram();
+	for (int i = 0; i < count; i++) {
+		glAttachShader(programID, shaders[i]);
+	}
+	glLinkProgram(programID);
+
+	GLint result;
+	int logLength;
+	glGetProgramiv(programID, GL_LINK_STATUS, &result);
+	glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+	if (logLength > 0) {
+		char* logInfo = new char[logLength+1];
+		glGetProgramInfoLog(programID, logLength, NULL, logInfo);
+		printf("%s\n", logInfo);
+		delete[] logInfo;
+	}
+
+	for (int i = 0; i < count; i++) {
+		glDetachShader(programID, shaders[i]);
+		glDeleteShader(shaders[i]);
+	}
+
+	return programID;
+}
+
+static GLuint setupShaderProgram() {
+	const int shaderCount = 2;
+	GLuint shaderIds[shaderCount];
+
+	createShader( // Maps x/y pos directly to UV to draw 2d image
+		"#version 330 core\n\
+		layout(location = 0) in vec3 vertexPos;\
+		out vec2 UV;\
+		void main() {\
+			gl_Position.xyz = vertexPos;\
+			gl_Position.w = 1.0;\
+			UV = vec2(gl_Position.x/2 + 0.5, gl_Position.y/2 + 0.5);\
+		}",
+		GL_VERTEX_SHADER,
+		shaderIds[0]
+	);
+	createShader( // each texel is 8 cells, the leftmost in the top bit
+		"#version 330 core\n\
+		in vec2 UV;\
+		out vec3 color;\
+		uniform usampler2D cells;\
+		uniform ivec2 cellCount;\
+		uniform bool density;\
+		void main() {\
+			ivec2 cell = min(ivec2(UV * vec2(cellCount)), cellCount - 1);\
+			if (density) {\
+				color = vec3(float(texelFetch(cells, cell, 0).r) / 255.0, 0.0, 0.0);\
+				return;\
+			}\
+			uint bits = texelFetch(cells, ivec2(cell.x >> 3, cell.y), 0).r;\
+			color = vec3(float((bits >> uint(7 - (cell.x & 7))) & 1u), 0.0, 0.0);\
+		}",
+		GL_FRAGMENT_SHADER,
+		shaderIds[1]
+	);
+
+	return createProgram(shaderIds, shaderCount);
+}
+
+PackedRenderer::PackedRenderer(int width, int height, bool persistent) :
+	width(width), height(height), persistent(persistent && GLAD_GL_VERSION_4_4), mapped(nullptr), region(0)
+{
+	program = setupShaderProgram();
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "cells"), 0);
+	cellCountLocation = glGetUniformLocation(program, "cellCount");
+	densityLocation = glGetUniformLocation(program, "density");
+
+	// core profiles draw nothing without a vertex array
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
+	glGenBuffers(1, &vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(SQUARE_VERTECIES), SQUARE_VERTECIES, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+	// allocated once, every frame only replaces its contents
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+
+	const GLsizeiptr regionSize = (GLsizeiptr)width * height;
+	glGenBuffers(1, &pixelBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+	if (this->persistent) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, regionSize * REGIONS, nullptr, flags);
+		mapped = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, regionSize * REGIONS, flags);
+	} else {
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (int i = 0; i < REGIONS; i++) {
+		fences[i] = nullptr;
+	}
+}
+
+PackedRenderer::~PackedRenderer() {
+	for (int i = 0; i < REGIONS; i++) {
+		if (fences[i] != nullptr) glDeleteSync(fences[i]);
+	}
+	if (persistent) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	glDeleteBuffers(1, &pixelBuffer);
+	glDeleteTextures(1, &texture);
+	glDeleteBuffers(1, &vertexBuffer);
+	glDeleteVertexArrays(1, &vertexArray);
+	glDeleteProgram(program);
+}
+
+uint8_t* PackedRenderer::map() {
+	const GLsizeiptr regionSize = (GLsizeiptr)width * height;
+	if (persistent) {
+		// only waits if the gpu is somehow still reading this region from 3 frames ago
+		if (fences[region] != nullptr) {
+			glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(fences[region]);
+			fences[region] = nullptr;
+		}
+		return mapped + region * regionSize;
+	}
+
+	// orphaning the buffer gives the driver a fresh one instead of waiting for the last upload
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+	mapped = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, regionSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	return mapped;
+}
+
+void PackedRenderer::upload(const ViewImage& image) {
+	// only the texels the image covers are sent, the shader never looks past them
+	const GLsizeiptr regionSize = (GLsizeiptr)width * height;
+	const int texels = image.density ? image.width : image.width/8;
+	glUseProgram(program);
+	glUniform2i(cellCountLocation, image.width, image.height);
+	glUniform1i(densityLocation, image.density);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	if (persistent) {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texels, image.height, GL_RED_INTEGER, GL_UNSIGNED_BYTE, (void*)(region * regionSize));
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		region = (region + 1) % REGIONS;
+	} else {
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texels, image.height, GL_RED_INTEGER, GL_UNSIGNED_BYTE, (void*)0);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void PackedRenderer::draw() {
+	glUseProgram(program);
+	glBindVertexArray(vertexArray);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+}
+
+bool PackedRenderer::isPersistent() const {
+	return persistent;
+}
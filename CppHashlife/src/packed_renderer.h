@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <glad/glad.h>
+
+#include "utility/viewport.h"
+
+// draws a board from packed rows, 1 bit per cell, bit 7 of each byte the leftmost cell,
+// the rows go up as they are into an integer texture (1 byte per texel) and the fragment shader picks the bit out,
+// so nothing on the cpu expands cells into pixels and each frame uploads an eighth of what a byte per cell would
+// fewer cells than pixels are scaled up by the shader, and zoomed out views can be a byte of density per pixel instead
+// needs a current GL 3.3 core context, with GL 4.4 rows are written straight into a persistently mapped pixel buffer
+class PackedRenderer {
+public:
+	// width must be a multiple of 8, persistent can be turned off to test the GL 3.3 path on a newer context
+	PackedRenderer(int width, int height, bool persistent = true);
+	~PackedRenderer();
+
+	// room for width*height bytes, row 0 at the bottom of the viewport, only valid until upload
+	uint8_t* map();
+	// image says what was written, bits (image.width/8 bytes a row) or a byte per pixel, at most width x height
+	void upload(const ViewImage& image);
+
+	// fills the viewport with the last upload
+	void draw();
+
+	bool isPersistent() const;
+
+private:
+	static const int REGIONS = 3; // the pixel buffer is a ring, so the cpu never writes rows the gpu is still reading
+
+	const int width;
+	const int height;
+	const bool persistent;
+
+	GLuint program;
+	GLint cellCountLocation;
+	GLint densityLocation;
+	GLuint vertexArray;
+	GLuint vertexBuffer;
+	GLuint texture;
+	GLuint pixelBuffer;
+
+	uint8_t* mapped; // the whole ring when persistent, else the region map returned
+	GLsync fences[REGIONS];
+	int region;
+
+};
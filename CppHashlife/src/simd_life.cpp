@@ -1,115 +1,817 @@
 #include "simd_life.h"
-#include <immintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
 #include <stdlib.h>
+#include <string.h>
 #include <random>
+#include <sstream>
+
+#include "utility/pattern_io.h"
+#include "utility/checkpoint.h"
 
 SIMDLife::SIMDLife(int size, std::random_device& rd) : 
-	size(size), eng(rd()), dist(0, 255), 
-	rowLen(size/8+33), corners(size/256 * 2, size+2)
+	eng(rd()), dist(0, 255), size(size),
+	rowLen(size/8+33), kernel(LifeKernel::best()), topology(BOUNDED), growth(0), generation(0),
+	framesPublished(0), framesDropped(0), framesSkipped(0), framesDrawn(0), publishNs(0), acquireNs(0),
+	pool(nullptr), bandCount(1), generationsPerTick(1), tileRows(0), tileHeight(0),
+	activityWidth(size/256), activityHeight(size/ACTIVE_TILE_ROWS), activeTileCount(0), statsEnabled(false),
+	statsEvery(DEFAULT_STATS_EVERY), statsCountdown(0), countingTick(false),
+	cycleDetection(false), boardHash(0), recentHashes(HASH_HISTORY), recentCount(0), period(0), cycleStart(0),
+	checkpointWriting(false)
 {
-	this->cells = new uint8_t*[size+2];
-	this->nextCells = new uint8_t*[size+2];
-	this->drawCells = new uint8_t*[size+2];
+	this->activity = new uint8_t[activityWidth * activityHeight];
+	this->nextActivity = new uint8_t[activityWidth * activityHeight];
+	this->cells = nullptr;
+	this->nextCells = nullptr;
+	this->ringCells = new uint8_t*[size+2];
+	for (int f = 0; f < 3; f++) {
+		this->frameSizes[f] = size;
+		this->frameGrowth[f] = 0;
+	}
+	setThreadCount(1);
+}
+
+// size+2 zeroed rows of size/8+33 bytes, the first data byte of each on a cache line
+static RowArena boardRows(int size) {
+	return RowArena(size+2, size/8+33, 32);
 }
 
 SIMDLife::~SIMDLife() {
-	for (int i = 0; i < size+2; i++) {
-		delete[] cells[i];
-		delete[] nextCells[i];
-		delete[] drawCells[i];
-	}
-	delete[] cells;
-	delete[] nextCells;
-	delete[] drawCells;
+	if (checkpointThread.joinable()) checkpointThread.join();
+	delete[] ringCells;
+	delete pool;
+	delete[] activity;
+	delete[] nextActivity;
 }
 
 void SIMDLife::setup() {
-	for (int i = 0; i < size+2; i++) {
-		cells[i] = (uint8_t*)_mm_malloc(sizeof(uint8_t)*rowLen, 32);
-		nextCells[i] = (uint8_t*)_mm_malloc(sizeof(uint8_t)*rowLen, 32);
-		drawCells[i] = (uint8_t*)_mm_malloc(sizeof(uint8_t)*rowLen, 32);
-
-		for (int j = 0; j < rowLen; j++) {
-			cells[i][j] = 0x00;
-		}
+	board = boardRows(size);
+	nextBoard = boardRows(size);
+	cells = board.rows();
+	nextCells = nextBoard.rows();
+	for (int f = 0; f < 3; f++) {
+		frames[f] = boardRows(size);
+		frameSizes[f] = size;
 	}
 
-	util.drawPackedRLE(
-		"11bo38b$10b2o38b$9b2o39b$10b2o2b2o34b$38bo11b$38b2o8b2o$39b2o7b2o$10b2o2b2o18b2o2b2o10b$2o7b2o39b$2o8b2o38b$11bo38b$34b2o2b2o10b$39b2o9b$38b2o10b$38bo!",
-		400, 400, false, false, cells
-	);
+	std::istringstream demo(DEMO_RLE);
+	PackedSink sink(cells, size, size, DEMO_ROW, DEMO_COLUMN);
+	PatternInfo info;
+	readRLE(demo, sink, info);
 
 	for (int i = 1; i < size+1; i++) {
 		for (int j = 32; j < rowLen-1; j++) {
 			// cells[i][j] = (dist(eng) & dist(eng)) & 0xFF;
 			nextCells[i][j] = cells[i][j];
-			drawCells[i][j] = cells[i][j];
 		}
 	}
+
+	activateAll();
+	generation = 0;
+	publishFrame(true);
 }
 
 void SIMDLife::tick() {
-	int cornerI = 0;
+	// a tick moves nothing further than generationsPerTick cells
+	while (topology == GROWING && liveNearEdge(generationsPerTick)) {
+		grow();
+	}
+
+	// stats are only counted on every statsEvery-th tick, starting with the first one after they're enabled, and on the
+	// tick before each one, so a tile which goes quiet has its counts for both parities and they're kept until then
+	countingTick = statsEnabled && statsCountdown <= 1;
+	if (statsEnabled) statsCountdown = statsCountdown == 0 ? statsEvery - 1 : statsCountdown - 1;
+
+	if (generationsPerTick == 1) {
+		tickSingle();
+	} else {
+		tickBlocked();
+		memset(nextActivity, 1, activityWidth * activityHeight); // unknown after several generations, so everything is active
+		activeTileCount = activityWidth * activityHeight;
+		forgetTileStats();
+		// nextCells is left several generations back, not the one before
+		staleTiles.assign(activityWidth * activityHeight, 1);
+	}
+
+	std::swap(activity, nextActivity);
+	std::swap(cells, nextCells);
+	generation += generationsPerTick;
+	if (countingTick) stats.generation = generation;
+	if (cycleDetection) rememberHash();
+	publishFrame(false);
+}
+
+void SIMDLife::publishFrame(bool force) {
+	if (!force && !frameBuffer.isTaken()) {
+		framesSkipped++;
+		return;
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	const int slot = frameBuffer.getBack();
+	if (frameSizes[slot] != size) {
+		frames[slot] = boardRows(size);
+		frameSizes[slot] = size;
+	}
+	frameGrowth[slot] = growth;
+	copyRows(cells, frames[slot].rows());
+	framesDropped += frameBuffer.publish();
+	framesPublished++;
+	publishNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// the board's rows from one set to another, in bands on the pool
+void SIMDLife::copyRows(uint8_t* const* from, uint8_t** to) {
+	pool->run(bandCount, [this, from, to](int band, int thread) {
+		int start, end;
+		bandRows(band, bandCount, size, start, end);
+		for (int i = start + 1; i < end + 1; i++) {
+			memcpy(&to[i][32], &from[i][32], rowLen-33);
+		}
+	});
+}
+
+FrameStats SIMDLife::getFrameStats() const {
+	FrameStats stats;
+	stats.published = framesPublished;
+	stats.dropped = framesDropped;
+	stats.skipped = framesSkipped;
+	stats.drawn = framesDrawn;
+	stats.publishNs = publishNs;
+	stats.acquireNs = acquireNs;
+	return stats;
+}
+
+int SIMDLife::getFrameSize() const {
+	return frameSizes[frameBuffer.getFront()];
+}
+
+int SIMDLife::getFrameGrowth() const {
+	return frameGrowth[frameBuffer.getFront()];
+}
+
+bool SIMDLife::getCell(int row, int column) const {
+	return (cells[row+1][32 + column/8] >> (7 - column%8)) & 1;
+}
+
+void SIMDLife::setCell(int row, int column, bool alive) {
+	uint8_t bit = 0x80 >> (column%8);
+	if (alive) cells[row+1][32 + column/8] |= bit;
+	else cells[row+1][32 + column/8] &= ~bit;
+	const int tile = (row/ACTIVE_TILE_ROWS)*activityWidth + column/256;
+	activity[tile] = 1;
+	staleTiles[tile] = 1; // nextCells no longer leads to this
+	tileStatsKnown[0][tile] = tileStatsKnown[1][tile] = 0;
+	tileHashKnown[0][tile] = tileHashKnown[1][tile] = 0;
+	if (recentCount > 0 || period != 0) forgetHistory();
+}
+
+void SIMDLife::load(uint8_t** cells) {
+	for (int i = 1; i < size+1; i++) {
+		memcpy(&this->cells[i][32], &cells[i][32], rowLen-33);
+	}
+	activateAll();
+	publishFrame(true);
+}
+
+void SIMDLife::save(uint8_t** cells) const {
 	for (int i = 0; i < size+2; i++) {
-		for (int j = 32; j < rowLen-1; j += 32) {
-			corners.set(cornerI, cells[i][j-1] & 0x01);
-			cornerI++;
-			corners.set(cornerI, (cells[i][j+32] & 0x80) >> 7);
-			cornerI++;
+		memcpy(cells[i], this->cells[i], rowLen);
+	}
+}
+
+void SIMDLife::setRule(const LifeRule& rule) {
+	setKernel(LifeKernel::best(rule));
+}
+
+LifeRule SIMDLife::getRule() const {
+	return kernel->getRule();
+}
+
+void SIMDLife::setKernel(const LifeKernel* kernel) {
+	this->kernel = kernel;
+	activateAll(); // a quiet tile under one rule might not be under another
+}
+
+const LifeKernel* SIMDLife::getKernel() const {
+	return kernel;
+}
+
+int SIMDLife::getActiveTileCount() const {
+	return activeTileCount;
+}
+
+void SIMDLife::setTopology(Topology topology) {
+	this->topology = topology;
+	activateAll(); // edge tiles have different neighbours now
+}
+
+SIMDLife::Topology SIMDLife::getTopology() const {
+	return topology;
+}
+
+int SIMDLife::getSize() const {
+	return size;
+}
+
+int SIMDLife::getGrowth() const {
+	return growth;
+}
+
+bool SIMDLife::isActive(int tileX, int tileY) const {
+	if (topology == TORUS) {
+		// the tiles on one edge are next to the ones on the other
+		for (int dy = -1; dy <= 1; dy++) {
+			int y = (tileY + dy + activityHeight) % activityHeight;
+			for (int dx = -1; dx <= 1; dx++) {
+				int x = (tileX + dx + activityWidth) % activityWidth;
+				if (activity[y*activityWidth + x]) return true;
+			}
 		}
+		return false;
 	}
+	for (int y = std::max(0, tileY-1); y < std::min(activityHeight, tileY+2); y++) {
+		for (int x = std::max(0, tileX-1); x < std::min(activityWidth, tileX+2); x++) {
+			if (activity[y*activityWidth + x]) return true;
+		}
+	}
+	return false;
+}
 
-	__m256i nextState = _mm256_setzero_si256();
-	for (int i = 1; i < size+1; i++) {
-		for (int j = 32; j < rowLen-1; j += 32) {
-			util.nextState(cells, i, j, corners, nextState);
-			_mm256_store_si256((__m256i*)&nextCells[i][j], nextState);
+void SIMDLife::activateAll() {
+	memset(activity, 1, activityWidth * activityHeight);
+	staleTiles.assign(activityWidth * activityHeight, 1);
+	forgetTileStats();
+	forgetHashes();
+}
+
+void SIMDLife::forgetTileStats() {
+	for (int parity = 0; parity < 2; parity++) {
+		tileStats[parity].resize(activityWidth * activityHeight);
+		tileStatsKnown[parity].assign(activityWidth * activityHeight, 0);
+	}
+}
+
+void SIMDLife::forgetHashes() {
+	for (int parity = 0; parity < 2; parity++) {
+		tileHashes[parity].resize(activityWidth * activityHeight);
+		tileHashKnown[parity].assign(activityWidth * activityHeight, 0);
+	}
+	forgetHistory();
+}
+
+void SIMDLife::forgetHistory() {
+	hashGenerations.clear();
+	recentCount = 0;
+	period = 0;
+	cycleStart = 0;
+}
+
+// MurmurHash3's 64 bit finalizer
+static uint64_t mix64(uint64_t k) {
+	k ^= k >> 33;
+	k *= 0xFF51AFD7ED558CCDULL;
+	k ^= k >> 33;
+	k *= 0xC4CEB9FE1A85EC53ULL;
+	k ^= k >> 33;
+	return k;
+}
+
+// a tile's ACTIVE_TILE_ROWS rows of 32 bytes, in 4 lanes so the multiplies overlap
+static uint64_t hashTile(uint8_t* const* rows, int firstRow, int rowCount, int column) {
+	uint64_t h[4] = { 0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL, 0x27D4EB2F165667C5ULL };
+	for (int i = firstRow; i < firstRow + rowCount; i++) {
+		uint64_t words[4];
+		memcpy(words, &rows[i][column], 32);
+		for (int lane = 0; lane < 4; lane++) {
+			uint64_t x = (h[lane] ^ words[lane]) * 0x87C37B91114253D5ULL;
+			h[lane] = (x << 31) | (x >> 33);
 		}
 	}
+	return mix64(h[0] ^ mix64(h[1] ^ mix64(h[2] ^ mix64(h[3]))));
+}
 
-	swapMutex.lock();
-	std::swap(cells, nextCells);
-	swapMutex.unlock();
+// the tiles' hashes added up, each mixed with where it is first so moving a tile changes the sum
+void SIMDLife::hashBoard(int parity) {
+	uint64_t sum = 0;
+	const uint64_t* hashes = tileHashes[parity].data();
+	for (int tile = 0; tile < activityWidth * activityHeight; tile++) {
+		sum += mix64(hashes[tile] ^ (tile + 1) * 0x9E3779B97F4A7C15ULL);
+	}
+	boardHash = sum;
 }
 
-void SIMDLife::draw(char* pixelBuffer) {
-	swapMutex.lock();
+// a repeat is only looked for until one is found, the ring keeps going so a later skipTo can start from it
+void SIMDLife::rememberHash() {
+	if (period == 0) {
+		auto seen = hashGenerations.find(boardHash);
+		if (seen != hashGenerations.end()) {
+			period = generation - seen->second;
+			cycleStart = seen->second;
+		}
+	}
+	std::pair<uint64_t, uint64_t>& slot = recentHashes[recentCount % HASH_HISTORY];
+	if (recentCount >= HASH_HISTORY) {
+		auto oldest = hashGenerations.find(slot.first);
+		if (oldest != hashGenerations.end() && oldest->second == slot.second) hashGenerations.erase(oldest);
+	}
+	slot = std::make_pair(boardHash, generation);
+	hashGenerations[boardHash] = generation;
+	recentCount++;
+}
+
+// a word's counts with its rows and columns moved by row and column
+static SIMDLife::GenerationStats wordCounts(const WordStats& word, int row, int column) {
+	SIMDLife::GenerationStats counts;
+	counts.population = word.population;
+	counts.births = word.births;
+	counts.deaths = word.births + word.previous - word.population;
+	if (word.top >= 0) {
+		counts.top = word.top + row;
+		counts.bottom = word.bottom + row;
+		counts.left = word.left + column;
+		counts.right = word.right + column;
+	}
+	return counts;
+}
+
+static void addCounts(SIMDLife::GenerationStats& total, const SIMDLife::GenerationStats& counts) {
+	total.population += counts.population;
+	total.births += counts.births;
+	total.deaths += counts.deaths;
+	if (counts.top < 0) return;
+	if (total.top < 0) {
+		total.top = counts.top;
+		total.bottom = counts.bottom;
+		total.left = counts.left;
+		total.right = counts.right;
+		return;
+	}
+	total.top = std::min(total.top, counts.top);
+	total.bottom = std::max(total.bottom, counts.bottom);
+	total.left = std::min(total.left, counts.left);
+	total.right = std::max(total.right, counts.right);
+}
+
+// the board's counts from every tile's, the kernel's rows start at 1
+void SIMDLife::countTiles(int parity) {
+	GenerationStats total;
+	uint64_t previous = 0;
+	int top = INT_MAX, bottom = -1, left = INT_MAX, right = -1;
+	const WordStats* tiles = tileStats[parity].data();
+	for (int tileY = 0; tileY < activityHeight; tileY++) {
+		for (int tileX = 0; tileX < activityWidth; tileX++) {
+			const WordStats& tile = tiles[tileY*activityWidth + tileX];
+			total.population += tile.population;
+			total.births += tile.births;
+			previous += tile.previous;
+			if (tile.bottom < 0) continue;
+			top = std::min(top, tile.top);
+			bottom = std::max(bottom, tile.bottom);
+			left = std::min(left, tileX*256 + tile.left);
+			right = std::max(right, tileX*256 + tile.right);
+		}
+	}
+	total.deaths = total.births + previous - total.population;
+	if (bottom >= 0) {
+		total.top = top - 1;
+		total.bottom = bottom - 1;
+		total.left = left;
+		total.right = right;
+	}
+	total.generation = stats.generation;
+	stats = total;
+}
+
+void SIMDLife::tickSingle() {
+	// nextCells still holds the generation before cells, for a tile whose neighbourhood is the same as 2 generations ago,
+	// the next generation is the same as that one, so it can be left alone,
+	// except a stale tile's, which isn't the generation before, so it stays active until this tick has written it
+	activeTileCount = 0;
+	const bool torus = topology == TORUS;
+	if (torus) {
+		memcpy(&ringCells[1], &cells[1], size * sizeof(uint8_t*));
+		ringCells[0] = cells[size];
+		ringCells[size+1] = cells[1];
+	}
+	uint8_t** source = torus ? ringCells : cells;
+	// counts go in the slot for the generation being made, the other slot has last generation's
+	const int parity = (generation + 1) & 1;
+	const bool counting = countingTick;
+	const bool hashing = cycleDetection;
+
+	pool->run(bandCount, [this, torus, source, parity, counting, hashing](int band, int thread) {
+		int start, end;
+		bandRows(band, bandCount, size, start, end);
+		int active = 0;
+		// a quiet tile still has to be ticked if its counts from 2 generations ago aren't known
+		auto needed = [this, parity, counting](int tileX, int tileY) {
+			const int tile = tileY*activityWidth + tileX;
+			return isActive(tileX, tileY) || (counting && !(tileStatsKnown[parity][tile] && tileStatsKnown[!parity][tile]));
+		};
+		for (int tileY = start / ACTIVE_TILE_ROWS; tileY < end / ACTIVE_TILE_ROWS; tileY++) {
+			// runs of active tiles go to the kernel together, so it's called once per row of a run instead of once per word
+			int tileX = 0;
+			while (tileX < activityWidth) {
+				const int tile = tileY*activityWidth + tileX;
+				if (!needed(tileX, tileY)) {
+					nextActivity[tile] = 0;
+					// kept up to date between counted ticks too, it's only a few adds for each quiet tile
+					if (statsEnabled && tileStatsKnown[parity][tile] && tileStatsKnown[!parity][tile]) {
+						// the same cells as 2 generations ago, so what died last generation is born again now
+						WordStats& counts = tileStats[parity][tile];
+						const WordStats& last = tileStats[!parity][tile];
+						counts.births = last.births + last.previous - last.population;
+						counts.previous = last.population;
+					} else if (statsEnabled) {
+						tileStatsKnown[parity][tile] = 0;
+					}
+					if (hashing && !tileHashKnown[parity][tile]) {
+						// nextCells is left as it was 2 generations ago, which is what this one is
+						tileHashes[parity][tile] = hashTile(nextCells, tileY*ACTIVE_TILE_ROWS + 1, ACTIVE_TILE_ROWS, tileX*32 + 32);
+						tileHashKnown[parity][tile] = 1;
+					}
+					tileX++;
+					continue;
+				}
+				int runEnd = tileX + 1;
+				while (runEnd < activityWidth && runEnd - tileX < 64 && needed(runEnd, tileY)) runEnd++;
+				const int words = runEnd - tileX;
+				active += words;
+
+				int j = tileX*32 + 32;
+				uint64_t changed = 0;
+				const int firstRow = tileY*ACTIVE_TILE_ROWS + 1;
+				if (counting) {
+					// each tile's population last generation is usually known, so it needn't be counted again
+					WordStats* counts = &tileStats[parity][tile];
+					bool previousKnown = true;
+					for (int w = 0; w < words; w++) {
+						counts[w] = WordStats();
+						previousKnown = previousKnown && tileStatsKnown[!parity][tile + w];
+					}
+					changed = kernel->nextRowsCounted(source, firstRow, firstRow + ACTIVE_TILE_ROWS, j, words, nextCells,
+						torus ? 32 : 0, torus ? rowLen-1 : 0, !previousKnown, counts);
+					for (int w = 0; w < words; w++) {
+						if (previousKnown) counts[w].previous = tileStats[!parity][tile + w].population;
+						tileStatsKnown[parity][tile + w] = 1;
+					}
+				} else {
+					for (int i = firstRow; i < firstRow + ACTIVE_TILE_ROWS; i++) {
+						changed |= torus ? kernel->nextWordsWrapped(source, i, j, words, &nextCells[i][j], 32, rowLen-1)
+							: kernel->nextWords(source, i, j, words, &nextCells[i][j]);
+					}
+					// counted again on the next counted tick
+					if (statsEnabled) memset(&tileStatsKnown[parity][tile], 0, words);
+				}
+				for (int w = 0; w < words; w++) {
+					if (staleTiles[tile + w]) {
+						changed |= (uint64_t)1 << w;
+						staleTiles[tile + w] = 0;
+					}
+					nextActivity[tileY*activityWidth + tileX + w] = (changed >> w) & 1;
+					// a tile which didn't change is the same as 2 generations ago, and so is its hash
+					if (hashing && (((changed >> w) & 1) || !tileHashKnown[parity][tile + w])) {
+						tileHashes[parity][tile + w] = hashTile(nextCells, firstRow, ACTIVE_TILE_ROWS, j + w*32);
+						tileHashKnown[parity][tile + w] = 1;
+					}
+				}
+				tileX = runEnd;
+			}
+		}
+		activeTileCount += active;
+	});
+	if (counting) countTiles(parity);
+	if (hashing) hashBoard(parity);
+}
+
+void SIMDLife::tickBlocked() {
+	const int halo = generationsPerTick;
+	const int tileCount = std::max(bandCount, (size + tileRows - 1) / tileRows);
+	const bool torus = topology == TORUS;
+	const bool counting = countingTick;
+	std::vector<GenerationStats> tileTotals(counting ? tileCount : 0);
+
+	pool->run(tileCount, [this, halo, tileCount, torus, counting, &tileTotals](int tile, int thread) {
+		int start, end;
+		bandRows(tile, tileCount, size, start, end);
+		if (start == end) return;
+		start++; // board rows start at 1
+		end++;
+
+		// tile row k holds board row start-halo+k, rows 0 and size+1 of the board are always dead,
+		// unless it's a torus, where the halo past the edge is the rows from the other side
+		uint8_t** tileA = tileCells[thread].rows();
+		uint8_t** tileB = nextTileCells[thread].rows();
+		const int first = start - halo;
+		const int loadStart = torus ? first : std::max(0, first);
+		const int loadEnd = torus ? end + halo : std::min(size+2, end + halo);
+		for (int i = loadStart; i < loadEnd; i++) {
+			int row = torus ? ((i-1) % size + size) % size + 1 : i;
+			memcpy(tileA[i - first], cells[row], rowLen);
+		}
+		if (!torus && loadStart == 0) memset(tileB[-first], 0, rowLen);
+		if (!torus && loadEnd == size+2) memset(tileB[size+1 - first], 0, rowLen);
+
+		// every generation the rows which are still correct shrink by 1 on each side
+		for (int gen = 1; gen <= halo; gen++) {
+			int genStart = torus ? start - halo + gen : std::max(1, start - halo + gen);
+			int genEnd = torus ? end + halo - gen : std::min(size+1, end + halo - gen);
+			if (counting && gen == halo) {
+				// only the generation the tick ends on is counted, its rows are just start to end
+				for (int j = 32; j < rowLen-1; j += 64*32) {
+					const int words = std::min(64, (rowLen-1 - j) / 32);
+					WordStats counts[64];
+					kernel->nextRowsCounted(tileA, genStart - first, genEnd - first, j, words, tileB,
+						torus ? 32 : 0, torus ? rowLen-1 : 0, true, counts);
+					for (int w = 0; w < words; w++) {
+						addCounts(tileTotals[tile], wordCounts(counts[w], first - 1, (j-32)*8 + w*256));
+					}
+				}
+				std::swap(tileA, tileB);
+				continue;
+			}
+			for (int i = genStart; i < genEnd; i++) {
+				for (int j = 32; j < rowLen-1; j += 64*32) {
+					const int words = std::min(64, (rowLen-1 - j) / 32);
+					if (torus) kernel->nextWordsWrapped(tileA, i - first, j, words, &tileB[i - first][j], 32, rowLen-1);
+					else kernel->nextWords(tileA, i - first, j, words, &tileB[i - first][j]);
+				}
+			}
+			std::swap(tileA, tileB);
+		}
+
+		for (int i = start; i < end; i++) {
+			memcpy(&nextCells[i][32], &tileA[i - first][32], rowLen-33);
+		}
+	});
+
+	if (counting) {
+		GenerationStats total;
+		for (const GenerationStats& part : tileTotals) addCounts(total, part);
+		total.generation = stats.generation;
+		stats = total;
+	}
+
+	// nothing is known about which tiles changed, so every one is hashed
+	if (cycleDetection) {
+		const int parity = (generation + generationsPerTick) & 1;
+		pool->run(bandCount, [this, parity](int band, int thread) {
+			int start, end;
+			bandRows(band, bandCount, size, start, end);
+			for (int tileY = start / ACTIVE_TILE_ROWS; tileY < end / ACTIVE_TILE_ROWS; tileY++) {
+				for (int tileX = 0; tileX < activityWidth; tileX++) {
+					const int tile = tileY*activityWidth + tileX;
+					tileHashes[parity][tile] = hashTile(nextCells, tileY*ACTIVE_TILE_ROWS + 1, ACTIVE_TILE_ROWS, tileX*32 + 32);
+					tileHashKnown[parity][tile] = 1;
+					tileHashKnown[!parity][tile] = 0;
+				}
+			}
+		});
+		hashBoard(parity);
+	}
+}
+
+void SIMDLife::setThreadCount(int threadCount) {
+	threadCount = std::max(1, threadCount);
+	delete pool;
+	pool = new ThreadPool(threadCount);
+	// a few bands per thread so one slow thread doesn't hold up the whole tick
+	bandCount = threadCount == 1 ? 1 : threadCount * 4;
+	allocateTiles();
+}
+
+int SIMDLife::getThreadCount() const {
+	return pool->size();
+}
+
+void SIMDLife::setGenerationsPerTick(int generations) {
+	generationsPerTick = std::max(1, generations);
+	allocateTiles();
+}
+
+int SIMDLife::getGenerationsPerTick() const {
+	return generationsPerTick;
+}
+
+// splits rows 0..rowCount into bandCount pieces, each starting on a multiple of BAND_ALIGN
+void SIMDLife::bandRows(int band, int bandCount, int rowCount, int& start, int& end) const {
+	int alignedRows = (rowCount + BAND_ALIGN - 1) / BAND_ALIGN;
+	start = std::min(rowCount, (int)((int64_t)alignedRows * band / bandCount) * BAND_ALIGN);
+	end = std::min(rowCount, (int)((int64_t)alignedRows * (band+1) / bandCount) * BAND_ALIGN);
+}
+
+void SIMDLife::allocateTiles() {
+	tileCells.clear();
+	nextTileCells.clear();
+	if (generationsPerTick == 1) return;
+
+	// as many rows as fit in TILE_BYTES, but always more real rows than halo rows
+	int halo = generationsPerTick;
+	tileRows = std::max(2*halo, TILE_BYTES / (2*rowLen) - 2*halo);
+	tileHeight = tileRows + 2*halo + 2*BAND_ALIGN + 2; // bandRows rounds tiles to BAND_ALIGN rows, so they can be a bit bigger
+
+	for (int t = 0; t < pool->size(); t++) {
+		tileCells.emplace_back(tileHeight, rowLen, 32);
+		nextTileCells.emplace_back(tileHeight, rowLen, 32);
+	}
+}
+
+// whole bytes at a time, so it can say yes for a cell up to 7 further in
+bool SIMDLife::liveNearEdge(int margin) const {
+	margin = std::min(margin, size);
+	const int bytes = (margin + 7) / 8;
 	for (int i = 1; i < size+1; i++) {
-		memcpy(drawCells[i], cells[i], rowLen);
+		const uint8_t* row = cells[i];
+		if (i <= margin || i > size - margin) {
+			for (int j = 32; j < rowLen-1; j++) {
+				if (row[j]) return true;
+			}
+			continue;
+		}
+		for (int j = 0; j < bytes; j++) {
+			if (row[32 + j] || row[rowLen-2 - j]) return true;
+		}
 	}
-	swapMutex.unlock();
+	return false;
+}
+
+void SIMDLife::grow() {
+	const int grownSize = size + 2*GROW_CELLS;
+	RowArena grown = boardRows(grownSize);
+	for (int i = 1; i < size+1; i++) {
+		memcpy(&grown.rows()[i + GROW_CELLS][32 + GROW_CELLS/8], &cells[i][32], rowLen-33);
+	}
+	resize(grownSize, std::move(grown));
+	growth += GROW_CELLS;
+}
 
-	__m256i maskBits = _mm256_set1_epi64x(0x0102040810204080LL);
-	__m256i zeros = _mm256_setzero_si256();
-	__m256i ones = _mm256_set1_epi8(0xFF);
-	// __m128i maskBits = _mm_set1_epi64x(0x0102040810204080LL);
-	// __m128i zeros = _mm_setzero_si128();
-	// __m128i ones = _mm_set1_epi8(0xFF);
+// everything sized by the board is reallocated, and every tile is active and stale since nextCells starts out empty
+void SIMDLife::resize(int size, RowArena&& rows) {
+	this->size = size;
+	rowLen = size/8+33;
+	board = std::move(rows);
+	nextBoard = boardRows(size);
+	cells = board.rows();
+	nextCells = nextBoard.rows();
+	delete[] ringCells;
+	ringCells = new uint8_t*[size+2];
+
+	delete[] activity;
+	delete[] nextActivity;
+	activityWidth = size/256;
+	activityHeight = size/ACTIVE_TILE_ROWS;
+	activity = new uint8_t[activityWidth * activityHeight];
+	nextActivity = new uint8_t[activityWidth * activityHeight];
+	activateAll();
+	allocateTiles();
+}
+
+bool SIMDLife::checkpoint(const std::string& path) {
+	if (checkpointWriting) return false;
+	if (checkpointThread.joinable()) checkpointThread.join(); // already done, it just hasn't been joined
+
+	if (snapshot.getRowCount() != size+2) snapshot = boardRows(size);
+	copyRows(cells, snapshot.rows());
+
+	Checkpoint info;
+	info.generation = generation;
+	info.size = size;
+	info.rule = getRule();
+	info.topology = topology;
+	info.growth = growth;
+	checkpointWriting = true;
+	checkpointThread = std::thread([this, path, info]() {
+		std::string error;
+		if (!writeCheckpoint(path, info, snapshot.rows(), error)) checkpointError = error;
+		checkpointWriting = false;
+	});
+	return true;
+}
+
+bool SIMDLife::finishCheckpoint(std::string& error) {
+	if (checkpointThread.joinable()) checkpointThread.join();
+	error = checkpointError;
+	checkpointError.clear();
+	return error.empty();
+}
+
+bool SIMDLife::restore(const std::string& path, std::string& error) {
+	Checkpoint info;
+	RowArena rows;
+	if (!mapCheckpoint(path, info, rows, error)) return false;
+	if (info.size % 256 != 0 || info.topology < BOUNDED || info.topology > GROWING) {
+		error = path + " isn't a board SIMDLife can run";
+		return false;
+	}
+
+	resize(info.size, std::move(rows));
+	generation = info.generation;
+	growth = info.growth;
+	topology = (Topology)info.topology;
+	setRule(info.rule);
+	publishFrame(false); // only if the renderer is waiting, a forced copy would read in the whole file
+	return true;
+}
+
+uint64_t SIMDLife::getGeneration() const {
+	return generation;
+}
+
+void SIMDLife::setStatsEnabled(bool enabled) {
+	// a quiet tile's counts were left alone while it was off
+	if (enabled && !statsEnabled) {
+		forgetTileStats();
+		statsCountdown = 0;
+	}
+	statsEnabled = enabled;
+}
+
+void SIMDLife::setStatsEvery(int ticks) {
+	statsEvery = std::max(1, ticks);
+	statsCountdown = 0;
+}
+
+int SIMDLife::getStatsEvery() const {
+	return statsEvery;
+}
+
+bool SIMDLife::getStatsEnabled() const {
+	return statsEnabled;
+}
+
+SIMDLife::GenerationStats SIMDLife::getStats() const {
+	return stats;
+}
+
+void SIMDLife::setCycleDetection(bool enabled) {
+	// tiles' hashes were left alone while it was off
+	if (enabled && !cycleDetection) forgetHashes();
+	cycleDetection = enabled;
+}
+
+bool SIMDLife::getCycleDetection() const {
+	return cycleDetection;
+}
+
+uint64_t SIMDLife::getHash() const {
+	return boardHash;
+}
+
+uint64_t SIMDLife::getPeriod() const {
+	return period;
+}
+
+uint64_t SIMDLife::getCycleStart() const {
+	return cycleStart;
+}
+
+bool SIMDLife::skipTo(uint64_t target) {
+	if (period == 0 || target < generation) return false;
+	const int savedGenerationsPerTick = generationsPerTick;
+	// tickSingle doesn't use the blocked tiles, so they needn't be reallocated, and a blocked tick before this left its
+	// tiles stale, so they're all ticked until nextCells is the generation before again
+	generationsPerTick = 1;
+	const uint64_t remaining = (target - generation) % period;
+	for (uint64_t i = 0; i < remaining; i++) tick();
+	generationsPerTick = savedGenerationsPerTick;
+
+	// the ring's generations are from before the jump, the period still holds
+	const uint64_t knownPeriod = period;
+	const uint64_t knownStart = cycleStart;
+	forgetHistory();
+	period = knownPeriod;
+	cycleStart = knownStart;
+	// the per-tile slots go by the generation's parity, an odd jump swaps which one is which
+	if ((target - generation) & 1) {
+		std::swap(tileStats[0], tileStats[1]);
+		std::swap(tileStatsKnown[0], tileStatsKnown[1]);
+		std::swap(tileHashes[0], tileHashes[1]);
+		std::swap(tileHashKnown[0], tileHashKnown[1]);
+	}
+	// the counts are the board's at target too if they were counted on the last tick
+	if (stats.generation == generation) stats.generation = target;
+	generation = target;
+	return true;
+}
+
+void SIMDLife::drawView(const Viewport& view, uint8_t* out, ViewImage& image) {
+	auto t0 = std::chrono::steady_clock::now();
+	framesDrawn += frameBuffer.acquire();
+	acquireNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+	const int slot = frameBuffer.getFront();
+	renderView(frames[slot].rows(), frameSizes[slot], view, WINDOW_SIZE, out, image);
+}
+
+void SIMDLife::draw(char* pixelBuffer) {
+	auto t0 = std::chrono::steady_clock::now();
+	framesDrawn += frameBuffer.acquire();
+	acquireNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+	uint8_t** drawCells = frames[frameBuffer.getFront()].rows();
 
 	for (int pixI = 0; pixI < WINDOW_SIZE; pixI += CELL_WIDTH) {
 		int cellI = pixI / CELL_WIDTH + 1;
-
-		for (int pixJ = 0; pixJ < WINDOW_SIZE; pixJ += 32) { // 256 bits = 32 bytes = 32 pixels at a time
-			int cellJ = pixJ / 8 / CELL_WIDTH + 32;
-			uint8_t a = drawCells[cellI][cellJ  ];
-			uint8_t b = drawCells[cellI][cellJ+1];
-			uint8_t c = drawCells[cellI][cellJ+2];
-			uint8_t d = drawCells[cellI][cellJ+3];
-
-			__m256i fullBytes = _mm256_set_epi8( // not sure why reverse arg order needed
-				d, d, d, d, d, d, d, d,
-				c, c, c, c, c, c, c, c,
-				b, b, b, b, b, b, b, b,
-				a, a, a, a, a, a, a, a
-			);
-			fullBytes = _mm256_and_si256(fullBytes, maskBits);
-			fullBytes = _mm256_cmpeq_epi8(fullBytes, zeros);
-			fullBytes = _mm256_xor_si256(fullBytes, ones); // same as bitwise not
-			
-			// auto doubleWidth = _mm256_cvtepi8_epi16(fullBytes);
-			_mm256_store_si256((__m256i*)&pixelBuffer[pixI * WINDOW_SIZE + pixJ], fullBytes);
-			// _mm256_store_si256((__m256i*)&pixelBuffer[(pixI+1) * WINDOW_SIZE + pixJ], doubleWidth);
-			
-		}
+		kernel->expand(&drawCells[cellI][32], WINDOW_SIZE/8, &pixelBuffer[pixI * WINDOW_SIZE]);
 	}
 }
\ No newline at end of file
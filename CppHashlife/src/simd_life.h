@@ -1,35 +1,220 @@
 #pragma once
 
-#include <mutex>
+#include <atomic>
 #include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "life.h"
 #include "constants.h"
-#include "utility/utility.h"
-#include "utility/packed_array_2d.h"
+#include "utility/thread_pool.h"
+#include "utility/life_kernel.h"
+#include "utility/triple_buffer.h"
+#include "utility/row_arena.h"
 
-class SIMDLife: Life {
+class SIMDLife: public Life {
 public:
+	// what's past the edge of the board:
+	// BOUNDED, dead cells. TORUS, the other edge, the top row is next to the bottom one and the left column to the right one.
+	// GROWING, dead cells, but before a tick that could reach them the board grows by GROW_CELLS on every side,
+	// so nothing is ever lost, cells move by GROW_CELLS every time it does (see getGrowth)
+	enum Topology { BOUNDED, TORUS, GROWING };
+
+	// what the last generation of a tick was like, the bounding box is in board rows and columns from 0
+	struct GenerationStats {
+		uint64_t generation = 0;
+		uint64_t population = 0;
+		uint64_t births = 0; // since the generation before, even when a tick is several generations
+		uint64_t deaths = 0;
+		int top = -1, bottom = -1, left = -1, right = -1; // -1 if nothing is alive
+	};
+
 	SIMDLife(int size, std::random_device& rd);
 	~SIMDLife();
 
 	void setup();
 	void tick();
 	void draw(char* pixelBuffer);
+	void drawView(const Viewport& view, uint8_t* out, ViewImage& image);
+
+	// tick and draw are meant for different threads, and never wait on each other: once the renderer has taken the last frame,
+	// the next tick copies its generation out for it, draw always shows the newest copy
+	FrameStats getFrameStats() const;
+	// the size and growth of the frame the last drawView or draw showed, only for the thread which draws
+	int getFrameSize() const;
+	int getFrameGrowth() const;
+
+	// row and column from 0, only valid after setup
+	bool getCell(int row, int column) const;
+	void setCell(int row, int column, bool alive);
+
+	// size+2 packed rows of size/8+33 bytes for the current size, data from byte 32, rows 0 and size+1 are the dead border
+	void load(uint8_t** cells);
+	void save(uint8_t** cells) const;
+
+	// setting the rule picks the fastest kernel this cpu supports for it, setting a kernel sets the rule to the kernel's
+	void setRule(const LifeRule& rule);
+	LifeRule getRule() const;
+	void setKernel(const LifeKernel* kernel);
+	const LifeKernel* getKernel() const;
+
+	// rows are split into bands which are ticked in parallel, 1 thread ticks everything on the calling thread
+	void setThreadCount(int threadCount);
+	int getThreadCount() const;
+
+	// with more than 1 generation per tick, the board is ticked in tiles of rows which fit in cache,
+	// each tile is loaded once with a halo of extra rows, and stepped that many generations before being written back
+	void setGenerationsPerTick(int generations);
+	int getGenerationsPerTick() const;
+
+	// the single generation tick only recomputes tiles (256 cells x ACTIVE_TILE_ROWS) if they or a neighbour changed,
+	// changes are measured against 2 generations ago, so period 2 oscillators are quiescent too
+	int getActiveTileCount() const;
+
+	void setTopology(Topology topology);
+	Topology getTopology() const;
+	// cells a side, only changes when GROWING
+	int getSize() const;
+	// how far down and right every cell has moved since setup, GROW_CELLS for each time the board grew
+	int getGrowth() const;
+
+	// generations ticked since setup, or since the generation a restored checkpoint was at
+	uint64_t getGeneration() const;
+
+	// while enabled, tick counts the new generation as the kernel writes it, without another pass over the board,
+	// a quiet tile's counts are kept from 2 generations ago (births and deaths swapped with last generation's)
+	void setStatsEnabled(bool enabled);
+	bool getStatsEnabled() const;
+	// only every ticks-th tick is counted, starting with the first one after stats are enabled or this is set,
+	// and the tick before each (see tick). counting a tick costs about a quarter of the tick again (12% on a sparse
+	// board), so the default of DEFAULT_STATS_EVERY keeps it to a few percent, 1 counts every tick
+	void setStatsEvery(int ticks);
+	int getStatsEvery() const;
+	// the last counted tick's, generation says which, only valid after a tick with stats enabled
+	GenerationStats getStats() const;
+
+	// while enabled, tick keeps a 64 bit hash of the board, from a hash of each tile which is only redone when the tile
+	// changes, and remembers the last HASH_HISTORY ticks' hashes to notice the board repeating. setting cells, loading,
+	// changing the rule or topology and growing all start over
+	void setCycleDetection(bool enabled);
+	bool getCycleDetection() const;
+	uint64_t getHash() const; // the current generation's, only valid after a tick with cycle detection enabled
+	// generations between repeats once the board has been seen to repeat, 0 until then. with several generations
+	// a tick it's only seen every generationsPerTick, so this is a multiple of the real period
+	uint64_t getPeriod() const;
+	// the generation the repeat was first seen from, the board has cycled since at least then
+	uint64_t getCycleStart() const;
+	// once the period is known, carries on to a later generation by ticking only (generation - now) % period,
+	// false if the period isn't known yet or it's in the past
+	bool skipTo(uint64_t generation);
+
+	// starts writing the board, generation, rule and topology to path (see Checkpoint) and returns straight away,
+	// the board is copied out between ticks and written on another thread while tick carries on,
+	// false without doing anything if the last checkpoint is still being written
+	bool checkpoint(const std::string& path);
+	// waits for the last checkpoint, false with why if it couldn't be written
+	bool finishCheckpoint(std::string& error);
+	// carries on from a checkpoint, at whatever size it was, the file is mapped as the board so nothing is read up front
+	bool restore(const std::string& path, std::string& error);
+
+	static const int GROW_CELLS = 256; // a whole tile, so the activity tiles and bands stay lined up
+	static const int DEFAULT_STATS_EVERY = 16;
+	static const int HASH_HISTORY = 4096; // longer than a glider takes to go round a 256 torus
 
 private:
+	static const int BAND_ALIGN = 32; // bands start on multiples of 32 rows so they never split an active tile
+	static const int TILE_BYTES = 1 << 18; // both buffers of a tile should fit in L2
+	static const int ACTIVE_TILE_ROWS = BAND_ALIGN;
 	
-	const Utility util;
 	std::default_random_engine eng;
 	std::uniform_int_distribution<uint8_t> dist;
-	const int size;
-	const int rowLen;
+	int size;
+	int rowLen;
+	const LifeKernel* kernel;
+	Topology topology;
+	int growth;
+	uint64_t generation;
 
+	// both generations, which is which swaps every tick, data from byte 32 starts a cache line
+	RowArena board;
+	RowArena nextBoard;
 	uint8_t** cells;
 	uint8_t** nextCells;
-	PackedArray2D corners;
+	uint8_t** ringCells; // for TORUS, the rows of cells with row 0 the last one and row size+1 the first, so no row is copied
+
+	RowArena frames[3]; // the slots of frameBuffer, copies of cells for draw
+	int frameSizes[3]; // a slot is only resized by tick while it's the back one, so draw never sees it change
+	int frameGrowth[3];
+	TripleBuffer frameBuffer;
+	std::atomic<uint64_t> framesPublished;
+	std::atomic<uint64_t> framesDropped;
+	std::atomic<uint64_t> framesSkipped;
+	std::atomic<uint64_t> framesDrawn;
+	std::atomic<uint64_t> publishNs;
+	std::atomic<uint64_t> acquireNs;
+
+	ThreadPool* pool;
+	int bandCount;
+
+	int generationsPerTick;
+	int tileRows;
+	int tileHeight;
+	std::vector<RowArena> tileCells; // 1 per thread, each tileHeight rows
+	std::vector<RowArena> nextTileCells;
+
+	int activityWidth;
+	int activityHeight;
+	uint8_t* activity; // 1 if the tile changed last generation
+	uint8_t* nextActivity;
+	// 1 if the tile's nextCells isn't the generation before cells, after an edit, a load or a blocked tick,
+	// so it can't be left alone for matching it
+	std::vector<uint8_t> staleTiles;
+	std::atomic<int> activeTileCount;
+
+	bool statsEnabled;
+	int statsEvery;
+	int statsCountdown; // ticks until the next counted one
+	bool countingTick; // this tick's generation is being counted
+	GenerationStats stats;
+	// each tile's counts for even and odd generations, so a quiet tile can reuse the ones from 2 generations ago,
+	// tileStatsKnown says which are up to date
+	std::vector<WordStats> tileStats[2];
+	std::vector<uint8_t> tileStatsKnown[2];
+
+	bool cycleDetection;
+	// each tile's hash for even and odd generations, the same way as tileStats
+	std::vector<uint64_t> tileHashes[2];
+	std::vector<uint8_t> tileHashKnown[2];
+	uint64_t boardHash;
+	std::vector<std::pair<uint64_t, uint64_t>> recentHashes; // hash and generation, a ring of HASH_HISTORY
+	int recentCount;
+	std::unordered_map<uint64_t, uint64_t> hashGenerations; // what's in the ring, to find a repeat without looking through it
+	uint64_t period;
+	uint64_t cycleStart;
+
+	RowArena snapshot; // the board being checkpointed
+	std::thread checkpointThread;
+	std::atomic<bool> checkpointWriting;
+	std::string checkpointError; // only touched by the writer while it's writing
 
-	std::mutex swapMutex;
-	uint8_t** drawCells;
+	bool isActive(int tileX, int tileY) const;
+	void activateAll();
+	void forgetTileStats();
+	void forgetHashes();
+	void forgetHistory();
+	void hashBoard(int parity);
+	void rememberHash();
+	void countTiles(int parity);
+	void publishFrame(bool force);
+	void tickSingle();
+	void tickBlocked();
+	void bandRows(int band, int bandCount, int rowCount, int& start, int& end) const;
+	void allocateTiles();
+	bool liveNearEdge(int margin) const;
+	void grow();
+	void resize(int size, RowArena&& rows);
+	void copyRows(uint8_t* const* from, uint8_t** to);
 
 };
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "soup_search.h"
+#include <string.h>
+#include <algorithm>
+#include <random>
+
+#include "utility/row_arena.h"
+
+SoupSearch::SoupSearch(int arenaSize, int soupSize, const LifeKernel* kernel) :
+	arenaSize(arenaSize), soupSize(std::min(soupSize, arenaSize)), kernel(kernel), maxGenerations(100000), pool(nullptr)
+{
+	arenaBytes = arenaSize / 8;
+	arenasPerStrip = std::max(1, STRIP_CELLS / (arenaSize + 8));
+	const int stripCells = (arenasPerStrip * (arenaSize + 8) + 255) / 256 * 256;
+	rowLen = stripCells/8 + 33;
+	setThreadCount(1);
+}
+
+SoupSearch::~SoupSearch() {
+	delete pool;
+}
+
+void SoupSearch::setThreadCount(int threadCount) {
+	delete pool;
+	pool = new ThreadPool(std::max(1, threadCount));
+}
+
+int SoupSearch::getThreadCount() const {
+	return pool->size();
+}
+
+void SoupSearch::setMaxGenerations(int64_t generations) {
+	maxGenerations = std::max<int64_t>(1, generations);
+}
+
+int64_t SoupSearch::getMaxGenerations() const {
+	return maxGenerations;
+}
+
+int SoupSearch::getArenasPerStrip() const {
+	return arenasPerStrip;
+}
+
+std::vector<uint8_t> SoupSearch::soup(uint64_t seed, int soupSize) {
+	std::mt19937_64 eng(seed);
+	std::vector<uint8_t> cells(soupSize * soupSize);
+	uint64_t bits = 0;
+	for (int i = 0; i < soupSize * soupSize; i++) {
+		if (i % 64 == 0) bits = eng();
+		cells[i] = (bits >> (i % 64)) & 1;
+	}
+	return cells;
+}
+
+std::vector<SoupResult> SoupSearch::run(uint64_t firstSeed, int count) {
+	std::vector<SoupResult> results(std::max(0, count));
+	std::atomic<int> nextSoup(0);
+	pool->run(pool->size(), [this, firstSeed, count, &results, &nextSoup](int strip, int thread) {
+		runStrip(firstSeed, count, results, nextSoup);
+	});
+	return results;
+}
+
+void SoupSearch::writeCensus(std::ostream& out, const std::vector<SoupResult>& results) {
+	out << "seed,stabilized,period,population\n";
+	for (const SoupResult& result : results) {
+		out << result.seed << ',' << result.stabilized << ',' << result.period << ',' << result.population << '\n';
+	}
+}
+
+// MurmurHash3's 64 bit finalizer
+static uint64_t mix64(uint64_t k) {
+	k ^= k >> 33;
+	k *= 0xFF51AFD7ED558CCDULL;
+	k ^= k >> 33;
+	k *= 0xC4CEB9FE1A85EC53ULL;
+	k ^= k >> 33;
+	return k;
+}
+
+// what 8 bytes of an arena add to its hash, mixed with where they are so a pattern moving changes it, nothing if empty
+static uint64_t chunkHash(uint64_t word, int chunk) {
+	return word ? mix64(word ^ (uint64_t)chunk * 0x9E3779B97F4A7C15ULL) : 0;
+}
+
+// what a row adds to an arena's hash, the chunks' hashes are added up so the rows can be done in any order
+// and rows with nothing in them skipped
+static uint64_t hashRow(const uint8_t* row, int i, int column, int bytes) {
+	uint64_t sum = 0;
+	const int chunksPerRow = bytes / 8;
+	for (int c = 0; c < chunksPerRow; c++) {
+		uint64_t word;
+		memcpy(&word, &row[column + c*8], 8);
+		sum += chunkHash(word, i*chunksPerRow + c);
+	}
+	return sum;
+}
+
+static uint64_t hashArena(uint8_t* const* cells, int rows, int column, int bytes) {
+	uint64_t sum = 0;
+	for (int i = 1; i <= rows; i++) sum += hashRow(cells[i], i, column, bytes);
+	return sum;
+}
+
+static uint64_t countArena(uint8_t* const* cells, int rows, int column, int bytes) {
+	uint64_t population = 0;
+	for (int i = 1; i <= rows; i++) {
+		for (int j = column; j < column + bytes; j++) population += __builtin_popcount(cells[i][j]);
+	}
+	return population;
+}
+
+void SoupSearch::runStrip(uint64_t firstSeed, int count, std::vector<SoupResult>& results, std::atomic<int>& nextSoup) {
+	RowArena board(arenaSize+2, rowLen, 32, false);
+	RowArena nextBoard(arenaSize+2, rowLen, 32, false);
+	uint8_t** cells = board.rows();
+	uint8_t** nextCells = nextBoard.rows();
+	const int words = (rowLen - 33) / 32;
+
+	// the arenas' bytes, everything else (the byte after each arena and the end of the strip) is kept dead
+	std::vector<uint8_t> mask(rowLen, 0);
+	for (int a = 0; a < arenasPerStrip; a++) {
+		memset(&mask[32 + a*(arenaBytes+1)], 0xFF, arenaBytes);
+	}
+	std::vector<uint64_t> masks(words*4);
+	memcpy(masks.data(), &mask[32], words*32);
+
+	// the last MAX_PERIOD generations' hashes of each arena, by generation % MAX_PERIOD
+	struct Arena {
+		int soup = -1;
+		int64_t generation = 0;
+		uint64_t hash = 0;
+		uint64_t hashes[MAX_PERIOD];
+	};
+	std::vector<Arena> arenas(arenasPerStrip);
+	int running = 0;
+
+	// whether any arena has a live cell in a row, a row with none next to it stays dead without stepping it
+	std::vector<uint8_t> live(arenaSize+2, 0);
+	std::vector<uint8_t> nextLive(arenaSize+2, 0);
+
+	auto fill = [&](int a) {
+		const int column = 32 + a*(arenaBytes+1);
+		for (int i = 1; i <= arenaSize; i++) memset(&cells[i][column], 0, arenaBytes);
+		Arena& arena = arenas[a];
+		arena.soup = nextSoup++;
+		if (arena.soup >= count) {
+			arena.soup = -1;
+			return;
+		}
+		std::vector<uint8_t> start = soup(firstSeed + arena.soup, soupSize);
+		const int offset = (arenaSize - soupSize) / 2;
+		for (int i = 0; i < soupSize; i++) {
+			live[offset+i+1] = 1;
+			for (int j = 0; j < soupSize; j++) {
+				if (start[i*soupSize + j]) cells[offset+i+1][column + (offset+j)/8] |= 0x80 >> ((offset+j) % 8);
+			}
+		}
+		arena.generation = 0;
+		arena.hash = hashArena(cells, arenaSize, column, arenaBytes);
+		arena.hashes[0] = arena.hash;
+		running++;
+	};
+	for (int a = 0; a < arenasPerStrip; a++) fill(a);
+
+	while (running > 0) {
+		for (Arena& arena : arenas) arena.hash = 0;
+		// a row with no live cells next to it stays dead, so it's left out of the step and the hashes
+		for (int i = 1; i <= arenaSize; i++) {
+			uint64_t* row = (uint64_t*)&nextCells[i][32];
+			if (!(live[i-1] | live[i] | live[i+1])) {
+				if (nextLive[i]) memset(row, 0, words*32);
+				nextLive[i] = 0;
+				continue;
+			}
+			kernel->nextWords(cells, i, 32, words, &nextCells[i][32]);
+			uint64_t any = 0;
+			for (int j = 0; j < words*4; j++) {
+				row[j] &= masks[j];
+				any |= row[j];
+			}
+			nextLive[i] = any != 0;
+
+			// hashed while the row is still in L1 instead of in another pass over the strip
+			for (int a = 0; a < arenasPerStrip; a++) {
+				arenas[a].hash += hashRow(nextCells[i], i, 32 + a*(arenaBytes+1), arenaBytes);
+			}
+		}
+		std::swap(cells, nextCells);
+		std::swap(live, nextLive);
+
+		for (int a = 0; a < arenasPerStrip; a++) {
+			Arena& arena = arenas[a];
+			if (arena.soup < 0) continue;
+			const int column = 32 + a*(arenaBytes+1);
+			const int64_t generation = ++arena.generation;
+			const uint64_t hash = arena.hash;
+
+			// the nearest repeat is the period, the cycle started that many generations back
+			int period = 0;
+			const int64_t furthest = std::min<int64_t>(generation, MAX_PERIOD);
+			for (int p = 1; p <= furthest; p++) {
+				if (arena.hashes[(generation - p) % MAX_PERIOD] == hash) {
+					period = p;
+					break;
+				}
+			}
+			arena.hashes[generation % MAX_PERIOD] = hash;
+			if (period == 0 && generation < maxGenerations) continue;
+
+			SoupResult& result = results[arena.soup];
+			result.seed = firstSeed + arena.soup;
+			result.stabilized = period ? generation - period : -1;
+			result.period = period;
+			result.population = countArena(cells, arenaSize, column, arenaBytes);
+			running--;
+			fill(a);
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <ostream>
+#include <vector>
+
+#include "utility/life_kernel.h"
+#include "utility/thread_pool.h"
+
+// what happened to one soup
+struct SoupResult {
+	uint64_t seed = 0;
+	int64_t stabilized = -1; // the first generation of the cycle it settled into, -1 if it hadn't by the generation limit
+	int period = 0; // 0 if it didn't settle
+	uint64_t population = 0; // when the repeat was seen (or at the limit), an oscillator's depends on its phase
+};
+
+// runs lots of random soups, each in its own small arena with dead cells past the edges, until each one repeats.
+// instead of a board each, arenas sit side by side along packed rows a dead byte apart, a strip of them small enough
+// to stay in cache, so the kernel steps a whole strip a row at a time and the gaps are cleared after each row.
+// when a soup settles its arena is refilled with the next seed straight away, each thread runs its own strip
+class SoupSearch {
+public:
+	static const int MAX_PERIOD = 32; // longer periods aren't noticed, those soups run to the generation limit
+	static const int STRIP_CELLS = 2048; // at most this wide, 66 rows of 64 cell arenas are ~19KB a generation
+
+	// arenaSize is a multiple of 64, soupSize is at most arenaSize and goes in the middle
+	SoupSearch(int arenaSize, int soupSize = 16, const LifeKernel* kernel = LifeKernel::best());
+	~SoupSearch();
+
+	void setThreadCount(int threadCount);
+	int getThreadCount() const;
+	void setMaxGenerations(int64_t generations);
+	int64_t getMaxGenerations() const;
+	int getArenasPerStrip() const;
+
+	// soups seeded firstSeed to firstSeed+count-1, in seed order. a soup only depends on its seed, not the thread
+	// or strip it ran in, so results are the same for any thread count
+	std::vector<SoupResult> run(uint64_t firstSeed, int count);
+
+	// the soupSize*soupSize cells (0 or 1, row by row) a seed starts with, about half alive
+	static std::vector<uint8_t> soup(uint64_t seed, int soupSize);
+
+	// one line per soup: seed, stabilized, period, population, with a header line
+	static void writeCensus(std::ostream& out, const std::vector<SoupResult>& results);
+
+private:
+	const int arenaSize;
+	const int soupSize;
+	const LifeKernel* kernel;
+	int64_t maxGenerations;
+	ThreadPool* pool;
+
+	int arenaBytes; // arenaSize/8, then a dead byte before the next arena
+	int arenasPerStrip;
+	int rowLen;
+
+	void runStrip(uint64_t firstSeed, int count, std::vector<SoupResult>& results, std::atomic<int>& nextSoup);
+};
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../simd_life.h"
+#include "../utility/life_kernel.h"
+#include "../utility/row_arena.h"
+
+// a quiet tile is only left alone while nextCells holds the generation before cells, so a board changed from outside
+// (setting a cell, loading, restoring) or by a blocked tick has to carry on like one which was ticked one generation at a time
+
+using namespace std;
+
+static int check(const char* what, bool ok) {
+	cout << "  " << what << ": " << (ok ? "ok" : "FAILED") << endl;
+	return !ok;
+}
+
+static void clear(SIMDLife& life) {
+	for (int i = 0; i < life.getSize(); i++) {
+		for (int j = 0; j < life.getSize(); j++) life.setCell(i, j, false);
+	}
+}
+
+static void place(SIMDLife& life, const vector<const char*>& rows, int row, int column) {
+	for (int i = 0; i < (int)rows.size(); i++) {
+		for (int j = 0; rows[i][j]; j++) life.setCell(row + i, column + j, rows[i][j] == 'o');
+	}
+}
+
+static bool same(const SIMDLife& a, const SIMDLife& b) {
+	for (int i = 0; i < a.getSize(); i++) {
+		for (int j = 0; j < a.getSize(); j++) {
+			if (a.getCell(i, j) != b.getCell(i, j)) return false;
+		}
+	}
+	return true;
+}
+
+// a lone cell dies and stays dead, it mustn't come back from a nextCells from before it was put there
+static bool staysDead(SIMDLife& life, int row, int column) {
+	bool ok = life.getCell(row, column);
+	for (int t = 0; t < 4 && ok; t++) {
+		life.tick();
+		ok = !life.getCell(row, column);
+	}
+	return ok;
+}
+
+static const vector<const char*> PULSAR = {
+	"..ooo...ooo..",
+	".............",
+	"o....o.o....o",
+	"o....o.o....o",
+	"o....o.o....o",
+	"..ooo...ooo..",
+	".............",
+	"..ooo...ooo..",
+	"o....o.o....o",
+	"o....o.o....o",
+	"o....o.o....o",
+	".............",
+	"..ooo...ooo..",
+};
+
+static int checkKernel(const LifeKernel* kernel, random_device& rd) {
+	int failures = 0;
+	const int size = 512;
+	auto board = [&]() {
+		SIMDLife* life = new SIMDLife(size, rd);
+		life->setup();
+		life->setKernel(kernel);
+		clear(*life);
+		for (int t = 0; t < 10; t++) life->tick();
+		return life;
+	};
+
+	{
+		SIMDLife* life = board();
+		life->setCell(100, 100, true);
+		failures += check("set cell", staysDead(*life, 100, 100));
+		delete life;
+	}
+
+	{
+		SIMDLife* life = board();
+		RowArena rows(size+2, size/8+33, 32);
+		for (int i = 0; i < size+2; i++) {
+			for (int j = 0; j < size/8+33; j++) rows.rows()[i][j] = 0;
+		}
+		rows.rows()[101][32 + 100/8] = 0x80 >> (100%8);
+		life->load(rows.rows());
+		failures += check("load", staysDead(*life, 100, 100));
+		delete life;
+	}
+
+	{
+		const string path = "activity_test.hlck";
+		SIMDLife* saved = board();
+		saved->setCell(100, 100, true);
+		string error;
+		bool ok = saved->checkpoint(path) && saved->finishCheckpoint(error);
+		SIMDLife* life = board();
+		ok = ok && life->restore(path, error);
+		failures += check("restore", ok && staysDead(*life, 100, 100));
+		remove(path.c_str());
+		delete saved;
+		delete life;
+	}
+
+	// a period 3 oscillator ticked 2 generations at a time, then 1 at a time against one ticked 1 at a time throughout
+	for (int blockedTicks : { 1, 2 }) {
+		SIMDLife* life = board();
+		SIMDLife* reference = board();
+		place(*life, PULSAR, 250, 250);
+		place(*reference, PULSAR, 250, 250);
+		life->setGenerationsPerTick(2);
+		for (int t = 0; t < blockedTicks; t++) life->tick();
+		life->setGenerationsPerTick(1);
+		while (reference->getGeneration() < life->getGeneration()) reference->tick();
+		bool ok = same(*life, *reference);
+		for (int t = 0; t < 12 && ok; t++) {
+			life->tick();
+			reference->tick();
+			ok = same(*life, *reference);
+		}
+		failures += check(blockedTicks == 1 ? "pulsar after 1 blocked tick" : "pulsar after 2 blocked ticks", ok);
+		delete life;
+		delete reference;
+	}
+	return failures;
+}
+
+int main(int argc, char* argv[]) {
+	random_device rd;
+	int failures = 0;
+
+	const LifeKernel* kernels[8];
+	int kernelCount = LifeKernel::supported(kernels);
+	for (int k = 0; k < kernelCount; k++) {
+		cout << kernels[k]->name() << endl;
+		failures += checkKernel(kernels[k], rd);
+	}
+
+	return failures == 0 ? 0 : 1;
+}
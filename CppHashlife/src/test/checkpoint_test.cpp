@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "../simd_life.h"
+#include "../utility/checkpoint.h"
+
+// a restored board has to carry on exactly like the one it was saved from: the same cells, generation, rule and topology,
+// including a board which grew, the file has to be left alone by ticking the restored board (it's mapped copy on write),
+// and files which aren't whole checkpoints have to be turned away
+
+using namespace std;
+using namespace std::chrono;
+
+static bool same(SIMDLife& a, SIMDLife& b) {
+	if (a.getSize() != b.getSize() || a.getGeneration() != b.getGeneration() || a.getRule() != b.getRule()
+			|| a.getTopology() != b.getTopology() || a.getGrowth() != b.getGrowth()) {
+		return false;
+	}
+	for (int i = 0; i < a.getSize(); i++) {
+		for (int j = 0; j < a.getSize(); j++) {
+			if (a.getCell(i, j) != b.getCell(i, j)) return false;
+		}
+	}
+	return true;
+}
+
+static int check(const char* what, bool ok) {
+	cout << what << ": " << (ok ? "ok" : "FAILED") << endl;
+	return !ok;
+}
+
+static int checkRoundTrip(SIMDLife::Topology topology, const LifeRule& rule, int size, const string& path, random_device& rd) {
+	mt19937 eng(size + topology);
+	SIMDLife original(size, rd);
+	original.setup();
+	original.setRule(rule);
+	original.setTopology(topology);
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) {
+			original.setCell(i, j, eng() % 5 == 0);
+		}
+	}
+	for (int t = 0; t < 30; t++) original.tick();
+
+	string error;
+	bool ok = original.checkpoint(path);
+	original.tick(); // carries on while it's written, this generation isn't in the file
+	ok = ok && original.finishCheckpoint(error);
+
+	SIMDLife restored(512, rd);
+	restored.setup();
+	ok = ok && restored.restore(path, error);
+	restored.tick();
+	ok = ok && same(original, restored);
+
+	// again, the first restored board's ticks mustn't have reached the file
+	SIMDLife again(256, rd);
+	again.setup();
+	ok = ok && again.restore(path, error);
+	again.tick();
+	ok = ok && same(original, again);
+
+	for (int t = 0; t < 30 && ok; t++) {
+		original.tick();
+		restored.tick();
+		ok = same(original, restored);
+	}
+	if (!error.empty()) cout << error << endl;
+	remove(path.c_str());
+	return !ok;
+}
+
+int main(int argc, char* argv[]) {
+	random_device rd;
+	int failures = 0;
+	const string path = "checkpoint_test.hlck";
+
+	failures += check("bounded", checkRoundTrip(SIMDLife::BOUNDED, CONWAY, 512, path, rd) == 0);
+	failures += check("torus, highlife", checkRoundTrip(SIMDLife::TORUS, HIGHLIFE, 768, path, rd) == 0);
+	failures += check("growing", checkRoundTrip(SIMDLife::GROWING, CONWAY, 256, path, rd) == 0);
+
+	// a checkpoint cut short, and something else entirely
+	{
+		SIMDLife life(512, rd);
+		life.setup();
+		string error;
+		bool ok = life.checkpoint(path) && life.finishCheckpoint(error);
+		FILE* file = fopen(path.c_str(), "r+b");
+		fseek(file, 0, SEEK_END);
+		long length = ftell(file);
+		fclose(file);
+		ok = ok && truncate(path.c_str(), length - 100) == 0;
+		ok = ok && !life.restore(path, error);
+		failures += check("cut short", ok);
+
+		file = fopen(path.c_str(), "wb");
+		fputs("x = 3, y = 3\nbo$2bo$3o!\n", file);
+		fclose(file);
+		failures += check("not a checkpoint", !life.restore(path, error));
+		remove(path.c_str());
+	}
+
+	// how long a big board takes to write and come back, restoring only maps it
+	{
+		const int size = 16384;
+		SIMDLife life(size, rd);
+		life.setup();
+		auto t0 = steady_clock::now();
+		string error;
+		bool ok = life.checkpoint(path);
+		auto t1 = steady_clock::now();
+		ok = ok && life.finishCheckpoint(error);
+		auto t2 = steady_clock::now();
+		SIMDLife restored(512, rd);
+		restored.setup();
+		ok = ok && restored.restore(path, error);
+		auto t3 = steady_clock::now();
+		cout << size << " board: " << duration<double, milli>(t1 - t0).count() << " ms until tick carries on, ";
+		cout << duration<double, milli>(t2 - t1).count() << " ms more writing, ";
+		cout << duration<double, milli>(t3 - t2).count() << " ms to restore" << endl;
+		ok = ok && restored.getSize() == size && restored.getCell(386, 438) == life.getCell(386, 438);
+		failures += check("big board", ok);
+		remove(path.c_str());
+	}
+
+	return failures == 0 ? 0 : 1;
+}
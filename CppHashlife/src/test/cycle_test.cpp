@@ -0,0 +1,222 @@
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../simd_life.h"
+#include "../utility/life_kernel.h"
+
+// tick's board hash has to come out the same when only the tiles which changed are rehashed as when every tile is,
+// oscillators and a glider going round a torus have to be found with exactly their period (a multiple of it with several
+// generations a tick), setting a cell has to forget it, and skipTo has to land on the same board as ticking all the way
+
+using namespace std;
+
+static int check(const char* what, bool ok) {
+	cout << "  " << what << ": " << (ok ? "ok" : "FAILED") << endl;
+	return !ok;
+}
+
+static void clear(SIMDLife& life) {
+	for (int i = 0; i < life.getSize(); i++) {
+		for (int j = 0; j < life.getSize(); j++) life.setCell(i, j, false);
+	}
+}
+
+static void place(SIMDLife& life, const vector<const char*>& rows, int row, int column) {
+	for (int i = 0; i < (int)rows.size(); i++) {
+		for (int j = 0; rows[i][j]; j++) life.setCell(row + i, column + j, rows[i][j] == 'o');
+	}
+}
+
+static bool same(const SIMDLife& a, const SIMDLife& b) {
+	for (int i = 0; i < a.getSize(); i++) {
+		for (int j = 0; j < a.getSize(); j++) {
+			if (a.getCell(i, j) != b.getCell(i, j)) return false;
+		}
+	}
+	return true;
+}
+
+// ticks until a period turns up, or gives up after limit generations
+static uint64_t findPeriod(SIMDLife& life, uint64_t limit) {
+	while (life.getPeriod() == 0 && life.getGeneration() < limit) life.tick();
+	return life.getPeriod();
+}
+
+static const vector<const char*> PULSAR = {
+	"..ooo...ooo..",
+	".............",
+	"o....o.o....o",
+	"o....o.o....o",
+	"o....o.o....o",
+	"..ooo...ooo..",
+	".............",
+	"..ooo...ooo..",
+	"o....o.o....o",
+	"o....o.o....o",
+	"o....o.o....o",
+	".............",
+	"..ooo...ooo..",
+};
+
+static int checkKernel(const LifeKernel* kernel, random_device& rd) {
+	int failures = 0;
+	auto board = [&](int size, SIMDLife::Topology topology, int generationsPerTick, int threads) {
+		SIMDLife* life = new SIMDLife(size, rd);
+		life->setup();
+		life->setKernel(kernel);
+		life->setTopology(topology);
+		life->setGenerationsPerTick(generationsPerTick);
+		life->setThreadCount(threads);
+		clear(*life);
+		life->setCycleDetection(true);
+		return life;
+	};
+
+	// a soup's hash, rehashing changed tiles every generation against every tile every 2
+	for (int threads : { 1, 3 }) {
+		SIMDLife* single = board(768, SIMDLife::BOUNDED, 1, threads);
+		SIMDLife* blocked = board(768, SIMDLife::BOUNDED, 2, threads);
+		mt19937 eng(threads);
+		for (int i = 300; i < 460; i++) {
+			for (int j = 200; j < 600; j++) {
+				bool alive = eng() % 3 == 0;
+				single->setCell(i, j, alive);
+				blocked->setCell(i, j, alive);
+			}
+		}
+		bool ok = true;
+		for (int gen = 0; gen < 60 && ok; gen += 2) {
+			single->tick();
+			single->tick();
+			blocked->tick();
+			ok = single->getHash() == blocked->getHash() && same(*single, *blocked);
+		}
+		failures += check(threads == 1 ? "hash of changed tiles, 1 thread" : "hash of changed tiles, 3 threads", ok);
+		delete single;
+		delete blocked;
+	}
+
+	{
+		SIMDLife* life = board(512, SIMDLife::BOUNDED, 1, 1);
+		place(*life, { "ooo" }, 100, 300);
+		failures += check("blinker", findPeriod(*life, 20) == 2);
+		life->setCell(400, 400, true); // dies, but the history before it doesn't count any more
+		bool forgotten = life->getPeriod() == 0;
+		life->tick();
+		failures += check("set cell forgets", forgotten && life->getPeriod() == 0 && findPeriod(*life, 20) == 2);
+		delete life;
+	}
+
+	{
+		SIMDLife* life = board(512, SIMDLife::BOUNDED, 3, 3);
+		place(*life, { "ooo" }, 100, 300);
+		failures += check("blinker, 3 generations a tick", findPeriod(*life, 30) == 6);
+		delete life;
+	}
+
+	// an odd jump, so the tiles' hashes and counts kept by parity have to swap over
+	{
+		SIMDLife* life = board(512, SIMDLife::TORUS, 1, 3);
+		SIMDLife* reference = board(512, SIMDLife::TORUS, 1, 1);
+		place(*life, PULSAR, 250, 250);
+		place(*reference, PULSAR, 250, 250);
+		life->setStatsEnabled(true);
+		reference->setStatsEnabled(true);
+		life->setStatsEvery(1);
+		reference->setStatsEvery(1);
+		failures += check("pulsar", findPeriod(*life, 20) == 3);
+
+		bool ok = life->skipTo(life->getGeneration() + 16);
+		while (reference->getGeneration() < life->getGeneration()) reference->tick();
+		for (int t = 0; t < 4 && ok; t++) {
+			life->tick();
+			reference->tick();
+			ok = same(*life, *reference) && life->getHash() == reference->getHash()
+				&& life->getStats().births == reference->getStats().births
+				&& life->getStats().deaths == reference->getStats().deaths;
+		}
+		failures += check("pulsar skipped ahead", ok);
+		delete life;
+		delete reference;
+	}
+
+	// found with 2 generations a tick, then skipped 1 generation at a time straight after the blocked ticks
+	{
+		SIMDLife* life = board(512, SIMDLife::BOUNDED, 2, 3);
+		SIMDLife* reference = board(512, SIMDLife::BOUNDED, 1, 1);
+		reference->setCycleDetection(false);
+		place(*life, PULSAR, 250, 250);
+		place(*reference, PULSAR, 250, 250);
+		failures += check("pulsar, 2 generations a tick", findPeriod(*life, 30) == 6);
+
+		bool ok = life->skipTo(life->getGeneration() + 10);
+		while (reference->getGeneration() < life->getGeneration()) reference->tick();
+		ok = ok && same(*life, *reference);
+		life->setGenerationsPerTick(1);
+		for (int t = 0; t < 6 && ok; t++) {
+			life->tick();
+			reference->tick();
+			ok = same(*life, *reference);
+		}
+		failures += check("pulsar skipped ahead after blocked ticks", ok);
+		delete life;
+		delete reference;
+	}
+
+	// a glider comes back to where it started every 4 generations per cell of a 256 torus
+	{
+		SIMDLife* life = board(256, SIMDLife::TORUS, 1, 1);
+		place(*life, { ".o.", "..o", "ooo" }, 10, 10);
+		failures += check("glider round a torus", findPeriod(*life, 2000) == 1024 && life->getCycleStart() == 1);
+		delete life;
+	}
+
+	// a soup left to settle, then skipped far ahead, against one ticked the whole way
+	{
+		SIMDLife* life = board(512, SIMDLife::BOUNDED, 1, 3);
+		SIMDLife* reference = board(512, SIMDLife::BOUNDED, 1, 1);
+		reference->setCycleDetection(false);
+		mt19937 eng(7);
+		for (int i = 200; i < 264; i++) {
+			for (int j = 200; j < 264; j++) {
+				bool alive = eng() % 3 == 0;
+				life->setCell(i, j, alive);
+				reference->setCell(i, j, alive);
+			}
+		}
+		uint64_t period = findPeriod(*life, 20000);
+		const uint64_t target = life->getGeneration() + 1000 + period/2;
+		bool ok = period > 0 && !life->skipTo(life->getGeneration() - 1) && life->skipTo(target);
+		while (reference->getGeneration() < target) reference->tick();
+		ok = ok && life->getGeneration() == target && same(*life, *reference);
+		for (int t = 0; t < 5 && ok; t++) {
+			life->tick();
+			reference->tick();
+			ok = same(*life, *reference) && life->getPeriod() == period;
+		}
+		cout << "  soup settled at generation " << life->getCycleStart() << " with period " << period << endl;
+		failures += check("skip ahead", ok);
+
+		SIMDLife* unknown = board(512, SIMDLife::BOUNDED, 1, 1);
+		failures += check("no skip before a period", !unknown->skipTo(100));
+		delete unknown;
+		delete life;
+		delete reference;
+	}
+	return failures;
+}
+
+int main(int argc, char* argv[]) {
+	random_device rd;
+	int failures = 0;
+
+	const LifeKernel* kernels[8];
+	int kernelCount = LifeKernel::supported(kernels);
+	for (int k = 0; k < kernelCount; k++) {
+		cout << kernels[k]->name() << endl;
+		failures += checkKernel(kernels[k], rd);
+	}
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <random>
+
+#include "../basic_life.h"
+#include "../hash_life.h"
+
+// HashLife with a small node limit has to keep collecting as a soup runs, single generations and big steps, and still
+// give exactly the same boards as BasicLife, memoized results surviving a collect included.
+// an empty board has to come down to a handful of nodes
+
+using namespace std;
+
+const int SIZE = 512;
+const uint64_t NODE_LIMIT = 20000;
+
+static bool same(Life* expected, Life* actual) {
+	for (int i = 0; i < SIZE; i++) {
+		for (int j = 0; j < SIZE; j++) {
+			if (expected->getCell(i, j) != actual->getCell(i, j)) return false;
+		}
+	}
+	return true;
+}
+
+static int checkCollecting(int stepLog2, random_device& rd) {
+	mt19937 eng(stepLog2);
+	BasicLife basic(SIZE, rd);
+	HashLife hash(SIZE, rd);
+	basic.setup();
+	hash.setup();
+	hash.setNodeLimit(NODE_LIMIT);
+	hash.setStepLog2(stepLog2);
+	for (int i = 0; i < SIZE; i++) {
+		for (int j = 0; j < SIZE; j++) {
+			bool alive = i > SIZE/4 && i < SIZE*3/4 && j > SIZE/4 && j < SIZE*3/4 && eng() % 3 == 0;
+			basic.setCell(i, j, alive);
+			hash.setCell(i, j, alive);
+		}
+	}
+
+	bool ok = true;
+	int collects = 0;
+	uint64_t most = 0;
+	for (int gen = 0; gen < 256 && ok; gen += 1 << stepLog2) {
+		uint64_t before = hash.getNodeCount();
+		for (int g = 0; g < (1 << stepLog2); g++) basic.tick();
+		hash.tick();
+		collects += hash.getNodeCount() < before;
+		most = max(most, hash.getNodeCount());
+		ok = same(&basic, &hash);
+	}
+	cout << "  step 2^" << stepLog2 << ": " << collects << " collects, at most " << most << " nodes: ";
+	ok = ok && collects > 0;
+	cout << (ok ? "ok" : "FAILED") << endl;
+	return !ok;
+}
+
+int main(int argc, char* argv[]) {
+	random_device rd;
+	int failures = 0;
+
+	failures += checkCollecting(0, rd);
+	failures += checkCollecting(3, rd);
+
+	{
+		HashLife hash(SIZE, rd);
+		hash.setup();
+		for (int t = 0; t < 20; t++) hash.tick();
+		for (int i = 0; i < SIZE; i++) {
+			for (int j = 0; j < SIZE; j++) hash.setCell(i, j, false);
+		}
+		uint64_t before = hash.getNodeCount();
+		hash.collect();
+		// the empty node of each level, each one's result is the one below
+		bool ok = hash.getNodeCount() < 20 && !hash.getCell(SIZE/2, SIZE/2);
+		cout << "  empty board: " << before << " nodes, " << hash.getNodeCount() << " after collecting: ";
+		cout << (ok ? "ok" : "FAILED") << endl;
+		failures += !ok;
+	}
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <random>
+
+#include "../basic_life.h"
+#include "../simd_life.h"
+#include "../hash_life.h"
+#include "../utility/life_kernel.h"
+
+// every kernel this cpu supports has to give exactly the same boards as BasicLife, for every rule with its own
+// compiled kernel and one without, single generation ticks (with tiles going quiet), blocked ticks, several threads,
+// and HashLife's base case
+
+using namespace std;
+
+const int SIZE = 512;
+const int GENERATIONS = 120;
+
+static void seed(Life* life, mt19937& eng) {
+	for (int i = 0; i < SIZE; i++) {
+		for (int j = 0; j < SIZE; j++) {
+			// a dense patch which dies down, and sparse edges so most tiles are quiet
+			bool inPatch = i > SIZE/4 && i < SIZE*3/4 && j > SIZE/4 && j < SIZE*3/4;
+			life->setCell(i, j, inPatch ? eng() % 3 == 0 : eng() % 64 == 0);
+		}
+	}
+}
+
+static bool same(Life* expected, Life* actual, const char* what, int generation) {
+	for (int i = 0; i < SIZE; i++) {
+		for (int j = 0; j < SIZE; j++) {
+			if (expected->getCell(i, j) != actual->getCell(i, j)) {
+				cout << what << " differs at generation " << generation << " (" << i << ", " << j << ")" << endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static int checkRuleParsing() {
+	int failures = 0;
+	struct { const char* text; bool ok; LifeRule rule; } cases[] = {
+		{ "B3/S23", true, CONWAY },
+		{ "b36/s23", true, HIGHLIFE },
+		{ "S23/B36", true, HIGHLIFE },
+		{ "23/36", true, HIGHLIFE },
+		{ "B3678/S34678", true, DAY_AND_NIGHT },
+		{ "B2/S", true, SEEDS },
+		{ "B03/S23", false, CONWAY },
+		{ "B9/S23", false, CONWAY },
+		{ "B3S23", false, CONWAY },
+	};
+	for (auto& c : cases) {
+		LifeRule rule = CONWAY;
+		string error;
+		bool ok = LifeRule::parse(c.text, rule, error);
+		if (ok != c.ok || (ok && rule != c.rule)) {
+			cout << "parsing " << c.text << " FAILED" << endl;
+			failures++;
+		}
+	}
+	if (HIGHLIFE.toString() != "B36/S23" || SEEDS.toString() != "B2/S") {
+		cout << "rule to string FAILED" << endl;
+		failures++;
+	}
+	return failures;
+}
+
+int main(int argc, char* argv[]) {
+	random_device rd;
+	int failures = checkRuleParsing();
+
+	LifeRule custom;
+	string error;
+	LifeRule::parse("B35/S1258", custom, error);
+	for (const LifeRule& rule : { CONWAY, HIGHLIFE, DAY_AND_NIGHT, SEEDS, custom }) {
+		const LifeKernel* kernels[8];
+		int kernelCount = LifeKernel::supported(kernels, rule);
+		for (int k = 0; k < kernelCount; k++) {
+			const LifeKernel* kernel = kernels[k];
+			cout << kernel->name() << " " << rule.toString() << endl;
+
+			for (int generationsPerTick : { 1, 5 }) {
+				for (int threads : { 1, 3 }) {
+					mt19937 eng(k * 100 + generationsPerTick * 10 + threads);
+					BasicLife basic(SIZE, rd);
+					SIMDLife simd(SIZE, rd);
+					basic.setup();
+					simd.setup();
+					basic.setRule(rule);
+					simd.setKernel(kernel);
+					simd.setThreadCount(threads);
+					simd.setGenerationsPerTick(generationsPerTick);
+
+					mt19937 copy = eng;
+					seed(&basic, eng);
+					seed(&simd, copy);
+
+					bool ok = true;
+					for (int gen = 0; gen < GENERATIONS && ok; gen += generationsPerTick) {
+						for (int g = 0; g < generationsPerTick; g++) basic.tick();
+						simd.tick();
+						ok = same(&basic, &simd, "SIMDLife", gen + generationsPerTick);
+					}
+					cout << "  SIMDLife " << generationsPerTick << " generations per tick, " << threads << " threads: ";
+					cout << (ok ? "ok" : "FAILED") << endl;
+					failures += !ok;
+				}
+			}
+
+			mt19937 eng(k);
+			BasicLife basic(SIZE, rd);
+			HashLife hash(SIZE, rd);
+			basic.setup();
+			hash.setup();
+			basic.setRule(rule);
+			hash.setKernel(kernel);
+
+			mt19937 copy = eng;
+			seed(&basic, eng);
+			seed(&hash, copy);
+
+			bool ok = true;
+			for (int gen = 0; gen < GENERATIONS && ok; gen++) {
+				basic.tick();
+				hash.tick();
+				ok = same(&basic, &hash, "HashLife", gen + 1);
+			}
+			cout << "  HashLife: " << (ok ? "ok" : "FAILED") << endl;
+			failures += !ok;
+		}
+	}
+
+	return failures == 0 ? 0 : 1;
+}
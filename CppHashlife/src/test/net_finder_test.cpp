@@ -0,0 +1,374 @@
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../find_net_v2/net_finder.h"
+
+// NetFinder has to finish the known 19 comparator sorting network for 8 inputs from a prefix of it with no more swaps
+// than it needs, the same number on one thread as on several (where the tree is split into tasks and the bound and
+// the explored spaces are shared), every network it gives back has to sort, and it has to find nothing when it
+// isn't given enough swaps. sorted outputs are their own mirror image, so all of that is with spaces and their
+// mirror images stored as one, which has to match doing it a bit at a time and store fewer spaces than without.
+// it's all with commuting swaps left asleep and spaces cut off on a lower bound too, which each have to find the same
+// networks as without in fewer nodes
+
+using namespace std;
+
+static const vector<Swap> SORTING_NETWORK = {
+	{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }, { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 }, { 2, 4 }, { 3, 5 },
+	{ 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 }, { 1, 4 }, { 3, 6 }, { 1, 2 }, { 3, 4 }, { 5, 6 }
+};
+
+// sorted is every set neighbour's bit before every unset one's, output k is "more than k neighbours"
+static AvxBitArray sortedOutputSpace() {
+	AvxBitArray allowed(false);
+	for (int k = 0; k <= NEIGHBOR_COUNT; k++) allowed.set((1 << k) - 1, true);
+	return allowed;
+}
+
+// the B3/S23 outputs, read the way the kernels read them: exactly k neighbours is output k-1 set and output k clear
+static AvxBitArray conwayOutputSpace() {
+	AvxBitArray allowed(false);
+	for (int output = 0; output < OUTPUT_SPACE_SIZE; output++) {
+		int neighbours = __builtin_popcount(output);
+		auto exactly = [output](int k) { return ((output >> (k-1)) & 1) && !((output >> k) & 1); };
+		bool born = exactly(3);
+		bool survives = exactly(2) || exactly(3);
+		allowed.set(output, born == (neighbours == 3) && survives == (neighbours == 2 || neighbours == 3));
+	}
+	return allowed;
+}
+
+static bool sorts(const vector<Swap>& swaps) {
+	AvxBitArray allowed = sortedOutputSpace();
+	MaskFactory maskFactory;
+	NetFinder finder(swaps, swaps.size(), &maskFactory, ~allowed);
+	AvxBitArray outputSpace;
+	for (const Swap& swap : swaps) finder.compareSwap(outputSpace, swap.i, swap.j);
+	return finder.isAllowed(outputSpace);
+}
+
+static int checkMirror() {
+	MaskFactory maskFactory;
+	NetFinder finder({}, 19, &maskFactory, ~sortedOutputSpace());
+	mt19937_64 eng(1);
+	cout << "  mirror: ";
+	for (int n = 0; n < 1000; n++) {
+		AvxBitArray space(false);
+		AvxBitArray expected(false);
+		for (int output = 0; output < OUTPUT_SPACE_SIZE; output++) {
+			if (!(eng() & 3)) continue;
+			space.set(output, true);
+			int mirrored = 0;
+			for (int k = 0; k < NEIGHBOR_COUNT; k++) mirrored |= !((output >> k) & 1) << (NEIGHBOR_COUNT - 1 - k);
+			expected.set(mirrored, true);
+		}
+		if (!(finder.mirror(space) == expected) || !(finder.mirror(expected) == space)) {
+			cout << "FAILED" << endl << "    " << space.toString() << endl;
+			return 1;
+		}
+	}
+	if (!finder.isSymmetric()) {
+		cout << "FAILED" << endl << "    sorted outputs should be their own mirror image" << endl;
+		return 1;
+	}
+	cout << "ok" << endl;
+	return 0;
+}
+
+static int checkSymmetryReduction(int prefix, int maxSwaps) {
+	vector<Swap> start(SORTING_NETWORK.begin(), SORTING_NETWORK.begin() + prefix);
+	MaskFactory maskFactory;
+	size_t explored[2];
+	for (int reduce = 0; reduce < 2; reduce++) {
+		NetFinder finder(start, maxSwaps, &maskFactory, ~sortedOutputSpace());
+		finder.setSymmetryReduction(reduce);
+		vector<Swap> found = finder.findBest();
+		explored[reduce] = finder.exploredCount();
+		if (found.size() != 19 || !sorts(found)) {
+			cout << "  symmetry reduction " << reduce << ": FAILED" << endl;
+			return 1;
+		}
+	}
+	cout << "  " << prefix << " start swaps, at most " << maxSwaps << ", spaces explored " << explored[0] << " without mirror images, ";
+	cout << explored[1] << " with: ";
+	if (explored[1] >= explored[0]) {
+		cout << "FAILED" << endl;
+		return 1;
+	}
+	cout << "ok" << endl;
+	return 0;
+}
+
+// leaving commuting swaps asleep has to find networks just as short as trying everything, in fewer nodes
+static int checkPartialOrderReduction(const AvxBitArray& allowed, const char* name, int prefix, int maxSwaps, int threads) {
+	vector<Swap> start(SORTING_NETWORK.begin(), SORTING_NETWORK.begin() + prefix);
+	MaskFactory maskFactory;
+	uint64_t nodes[2];
+	size_t found[2];
+	for (int reduce = 0; reduce < 2; reduce++) {
+		NetFinder finder(start, maxSwaps, &maskFactory, ~allowed, threads);
+		finder.setPartialOrderReduction(reduce);
+		vector<Swap> swaps = finder.findBest();
+		nodes[reduce] = finder.getNodeCount();
+		found[reduce] = swaps.size();
+
+		AvxBitArray outputSpace;
+		for (const Swap& swap : swaps) finder.compareSwap(outputSpace, swap.i, swap.j);
+		if (swaps.size() > prefix && !finder.isAllowed(outputSpace)) found[reduce] = 0;
+	}
+	cout << "  " << name << ", " << prefix << " start swaps, at most " << maxSwaps << ", " << threads << " threads, ";
+	cout << nodes[0] << " nodes without partial order reduction, " << nodes[1] << " with: ";
+	if (found[0] == 0 || found[0] != found[1] || nodes[1] >= nodes[0]) {
+		cout << "FAILED" << endl << "    found " << found[0] << " swaps without, " << found[1] << " with" << endl;
+		return 1;
+	}
+	cout << "ok" << endl;
+	return 0;
+}
+
+// the lower bound can't be above what the rest of the sorting network takes, it's optimal from every prefix of it
+static int checkLowerBound() {
+	MaskFactory maskFactory;
+	NetFinder finder({}, 19, &maskFactory, ~sortedOutputSpace());
+	AvxBitArray outputSpace;
+	cout << "  lower bound: ";
+	for (int prefix = 0; prefix <= SORTING_NETWORK.size(); prefix++) {
+		if (prefix > 0) finder.compareSwap(outputSpace, SORTING_NETWORK[prefix-1].i, SORTING_NETWORK[prefix-1].j);
+		int bound = finder.lowerBound(outputSpace);
+		if (bound > SORTING_NETWORK.size() - prefix) {
+			cout << "FAILED" << endl << "    " << bound << " after " << prefix << " swaps" << endl;
+			return 1;
+		}
+	}
+	cout << "ok" << endl;
+	return 0;
+}
+
+// cutting off spaces the lower bound rules out has to find networks just as short as the plain search does in fewer
+// nodes, and so does searching each length in turn from the lower bound up
+static int checkLowerBounds(const AvxBitArray& allowed, const char* name, int prefix, int maxSwaps, int threads) {
+	vector<Swap> start(SORTING_NETWORK.begin(), SORTING_NETWORK.begin() + prefix);
+	MaskFactory maskFactory;
+	uint64_t nodes[3];
+	size_t found[3];
+	for (int mode = 0; mode < 3; mode++) {
+		NetFinder finder(start, maxSwaps, &maskFactory, ~allowed, threads);
+		finder.setLowerBounds(mode > 0);
+		finder.setIterativeDeepening(mode > 1);
+		vector<Swap> swaps = finder.findBest();
+		nodes[mode] = finder.getNodeCount();
+		found[mode] = swaps.size();
+
+		AvxBitArray outputSpace;
+		for (const Swap& swap : swaps) finder.compareSwap(outputSpace, swap.i, swap.j);
+		if (swaps.size() > prefix && !finder.isAllowed(outputSpace)) found[mode] = 0;
+	}
+	cout << "  " << name << ", " << prefix << " start swaps, at most " << maxSwaps << ", " << threads << " threads, ";
+	cout << nodes[0] << " nodes plain, " << nodes[1] << " with lower bounds, " << nodes[2] << " deepening: ";
+	if (found[0] == 0 || found[0] != found[1] || found[0] != found[2] || nodes[1] >= nodes[0]) {
+		cout << "FAILED" << endl << "    found " << found[0] << " swaps plain, " << found[1] << " with lower bounds, ";
+		cout << found[2] << " deepening" << endl;
+		return 1;
+	}
+	cout << "ok" << endl;
+	return 0;
+}
+
+// a search keeping its explored spaces in a file has to find the same network as one in memory, and a search after it
+// on the same file, from a different start, has to get there from what the first left in far fewer nodes. a file
+// too small to hold them all still has to give the right answer, and a file for other outputs can't be used
+static int checkTableFile(const string& path) {
+	MaskFactory maskFactory;
+	vector<Swap> start(SORTING_NETWORK.begin(), SORTING_NETWORK.begin() + 8);
+	string error;
+	cout << "  table file: ";
+	remove(path.c_str());
+	uint64_t nodes[2];
+	for (int run = 0; run < 2; run++) {
+		vector<Swap> runStart(SORTING_NETWORK.begin(), SORTING_NETWORK.begin() + 8 + 2*run);
+		NetFinder finder(runStart, 19, &maskFactory, ~sortedOutputSpace());
+		bool ok = finder.useTableFile(path, 16 << 20, error);
+		vector<Swap> found = finder.findBest();
+		nodes[run] = finder.getNodeCount();
+		if (!ok || found.size() != 19 || !sorts(found) || (run == 1 && nodes[1] * 10 > nodes[0])) {
+			cout << "FAILED" << endl << "    run " << run << ", " << found.size() << " swaps, " << nodes[run] << " nodes " << error << endl;
+			return 1;
+		}
+	}
+	NetFinder conway(start, 19, &maskFactory, ~conwayOutputSpace());
+	if (conway.useTableFile(path, 16 << 20, error)) {
+		cout << "FAILED" << endl << "    a file for sorted outputs was used for B3/S23" << endl;
+		return 1;
+	}
+	remove(path.c_str());
+
+	// the smallest file there is, a little short of room for this search
+	vector<Swap> fullStart(SORTING_NETWORK.begin(), SORTING_NETWORK.begin() + 9);
+	NetFinder finder(fullStart, 19, &maskFactory, ~sortedOutputSpace());
+	bool ok = finder.useTableFile(path, 0, error);
+	vector<Swap> found = finder.findBest();
+	remove(path.c_str());
+	if (!ok || found.size() != 19 || !sorts(found)) {
+		cout << "FAILED" << endl << "    " << found.size() << " swaps from a full file " << error << endl;
+		return 1;
+	}
+	cout << nodes[0] << " nodes, then " << nodes[1] << " from the file: ok" << endl;
+	return 0;
+}
+
+// a table with a memory budget stays inside it, giving up failures once it's full, and still has to give back the
+// right network. successes are never given up for failures, however many there are, and in memory not even for
+// each other. a file full of successes from elsewhere keeps none of the search's, which has to find the network anyway
+static int checkMemoryBudget(int prefix, const string& path) {
+	cout << "  memory budget: ";
+	ExploredTable table;
+	table.setMemoryBudget(0);
+	mt19937_64 eng(11);
+	vector<AvxBitArray> successes;
+	uint64_t lost = 0; // spaces which weren't there straight after they were put, only dropped ones can be
+	for (int n = 0; n < 400000; n++) {
+		AvxBitArray space(false);
+		for (int k = 0; k < 24; k++) space.set(eng() % OUTPUT_SPACE_SIZE, true);
+		if (n % 100 == 0) {
+			ExploredSpace found;
+			found.success = true;
+			found.height = 3;
+			table.putSuccess(space, found);
+			successes.push_back(space);
+		} else {
+			table.putFailure(space, 1 + n % 5);
+		}
+		ExploredSpace explored;
+		lost += !table.find(space, explored);
+	}
+	ExploredTable::Stats stats = table.stats();
+	for (const AvxBitArray& space : successes) {
+		ExploredSpace explored;
+		if (!table.find(space, explored) || !explored.success) {
+			cout << "FAILED" << endl << "    a success was given up" << endl;
+			return 1;
+		}
+	}
+	if (stats.slots != stats.capacity || stats.replaced == 0 || lost > stats.dropped) {
+		cout << "FAILED" << endl << "    " << stats.slots << " slots of " << stats.capacity << ", " << stats.replaced << " replaced, ";
+		cout << lost << " lost" << endl;
+		return 1;
+	}
+
+	ExploredTable onlySuccesses;
+	onlySuccesses.setMemoryBudget(0);
+	successes.clear();
+	for (int n = 0; n < 100000; n++) {
+		AvxBitArray space(false);
+		for (int k = 0; k < 24; k++) space.set(eng() % OUTPUT_SPACE_SIZE, true);
+		ExploredSpace found;
+		found.success = true;
+		found.height = 3;
+		onlySuccesses.putSuccess(space, found);
+		successes.push_back(space);
+	}
+	for (const AvxBitArray& space : successes) {
+		ExploredSpace explored;
+		if (!onlySuccesses.find(space, explored) || !explored.success) {
+			cout << "FAILED" << endl << "    a success was given up for another" << endl;
+			return 1;
+		}
+	}
+
+	MaskFactory maskFactory;
+	string error;
+	remove(path.c_str());
+	{
+		ExploredTable full;
+		bool ok = full.mapFile(path, 0, (~sortedOutputSpace()).hash() + 1, error);
+		for (int n = 0; n < 200000 && ok; n++) {
+			AvxBitArray space(false);
+			for (int k = 0; k < 24; k++) space.set(eng() % OUTPUT_SPACE_SIZE, true);
+			ExploredSpace found;
+			found.success = true;
+			found.height = 3;
+			full.putSuccess(space, found);
+		}
+		if (!ok || full.stats().dropped == 0) {
+			cout << "FAILED" << endl << "    the file didn't fill up " << error << endl;
+			return 1;
+		}
+	}
+	vector<Swap> fullStart(SORTING_NETWORK.begin(), SORTING_NETWORK.begin() + 12);
+	NetFinder fromFull(fullStart, 19, &maskFactory, ~sortedOutputSpace());
+	bool ok = fromFull.useTableFile(path, 0, error);
+	vector<Swap> rebuilt = fromFull.findBest();
+	remove(path.c_str());
+	if (!ok || rebuilt.size() != 19 || !sorts(rebuilt)) {
+		cout << "FAILED" << endl << "    " << rebuilt.size() << " swaps from a file of only successes " << error << endl;
+		return 1;
+	}
+
+	vector<Swap> start(SORTING_NETWORK.begin(), SORTING_NETWORK.begin() + prefix);
+	NetFinder finder(start, 19, &maskFactory, ~sortedOutputSpace());
+	finder.setMemoryBudget(0);
+	vector<Swap> found = finder.findBest();
+	stats = finder.tableStats();
+	if (found.size() != 19 || !sorts(found) || stats.slots != stats.capacity || stats.replaced == 0) {
+		cout << "FAILED" << endl << "    " << found.size() << " swaps, " << stats.slots << " slots of " << stats.capacity << ", ";
+		cout << stats.replaced << " replaced" << endl;
+		return 1;
+	}
+	cout << stats.replaced << " spaces replaced, " << stats.dropped << " dropped: ok" << endl;
+	return 0;
+}
+
+static int check(int prefix, int maxSwaps, int threads, int expected) {
+	vector<Swap> start(SORTING_NETWORK.begin(), SORTING_NETWORK.begin() + prefix);
+	MaskFactory maskFactory;
+	NetFinder finder(start, maxSwaps, &maskFactory, ~sortedOutputSpace(), threads);
+	vector<Swap> found = finder.findBest();
+
+	cout << "  " << prefix << " start swaps, at most " << maxSwaps << ", " << threads << " threads: ";
+	bool ok = expected == 0 ? found.size() == prefix : found.size() == expected && sorts(found);
+	if (!ok) {
+		cout << "FAILED" << endl << "    expected " << expected << " swaps, got";
+		for (const Swap& swap : found) cout << " (" << (int)swap.i << ", " << (int)swap.j << ")";
+		cout << endl;
+		return 1;
+	}
+	cout << "ok" << endl;
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	int failures = 0;
+
+	if (!sorts(SORTING_NETWORK)) {
+		cout << "the reference network doesn't sort" << endl;
+		return 1;
+	}
+
+	failures += checkMirror();
+	failures += checkSymmetryReduction(8, 19);
+	failures += checkPartialOrderReduction(sortedOutputSpace(), "sorted", 10, 19, 1);
+	failures += checkPartialOrderReduction(sortedOutputSpace(), "sorted", 8, 21, 3);
+	// there's no B3/S23 network this short from these, so it's the whole tree both ways
+	failures += checkPartialOrderReduction(conwayOutputSpace(), "B3/S23", 8, 17, 1);
+	failures += checkLowerBound();
+	failures += checkLowerBounds(sortedOutputSpace(), "sorted", 10, 19, 1);
+	failures += checkLowerBounds(sortedOutputSpace(), "sorted", 8, 21, 1);
+	failures += checkLowerBounds(conwayOutputSpace(), "B3/S23", 8, 17, 1);
+	// the compressed keys test runs alongside this one, and its files are different anyway
+	failures += checkMemoryBudget(8, "net_finder_test_full_" + to_string(CompressedBitArray::WORDS) + ".table");
+	failures += checkTableFile("net_finder_test_" + to_string(CompressedBitArray::WORDS) + ".table");
+
+	for (int threads : { 1, 3 }) {
+		failures += check(19, 19, threads, 19);
+		failures += check(14, 19, threads, 19);
+		failures += check(12, 20, threads, 19);
+		failures += check(10, 19, threads, 19);
+		// loose enough that longer networks are found first and the bound has to come down
+		failures += check(8, 21, threads, 19);
+		// 19 is the fewest there are, so 18 can't be done from any start
+		failures += check(12, 18, threads, 0);
+	}
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glad/glad.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../packed_renderer.h"
+
+// renders random packed boards offscreen and reads them back, every pixel has to be its cell (or its density byte),
+// at 1:1, scaled up 4 times and as density, with both the persistent and the orphaned upload buffer,
+// and for more frames than the persistent ring has regions
+// runs on whatever EGL gives, which is llvmpipe on a machine without a gpu (LIBGL_ALWAYS_SOFTWARE=1 forces it)
+
+using namespace std;
+
+const int WIDTH = 1024;
+const int HEIGHT = 512;
+const int FRAMES = 6;
+
+static bool createContext() {
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay != nullptr) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API)) return false;
+
+	EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config;
+	EGLint configCount = 0;
+	eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+
+	for (int version : { 44, 33 }) {
+		EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, version / 10, EGL_CONTEXT_MINOR_VERSION, version % 10,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE
+		};
+		EGLContext context = eglCreateContext(display, configCount > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+		if (context != EGL_NO_CONTEXT && eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+			return gladLoadGLLoader((GLADloadproc)eglGetProcAddress);
+		}
+	}
+	return false;
+}
+
+static int checkFrames(bool persistent, mt19937& eng) {
+	PackedRenderer renderer(WIDTH, HEIGHT, persistent);
+	if (persistent && !renderer.isPersistent()) {
+		cout << "no GL 4.4, skipping the persistent buffer" << endl;
+		return 0;
+	}
+
+	vector<uint8_t> pixels(WIDTH * HEIGHT);
+	int failures = 0;
+	for (int frame = 0; frame < FRAMES; frame++) {
+		ViewImage image;
+		image.density = frame % 3 == 2;
+		int scale = frame % 3 == 1 ? 4 : 1;
+		image.width = WIDTH / scale;
+		image.height = HEIGHT / scale;
+		int rowBytes = image.density ? image.width : image.width/8;
+
+		vector<uint8_t> rows(rowBytes * image.height);
+		for (uint8_t& bits : rows) bits = eng() & eng(); // a quarter alive
+		uint8_t* mapped = renderer.map();
+		for (size_t i = 0; i < rows.size(); i++) mapped[i] = rows[i];
+		renderer.upload(image);
+		renderer.draw();
+		glReadPixels(0, 0, WIDTH, HEIGHT, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+
+		int wrong = 0;
+		for (int i = 0; i < HEIGHT; i++) {
+			for (int j = 0; j < WIDTH; j++) {
+				int row = i / scale;
+				int column = j / scale;
+				int expected = image.density ? rows[row * rowBytes + column] : ((rows[row * rowBytes + column/8] >> (7 - column%8)) & 1) * 255;
+				if (abs(pixels[i * WIDTH + j] - expected) > 1) wrong++;
+			}
+		}
+		if (wrong > 0) {
+			cout << "  frame " << frame << ": " << wrong << " pixels wrong" << endl;
+			failures++;
+		}
+	}
+	cout << (renderer.isPersistent() ? "persistent" : "orphaned") << " upload: " << (failures == 0 ? "ok" : "FAILED") << endl;
+	return failures;
+}
+
+int main(int argc, char* argv[]) {
+	if (!createContext()) {
+		cout << "no EGL OpenGL context, skipping" << endl;
+		return 0;
+	}
+	cout << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << endl;
+
+	// surfaceless, so everything goes to a framebuffer the size of the board
+	GLuint framebuffer, colorBuffer;
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glViewport(0, 0, WIDTH, HEIGHT);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	mt19937 eng(1);
+	int failures = checkFrames(true, eng) + checkFrames(false, eng);
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+#include <string.h>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "../utility/pattern_io.h"
+
+// every writer's output has to read back to the same board, through readPattern's format detection,
+// and the RLE corner cases drawPackedRLE used to get wrong
+
+using namespace std;
+
+const int SIZE = 300; // not a multiple of 8 or a power of 2 on purpose
+
+static uint8_t** newBoard(int size) {
+	uint8_t** cells = new uint8_t*[size+2];
+	for (int i = 0; i < size+2; i++) {
+		cells[i] = new uint8_t[size/8+33];
+		memset(cells[i], 0, size/8+33);
+	}
+	return cells;
+}
+
+static void deleteBoard(uint8_t** cells, int size) {
+	for (int i = 0; i < size+2; i++) {
+		delete[] cells[i];
+	}
+	delete[] cells;
+}
+
+static bool cell(uint8_t** cells, int row, int column) {
+	return (cells[row+1][32 + column/8] >> (7 - column%8)) & 1;
+}
+
+static bool same(uint8_t** a, uint8_t** b, int size) {
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) {
+			if (cell(a, i, j) != cell(b, i, j)) return false;
+		}
+	}
+	return true;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const string& what) {
+	cout << what << ": " << (ok ? "ok" : "FAILED") << endl;
+	failures += !ok;
+}
+
+static void roundTrip(uint8_t** board, const string& format) {
+	stringstream file;
+	if (format == "rle") writeRLE(file, board, SIZE, SIZE, "B3/S23");
+	if (format == "plaintext") writePlaintext(file, board, SIZE, SIZE);
+	if (format == "life106") writeLife106(file, board, SIZE, SIZE);
+	if (format == "mc") writeMacrocell(file, board, SIZE, SIZE, "B3/S23");
+
+	uint8_t** read = newBoard(SIZE);
+	PackedSink sink(read, SIZE, SIZE, 0, 0);
+	PatternInfo info;
+	bool ok = readPattern(file, sink, info);
+	check(ok && info.format == format && same(board, read, SIZE) && sink.getClipped() == 0, format + " round trip");
+	deleteBoard(read, SIZE);
+}
+
+int main(int argc, char* argv[]) {
+	uint8_t** board = newBoard(SIZE);
+	mt19937 eng(1);
+	for (int i = 0; i < SIZE; i++) {
+		for (int j = 0; j < SIZE; j++) {
+			// dense and empty regions, so runs, long gaps and empty rows all show up
+			bool alive = (i / 40) % 2 == 0 ? eng() % 3 == 0 : (i % 7 == 0 && j > 250);
+			if (alive) board[i+1][32 + j/8] |= 0x80 >> (j%8);
+		}
+	}
+	for (const char* format : { "rle", "plaintext", "life106", "mc" }) {
+		roundTrip(board, format);
+	}
+	deleteBoard(board, SIZE);
+
+	// multi digit counts before $ and b, comments, a header, and a count split from its tag by a line break
+	{
+		stringstream file("#N test\n#C comment\nx = 13, y = 15, rule = B36/S23\nbo$2bo12$3o$12\nbo!\n");
+		uint8_t** read = newBoard(SIZE);
+		PackedSink sink(read, SIZE, SIZE, 0, 0);
+		PatternInfo info;
+		bool ok = readPattern(file, sink, info);
+		ok = ok && info.rule == "B36/S23" && info.width == 13 && info.height == 15;
+		ok = ok && cell(read, 0, 1) && cell(read, 1, 2) && cell(read, 13, 0) && cell(read, 13, 1) && cell(read, 13, 2);
+		ok = ok && cell(read, 14, 12) && !cell(read, 2, 0) && !cell(read, 12, 0);
+		check(ok, "rle corner cases");
+		deleteBoard(read, SIZE);
+	}
+
+	// cells off every edge are dropped and counted, not written past the rows
+	{
+		stringstream file("#Life 1.06\n-1 0\n0 0\n299 299\n300 5\n5 -3\n");
+		uint8_t** read = newBoard(SIZE);
+		PackedSink sink(read, SIZE, SIZE, 0, 0);
+		PatternInfo info;
+		bool ok = readPattern(file, sink, info);
+		check(ok && sink.getClipped() == 3 && cell(read, 0, 0) && cell(read, 299, 299), "clipping");
+		deleteBoard(read, SIZE);
+	}
+
+	{
+		stringstream file("x = 3, y = 1\n3q!");
+		uint8_t** read = newBoard(SIZE);
+		PackedSink sink(read, SIZE, SIZE, 0, 0);
+		PatternInfo info;
+		check(!readPattern(file, sink, info) && !info.error.empty(), "bad rle is an error");
+		deleteBoard(read, SIZE);
+	}
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <vector>
+
+#include "../soup_search.h"
+#include "../utility/life_kernel.h"
+
+// every soup's census line has to match running the same seed alone, a cell at a time, in an arena with dead cells
+// past the edges and looking for the nearest exact repeat: for every kernel, with arenas packed next to each other
+// along a strip (so nothing may leak over the dead byte between them), refilled as soups settle, and on several threads
+
+using namespace std;
+
+static SoupResult naive(uint64_t seed, int arenaSize, int soupSize, int64_t maxGenerations) {
+	const int width = arenaSize + 2; // a dead cell all round
+	vector<uint8_t> cells(width * width, 0);
+	vector<uint8_t> start = SoupSearch::soup(seed, soupSize);
+	const int offset = (arenaSize - soupSize) / 2;
+	for (int i = 0; i < soupSize; i++) {
+		for (int j = 0; j < soupSize; j++) cells[(offset+i+1)*width + offset+j+1] = start[i*soupSize + j];
+	}
+
+	vector<vector<uint8_t>> history(SoupSearch::MAX_PERIOD);
+	vector<uint64_t> populations(SoupSearch::MAX_PERIOD);
+	history[0] = cells;
+	populations[0] = soupSize * soupSize; // not compared before it's overwritten, only needs to be something
+
+	SoupResult result;
+	result.seed = seed;
+	for (int64_t generation = 1; ; generation++) {
+		vector<uint8_t> next(width * width, 0);
+		uint64_t population = 0;
+		for (int i = 1; i <= arenaSize; i++) {
+			for (int j = 1; j <= arenaSize; j++) {
+				int n = 0;
+				for (int di = -1; di <= 1; di++) {
+					for (int dj = -1; dj <= 1; dj++) n += (di || dj) && cells[(i+di)*width + j+dj];
+				}
+				uint8_t alive = n == 3 || (n == 2 && cells[i*width + j]);
+				next[i*width + j] = alive;
+				population += alive;
+			}
+		}
+		cells.swap(next);
+
+		int period = 0;
+		for (int p = 1; p <= min<int64_t>(generation, SoupSearch::MAX_PERIOD) && period == 0; p++) {
+			const int slot = (generation - p) % SoupSearch::MAX_PERIOD;
+			if (populations[slot] == population && history[slot] == cells) period = p;
+		}
+		history[generation % SoupSearch::MAX_PERIOD] = cells;
+		populations[generation % SoupSearch::MAX_PERIOD] = population;
+		if (period || generation >= maxGenerations) {
+			result.stabilized = period ? generation - period : -1;
+			result.period = period;
+			result.population = population;
+			return result;
+		}
+	}
+}
+
+static bool same(const SoupResult& a, const SoupResult& b) {
+	return a.seed == b.seed && a.stabilized == b.stabilized && a.period == b.period && a.population == b.population;
+}
+
+static int checkSearch(const LifeKernel* kernel, int arenaSize, int soupSize, int64_t maxGenerations, int threads,
+		const vector<SoupResult>& expected) {
+	SoupSearch search(arenaSize, soupSize, kernel);
+	search.setThreadCount(threads);
+	search.setMaxGenerations(maxGenerations);
+	vector<SoupResult> results = search.run(expected[0].seed, expected.size());
+
+	cout << "  " << arenaSize << " arena, " << soupSize << " soup, " << threads << " threads: ";
+	for (size_t s = 0; s < expected.size(); s++) {
+		if (!same(results[s], expected[s])) {
+			cout << "FAILED" << endl << "    seed " << expected[s].seed << " should be stabilized " << expected[s].stabilized;
+			cout << ", period " << expected[s].period << ", population " << expected[s].population << " but is ";
+			cout << results[s].stabilized << ", " << results[s].period << ", " << results[s].population << endl;
+			return 1;
+		}
+	}
+	cout << "ok" << endl;
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	int failures = 0;
+
+	struct Case { int arenaSize, soupSize, soups; int64_t maxGenerations; };
+	// the last one cuts soups off before most of them settle
+	const vector<Case> cases = { { 64, 16, 120, 5000 }, { 64, 21, 60, 5000 }, { 256, 16, 12, 5000 }, { 64, 16, 60, 40 } };
+
+	vector<vector<SoupResult>> expected;
+	int stabilized = 0;
+	for (const Case& c : cases) {
+		expected.emplace_back();
+		for (int s = 0; s < c.soups; s++) {
+			expected.back().push_back(naive(1000 + s, c.arenaSize, c.soupSize, c.maxGenerations));
+			stabilized += expected.back().back().period != 0;
+		}
+	}
+	cout << stabilized << " soups settled on their own" << endl;
+
+	const LifeKernel* kernels[8];
+	int kernelCount = LifeKernel::supported(kernels);
+	for (int k = 0; k < kernelCount; k++) {
+		cout << kernels[k]->name() << endl;
+		for (size_t c = 0; c < cases.size(); c++) {
+			for (int threads : { 1, 3 }) {
+				failures += checkSearch(kernels[k], cases[c].arenaSize, cases[c].soupSize, cases[c].maxGenerations, threads,
+					expected[c]);
+			}
+		}
+	}
+
+	return failures == 0 ? 0 : 1;
+}
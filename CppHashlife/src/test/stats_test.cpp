@@ -0,0 +1,150 @@
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../simd_life.h"
+#include "../utility/life_kernel.h"
+
+// the counts tick makes while stats are enabled have to match counting every cell of the board and the one before it,
+// for every kernel, with an odd number of words a row (AVX-512's half word), on a torus, with single and blocked ticks,
+// several threads, beacons in tiles which go quiet (so their counts come from 2 generations ago), cells set between
+// ticks, and stats turned off and back on. counting only every few ticks has to give the same counts on the ticks
+// which are counted and leave the last ones alone on the rest
+
+using namespace std;
+
+const int GENERATIONS = 80;
+
+static vector<uint8_t> cellsOf(const SIMDLife& life) {
+	vector<uint8_t> cells(life.getSize() * life.getSize());
+	for (int i = 0; i < life.getSize(); i++) {
+		for (int j = 0; j < life.getSize(); j++) cells[i * life.getSize() + j] = life.getCell(i, j);
+	}
+	return cells;
+}
+
+static SIMDLife::GenerationStats countCells(const vector<uint8_t>& before, const vector<uint8_t>& after, int size) {
+	SIMDLife::GenerationStats stats;
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) {
+			uint8_t was = before[i * size + j];
+			uint8_t is = after[i * size + j];
+			stats.population += is;
+			stats.births += is && !was;
+			stats.deaths += was && !is;
+			if (!is) continue;
+			if (stats.top < 0) stats.top = i;
+			stats.bottom = i;
+			if (stats.left < 0 || j < stats.left) stats.left = j;
+			stats.right = max(stats.right, j);
+		}
+	}
+	return stats;
+}
+
+static bool same(const SIMDLife::GenerationStats& a, const SIMDLife::GenerationStats& b) {
+	return a.population == b.population && a.births == b.births && a.deaths == b.deaths
+		&& a.top == b.top && a.bottom == b.bottom && a.left == b.left && a.right == b.right;
+}
+
+static void print(const char* what, const SIMDLife::GenerationStats& s) {
+	cout << "    " << what << ": population " << s.population << ", births " << s.births << ", deaths " << s.deaths;
+	cout << ", rows " << s.top << " to " << s.bottom << ", columns " << s.left << " to " << s.right << endl;
+}
+
+static int checkStats(int size, const LifeKernel* kernel, SIMDLife::Topology topology, int generationsPerTick, int threads,
+		int statsEvery, random_device& rd) {
+	mt19937 eng(size + generationsPerTick * 10 + threads);
+	SIMDLife counted(size, rd);
+	SIMDLife reference(size, rd);
+	for (SIMDLife* life : { &counted, &reference }) {
+		life->setup();
+		life->setKernel(kernel);
+		life->setTopology(topology);
+	}
+	counted.setThreadCount(threads);
+	counted.setGenerationsPerTick(generationsPerTick);
+	counted.setStatsEnabled(true);
+	counted.setStatsEvery(statsEvery);
+
+	// a soup in the top left quarter, beacons alone in their tiles further down
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) {
+			bool alive = i < size/2 && j < size/2 && eng() % 3 == 0;
+			// two blocks touching at a corner, 6 cells then 8, so births and deaths differ
+			int r = i % 64 - 40, c = j % 256 - 100;
+			bool beacon = i >= size/2 + 40 && r >= 0 && r < 4 && c >= 0 && c < 4 && (r < 2) == (c < 2);
+			counted.setCell(i, j, alive || beacon);
+			reference.setCell(i, j, alive || beacon);
+		}
+	}
+
+	int ticks = 0; // since stats were last enabled
+	for (int gen = 0; gen < GENERATIONS; gen += generationsPerTick) {
+		if (gen == 40) {
+			// a block dropped into a quiet tile, and stats off for a tick
+			for (SIMDLife* life : { &counted, &reference }) {
+				life->setCell(size - 20, size - 20, true);
+				life->setCell(size - 20, size - 19, true);
+				life->setCell(size - 19, size - 20, true);
+				life->setCell(size - 19, size - 19, true);
+			}
+			counted.setStatsEnabled(false);
+			counted.tick();
+			for (int g = 0; g < generationsPerTick; g++) reference.tick();
+			counted.setStatsEnabled(true);
+			ticks = 0;
+			continue;
+		}
+
+		for (int g = 0; g < generationsPerTick - 1; g++) reference.tick();
+		vector<uint8_t> before = cellsOf(reference);
+		reference.tick();
+		counted.tick();
+		// every statsEvery-th tick from the first one is counted, and the one before it
+		const int phase = ticks++ % statsEvery;
+		if (phase != 0 && phase != statsEvery - 1) {
+			if (counted.getStats().generation != counted.getGeneration()) continue;
+			cout << "  generation " << gen + generationsPerTick << " was counted" << endl;
+			return 1;
+		}
+
+		SIMDLife::GenerationStats expected = countCells(before, cellsOf(reference), size);
+		SIMDLife::GenerationStats actual = counted.getStats();
+		if (!same(expected, actual) || actual.generation != counted.getGeneration()) {
+			cout << "  stats differ at generation " << gen + generationsPerTick << endl;
+			print("expected", expected);
+			print("counted", actual);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	random_device rd;
+	int failures = 0;
+
+	const LifeKernel* kernels[8];
+	int kernelCount = LifeKernel::supported(kernels);
+	for (int k = 0; k < kernelCount; k++) {
+		cout << kernels[k]->name() << endl;
+		for (SIMDLife::Topology topology : { SIMDLife::BOUNDED, SIMDLife::TORUS }) {
+			for (int size : { 512, 768 }) {
+				for (int generationsPerTick : { 1, 3 }) {
+					for (int threads : { 1, 3 }) {
+						// counting every tick, then every 4th with the same threads so the cost stays the same
+						int statsEvery = threads == 1 ? 1 : 4;
+						int failed = checkStats(size, kernels[k], topology, generationsPerTick, threads, statsEvery, rd);
+						cout << "  " << (topology == SIMDLife::TORUS ? "torus " : "bounded ") << size << ", ";
+						cout << generationsPerTick << " generations per tick, " << threads << " threads, ";
+						cout << "counting every " << statsEvery << ": " << (failed ? "FAILED" : "ok") << endl;
+						failures += failed;
+					}
+				}
+			}
+		}
+	}
+
+	return failures == 0 ? 0 : 1;
+}
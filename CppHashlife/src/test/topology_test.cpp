@@ -0,0 +1,173 @@
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../basic_life.h"
+#include "../simd_life.h"
+#include "../utility/life_kernel.h"
+
+// a torus has to match stepping every cell on its own with the neighbours taken mod the size, for every kernel,
+// with an odd number of words a row (AVX-512's half word), single and blocked ticks and several threads,
+// and a growing board has to match a board big enough to never need to grow, with gliders flying off every edge
+
+using namespace std;
+
+const int GENERATIONS = 60;
+
+// the naive torus, one byte per cell
+struct Torus {
+	int size;
+	vector<uint8_t> cells;
+
+	Torus(int size) : size(size), cells(size * size) {}
+
+	uint8_t& at(int row, int column) {
+		return cells[((row + size) % size) * size + (column + size) % size];
+	}
+
+	void tick(const LifeRule& rule) {
+		vector<uint8_t> next(size * size);
+		for (int i = 0; i < size; i++) {
+			for (int j = 0; j < size; j++) {
+				int neighbours = 0;
+				for (int di = -1; di <= 1; di++) {
+					for (int dj = -1; dj <= 1; dj++) {
+						if (di != 0 || dj != 0) neighbours += at(i + di, j + dj);
+					}
+				}
+				next[i * size + j] = rule.next(at(i, j), neighbours);
+			}
+		}
+		cells.swap(next);
+	}
+};
+
+static int checkTorus(int size, const LifeKernel* kernel, int generationsPerTick, int threads, random_device& rd) {
+	mt19937 eng(size + generationsPerTick * 10 + threads);
+	Torus expected(size);
+	SIMDLife simd(size, rd);
+	simd.setup();
+	simd.setKernel(kernel);
+	simd.setThreadCount(threads);
+	simd.setGenerationsPerTick(generationsPerTick);
+	simd.setTopology(SIMDLife::TORUS);
+
+	// busy near the edges so plenty crosses them, sparse inside so most tiles go quiet
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) {
+			bool nearEdge = i < 24 || i >= size-24 || j < 24 || j >= size-24;
+			bool alive = nearEdge ? eng() % 3 == 0 : eng() % 64 == 0;
+			expected.at(i, j) = alive;
+			simd.setCell(i, j, alive);
+		}
+	}
+
+	for (int gen = 0; gen < GENERATIONS; gen += generationsPerTick) {
+		for (int g = 0; g < generationsPerTick; g++) expected.tick(kernel->getRule());
+		simd.tick();
+		for (int i = 0; i < size; i++) {
+			for (int j = 0; j < size; j++) {
+				if (expected.at(i, j) != simd.getCell(i, j)) {
+					cout << "torus differs at generation " << gen + generationsPerTick << " (" << i << ", " << j << ")" << endl;
+					return 1;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+// gliders leaving by every edge and corner, on a board which starts small
+static int checkGrowing(int generationsPerTick, random_device& rd) {
+	const int size = 512;
+	const int bigSize = 2048;
+	const int offset = (bigSize - size) / 2;
+	const int generations = 400;
+
+	SIMDLife growing(size, rd);
+	BasicLife big(bigSize, rd);
+	growing.setup();
+	big.setup();
+	growing.setGenerationsPerTick(generationsPerTick);
+	growing.setTopology(SIMDLife::GROWING);
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) growing.setCell(i, j, false);
+	}
+	for (int i = 0; i < bigSize; i++) {
+		for (int j = 0; j < bigSize; j++) big.setCell(i, j, false);
+	}
+
+	const int glider[5][2] = { { 0, 1 }, { 1, 2 }, { 2, 0 }, { 2, 1 }, { 2, 2 } }; // heading down and right
+	const int places[8][4] = {
+		// row, column, row direction, column direction
+		{ 4, 4, -1, -1 }, { 4, size-7, -1, 1 }, { size-7, 4, 1, -1 }, { size-7, size-7, 1, 1 },
+		{ 4, 200, -1, 1 }, { size-7, 300, 1, -1 }, { 250, 2, 1, -1 }, { 120, size-5, -1, 1 },
+	};
+	for (auto& place : places) {
+		for (auto& cell : glider) {
+			int row = place[0] + (place[2] > 0 ? cell[0] : 2 - cell[0]);
+			int column = place[1] + (place[3] > 0 ? cell[1] : 2 - cell[1]);
+			growing.setCell(row, column, true);
+			big.setCell(row + offset, column + offset, true);
+		}
+	}
+
+	for (int gen = 0; gen < generations; gen += generationsPerTick) {
+		for (int g = 0; g < generationsPerTick; g++) big.tick();
+		growing.tick();
+	}
+
+	// every cell of the growing board against the same cell of the big one, and nothing alive outside it
+	const int shift = offset - growing.getGrowth();
+	int alive = 0;
+	int bigAlive = 0;
+	for (int i = 0; i < growing.getSize(); i++) {
+		for (int j = 0; j < growing.getSize(); j++) {
+			alive += growing.getCell(i, j);
+			if (growing.getCell(i, j) != big.getCell(i + shift, j + shift)) {
+				cout << "growing differs at (" << i << ", " << j << ")" << endl;
+				return 1;
+			}
+		}
+	}
+	for (int i = 0; i < bigSize; i++) {
+		for (int j = 0; j < bigSize; j++) bigAlive += big.getCell(i, j);
+	}
+	if (alive != bigAlive || alive != 8*5 || growing.getSize() == size) {
+		cout << "growing lost cells, " << alive << " alive against " << bigAlive << ", size " << growing.getSize() << endl;
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	random_device rd;
+	int failures = 0;
+
+	LifeRule highLife = HIGHLIFE;
+	for (const LifeRule& rule : { CONWAY, highLife }) {
+		const LifeKernel* kernels[8];
+		int kernelCount = LifeKernel::supported(kernels, rule);
+		for (int k = 0; k < kernelCount; k++) {
+			cout << kernels[k]->name() << " " << rule.toString() << endl;
+			for (int size : { 256, 512, 768 }) {
+				for (int generationsPerTick : { 1, 5 }) {
+					for (int threads : { 1, 3 }) {
+						int failed = checkTorus(size, kernels[k], generationsPerTick, threads, rd);
+						cout << "  torus " << size << ", " << generationsPerTick << " generations per tick, " << threads << " threads: ";
+						cout << (failed ? "FAILED" : "ok") << endl;
+						failures += failed;
+					}
+				}
+			}
+		}
+	}
+
+	for (int generationsPerTick : { 1, 4 }) {
+		int failed = checkGrowing(generationsPerTick, rd);
+		cout << "growing, " << generationsPerTick << " generations per tick: " << (failed ? "FAILED" : "ok") << endl;
+		failures += failed;
+	}
+
+	return failures == 0 ? 0 : 1;
+}
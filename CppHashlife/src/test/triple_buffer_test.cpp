@@ -0,0 +1,67 @@
+#include <stdint.h>
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+#include "../utility/triple_buffer.h"
+
+// a writer fills whole frames with its frame number as fast as it can while a reader checks them,
+// the reader must never see a torn frame, a frame go backwards, or the writer's slot
+
+using namespace std;
+
+const int FRAME_WORDS = 4096;
+const uint64_t FRAMES = 200000;
+
+int main(int argc, char* argv[]) {
+	static uint64_t slots[3][FRAME_WORDS] = {};
+	TripleBuffer buffer;
+	atomic<bool> done(false);
+	uint64_t dropped = 0;
+
+	thread writer([&]() {
+		for (uint64_t frame = 1; frame <= FRAMES; frame++) {
+			uint64_t* slot = slots[buffer.getBack()];
+			for (int i = 0; i < FRAME_WORDS; i++) {
+				slot[i] = frame;
+			}
+			dropped += buffer.publish();
+		}
+		done = true;
+	});
+
+	int failures = 0;
+	uint64_t last = 0;
+	uint64_t taken = 0;
+	bool finished = false;
+	while (!finished) {
+		finished = done; // one last acquire after the writer stops, which has to get the final frame
+		if (!buffer.acquire()) continue;
+		taken++;
+		const uint64_t* slot = slots[buffer.getFront()];
+		uint64_t frame = slot[0];
+		for (int i = 0; i < FRAME_WORDS; i++) {
+			if (slot[i] != frame) {
+				if (failures++ < 5) cout << "frame " << frame << " torn at word " << i << endl;
+				break;
+			}
+		}
+		if (frame <= last) {
+			if (failures++ < 5) cout << "frame " << frame << " after " << last << endl;
+		}
+		last = frame;
+	}
+	writer.join();
+
+	if (last != FRAMES) {
+		cout << "last frame read was " << last << " not " << FRAMES << endl;
+		failures++;
+	}
+	if (taken + dropped != FRAMES) {
+		cout << taken << " taken and " << dropped << " dropped don't add up to " << FRAMES << endl;
+		failures++;
+	}
+	cout << taken << " frames taken, " << dropped << " dropped: " << (failures == 0 ? "ok" : "FAILED") << endl;
+
+	return failures == 0 ? 0 : 1;
+}
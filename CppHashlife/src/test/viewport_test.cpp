@@ -0,0 +1,105 @@
+#include <string.h>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../utility/viewport.h"
+
+// renderView has to agree with counting cells one at a time, at every zoom, in both zoomed out modes,
+// with the view off any word boundary and hanging off the edge of a board which is smaller than it
+
+using namespace std;
+
+const int WINDOW = 256;
+
+static bool cell(uint8_t** cells, int size, int64_t row, int64_t column) {
+	if (row < 0 || row >= size || column < 0 || column >= size) return false;
+	return (cells[row+1][32 + column/8] >> (7 - column%8)) & 1;
+}
+
+static int check(uint8_t** cells, int size, const Viewport& view) {
+	vector<uint8_t> out(WINDOW * WINDOW);
+	ViewImage image;
+	renderView(cells, size, view, WINDOW, out.data(), image);
+
+	int wrong = 0;
+	if (view.zoom >= 0) {
+		int count = WINDOW >> view.zoom;
+		wrong += image.density || image.width != count || image.height != count;
+		for (int p = 0; p < count; p++) {
+			for (int x = 0; x < count; x++) {
+				bool got = (out[p * count/8 + x/8] >> (7 - x%8)) & 1;
+				wrong += got != cell(cells, size, view.row + p, view.column + x);
+			}
+		}
+		return wrong;
+	}
+
+	int64_t block = (int64_t)1 << -view.zoom;
+	wrong += image.density != view.density || image.width != WINDOW || image.height != WINDOW;
+	for (int p = 0; p < WINDOW; p++) {
+		for (int x = 0; x < WINDOW; x++) {
+			uint64_t alive = 0;
+			for (int64_t i = 0; i < block && view.row + p*block < size && view.column + x*block < size; i++) {
+				for (int64_t j = 0; j < block; j++) {
+					alive += cell(cells, size, view.row + p*block + i, view.column + x*block + j);
+				}
+			}
+			if (view.density) {
+				uint8_t expected = alive == 0 ? 0 : 64 + (191 * alive) / (block * block);
+				wrong += out[p * WINDOW + x] != expected;
+			} else {
+				bool got = (out[p * WINDOW/8 + x/8] >> (7 - x%8)) & 1;
+				wrong += got != (alive > 0);
+			}
+		}
+	}
+	return wrong;
+}
+
+int main(int argc, char* argv[]) {
+	const int size = 2048 + 200; // not a power of 2, so the widest zooms run off the board
+	uint8_t** cells = new uint8_t*[size+2];
+	mt19937 eng(1);
+	for (int i = 0; i < size+2; i++) {
+		cells[i] = new uint8_t[(size+7)/8+33];
+		memset(cells[i], 0, (size+7)/8+33);
+		for (int j = 0; j < size && i > 0 && i < size+1; j++) {
+			// sparse with dense stripes, so blocks go from empty to full
+			bool alive = (j / 100) % 3 == 0 ? eng() % 2 == 0 : eng() % 50 == 0;
+			if (alive) cells[i][32 + j/8] |= 0x80 >> (j%8);
+		}
+	}
+
+	int failures = 0;
+	for (int zoom = -7; zoom <= 3; zoom++) {
+		for (bool density : { true, false }) {
+			if (zoom >= 0 && !density) continue;
+			Viewport view;
+			view.zoom = zoom;
+			view.density = density;
+			view.row = 37;
+			view.column = 163;
+			view.clamp(size, WINDOW);
+			int wrong = check(cells, size, view);
+			cout << "zoom " << zoom << (density ? " density" : " any") << ": " << (wrong == 0 ? "ok" : "FAILED") << endl;
+			failures += wrong != 0;
+		}
+	}
+
+	// zooming keeps the cell under the pointer, and never goes further out than the whole board
+	Viewport view;
+	view.zoomAt(100, 50, 2, size, WINDOW);
+	view.zoomAt(100, 50, -1, size, WINDOW);
+	bool ok = view.zoom == 1 && view.row + 50/2 == 50 && view.column + 100/2 == 100;
+	view.zoomAt(0, 0, -10, size, WINDOW);
+	ok = ok && view.zoom == -4 && view.row == 0 && view.column == 0;
+	cout << "zoom at the pointer: " << (ok ? "ok" : "FAILED") << endl;
+	failures += !ok;
+
+	for (int i = 0; i < size+2; i++) {
+		delete[] cells[i];
+	}
+	delete[] cells;
+	return failures == 0 ? 0 : 1;
+}
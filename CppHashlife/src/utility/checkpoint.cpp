@@ -0,0 +1,105 @@
+#include "checkpoint.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+static const char MAGIC[8] = { 'H', 'L', 'C', 'H', 'E', 'C', 'K', '\n' };
+
+// what's at the start of the header page, the rest of the page is zero
+struct Header {
+	char magic[8];
+	uint32_t version;
+	int32_t size;
+	uint64_t generation;
+	uint16_t birth;
+	uint16_t survival;
+	int32_t topology;
+	int32_t growth;
+	int32_t stride; // to catch a file written with a different RowArena layout
+};
+
+static const int ROW_ALIGNED_BYTE = 32;
+
+bool writeCheckpoint(const std::string& path, const Checkpoint& checkpoint, uint8_t* const* rows, std::string& error) {
+	const int rowLen = checkpoint.size/8+33;
+	const int stride = RowArena::strideFor(rowLen);
+	const std::string temp = path + ".tmp";
+	FILE* file = fopen(temp.c_str(), "wb");
+	if (file == nullptr) {
+		error = "can't open " + temp;
+		return false;
+	}
+
+	std::vector<uint8_t> page(Checkpoint::HEADER_BYTES + RowArena::leadFor(ROW_ALIGNED_BYTE));
+	Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = Checkpoint::VERSION;
+	header.size = checkpoint.size;
+	header.generation = checkpoint.generation;
+	header.birth = checkpoint.rule.birth;
+	header.survival = checkpoint.rule.survival;
+	header.topology = checkpoint.topology;
+	header.growth = checkpoint.growth;
+	header.stride = stride;
+	memcpy(page.data(), &header, sizeof(header));
+	bool ok = fwrite(page.data(), 1, page.size(), file) == page.size();
+
+	// rows go out a stride at a time, the padding after each is zero
+	std::vector<uint8_t> row(stride, 0);
+	for (int i = 0; i < checkpoint.size+2 && ok; i++) {
+		memcpy(row.data(), rows[i], rowLen);
+		ok = fwrite(row.data(), 1, stride, file) == (size_t)stride;
+	}
+	ok = fflush(file) == 0 && ok;
+#ifdef __linux__
+	ok = ok && fsync(fileno(file)) == 0;
+#endif
+	ok = fclose(file) == 0 && ok;
+	if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+		remove(temp.c_str());
+		error = "couldn't write " + path;
+		return false;
+	}
+	return true;
+}
+
+bool readCheckpointInfo(const std::string& path, Checkpoint& checkpoint, std::string& error) {
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr) {
+		error = "can't open " + path;
+		return false;
+	}
+	Header header;
+	bool read = fread(&header, 1, sizeof(header), file) == sizeof(header);
+	fclose(file);
+
+	if (!read || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+		error = path + " isn't a checkpoint";
+		return false;
+	}
+	if (header.version != Checkpoint::VERSION || header.size <= 0 || header.stride != RowArena::strideFor(header.size/8+33)) {
+		error = path + " is a checkpoint from a different version";
+		return false;
+	}
+	checkpoint.generation = header.generation;
+	checkpoint.size = header.size;
+	checkpoint.rule.birth = header.birth;
+	checkpoint.rule.survival = header.survival;
+	checkpoint.topology = header.topology;
+	checkpoint.growth = header.growth;
+	return true;
+}
+
+bool mapCheckpoint(const std::string& path, Checkpoint& checkpoint, RowArena& rows, std::string& error) {
+	if (!readCheckpointInfo(path, checkpoint, error)) return false;
+	if (!RowArena::fromFile(path.c_str(), Checkpoint::HEADER_BYTES, checkpoint.size+2, checkpoint.size/8+33, ROW_ALIGNED_BYTE, rows)) {
+		error = path + " is cut short";
+		return false;
+	}
+	return true;
+}
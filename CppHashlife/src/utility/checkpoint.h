@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#include "life_rule.h"
+#include "row_arena.h"
+
+// a packed board on disk: a HEADER_BYTES header, then size+2 rows of size/8+33 bytes laid out exactly as RowArena lays
+// them out in memory (data from byte 32 on a cache line, a fixed stride apart), so restoring maps the file as the board
+// instead of reading and copying it. the header is written in this machine's byte order
+struct Checkpoint {
+	static const int HEADER_BYTES = 4096; // a page, so the rows can be mapped
+	static const int VERSION = 1;
+
+	uint64_t generation = 0;
+	int32_t size = 0;
+	LifeRule rule = CONWAY;
+	int32_t topology = 0; // a SIMDLife::Topology
+	int32_t growth = 0;
+};
+
+// writes to path.tmp and renames it over path once it's all on disk, so a crash part way leaves the last checkpoint alone
+bool writeCheckpoint(const std::string& path, const Checkpoint& checkpoint, uint8_t* const* rows, std::string& error);
+
+// just the header, false with an error if path isn't a checkpoint this version can read
+bool readCheckpointInfo(const std::string& path, Checkpoint& checkpoint, std::string& error);
+
+// the header, and the rows mapped copy on write (see RowArena::fromFile)
+bool mapCheckpoint(const std::string& path, Checkpoint& checkpoint, RowArena& rows, std::string& error);
@@ -0,0 +1,39 @@
+#include "life_kernel.h"
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+typedef const LifeKernel* (*KernelFactory)(const LifeRule& rule);
+
+static bool hasAvx2() {
+	return __builtin_cpu_supports("avx2");
+}
+
+static bool hasAvx512() {
+	return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl");
+}
+
+// kernels for uncommon rules are built on first use, and kept for as long as the program runs
+static const LifeKernel* cached(KernelFactory factory, const LifeRule& rule) {
+	static std::mutex mutex;
+	static std::map<std::pair<KernelFactory, LifeRule>, const LifeKernel*> kernels;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	const LifeKernel*& kernel = kernels[std::make_pair(factory, rule)];
+	if (kernel == nullptr) kernel = factory(rule);
+	return kernel;
+}
+
+const LifeKernel* LifeKernel::best(const LifeRule& rule) {
+	static const KernelFactory factory = hasAvx512() ? avx512Kernel : (hasAvx2() ? avx2Kernel : swarKernel);
+	return cached(factory, rule);
+}
+
+int LifeKernel::supported(const LifeKernel** kernels, const LifeRule& rule) {
+	int count = 0;
+	kernels[count++] = cached(swarKernel, rule);
+	if (hasAvx2()) kernels[count++] = cached(avx2Kernel, rule);
+	if (hasAvx512()) kernels[count++] = cached(avx512Kernel, rule);
+	return count;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include "life_rule.h"
+
+// what LifeKernel::nextRowsCounted adds up for each word it writes
+struct WordStats {
+	uint64_t population = 0; // live cells in the new generation
+	uint64_t births = 0;
+	uint64_t previous = 0; // live cells in the old generation, if they were asked for, deaths are births + previous - population
+	int top = -1; // the first and last row with a live cell, -1 if there are none
+	int bottom = -1;
+	int left = -1; // the first and last column in the word with a live cell, from 0 to 255
+	int right = -1;
+};
+
+// the Life rule on packed rows of cells, 8 cells per byte, MSB first
+// rows need at least 32 bytes of padding before the first word and 1 byte after the last one
+// each backend lives in its own file which is the only one targeting that instruction set,
+// so the rest of the program runs on any x86-64 and picks a backend at startup
+class LifeKernel {
+public:
+	explicit LifeKernel(const LifeRule& rule) : rule(rule) {}
+	virtual ~LifeKernel() {}
+
+	virtual const char* name() const = 0;
+	const LifeRule& getRule() const { return rule; }
+
+	// steps `words` 256 cell words of cells[row], starting at byte `column`, writing them to out
+	// returns a bit for each word which is different to what was in out before, so words must be at most 64
+	virtual uint64_t nextWords(uint8_t** cells, int row, int column, int words, uint8_t* out) const = 0;
+
+	// the same, but each row is a ring of the bytes from rowStart to rowEnd: the cell left of the first one is the last one,
+	// and the other way round. the word at each end is copied next to the byte from the other end on the stack,
+	// so nothing in the row is written, rows wrap by the caller passing row pointers (cells[row-1] can be the last row)
+	virtual uint64_t nextWordsWrapped(uint8_t** cells, int row, int column, int words, uint8_t* out, int rowStart, int rowEnd) const = 0;
+
+	// nextWordsWrapped (or nextWords if rowEnd is 0) for rows firstRow to lastRow, each written to out[row],
+	// adding up what every word's new cells are like into stats[word] as it goes, from the vectors already in registers,
+	// the old generation's cells are only counted with countPrevious, a caller which already knows how many there were
+	// saves a popcount. returns the changed bits of every row or'd together
+	virtual uint64_t nextRowsCounted(uint8_t** cells, int firstRow, int lastRow, int column, int words, uint8_t** out,
+			int rowStart, int rowEnd, bool countPrevious, WordStats* stats) const = 0;
+
+	// each bit of `bytes` bytes of bits becomes a byte of 0x00 or 0xFF in pixels, bytes must be a multiple of 8
+	virtual void expand(const uint8_t* bits, int bytes, char* pixels) const = 0;
+
+	// the fastest kernel this cpu supports for a rule, the cpu is checked once with cpuid
+	static const LifeKernel* best(const LifeRule& rule = CONWAY);
+
+	// every kernel this cpu supports for a rule, slowest first
+	static int supported(const LifeKernel** kernels, const LifeRule& rule = CONWAY);
+
+private:
+	const LifeRule rule;
+
+};
+
+// Conway, HighLife, Day & Night and Seeds have their own compiled kernels, and these return the same one every time,
+// any other rule gets a new kernel each call, so use LifeKernel::best or supported, which keep them
+const LifeKernel* swarKernel(const LifeRule& rule);
+const LifeKernel* avx2Kernel(const LifeRule& rule);
+const LifeKernel* avx512Kernel(const LifeRule& rule);
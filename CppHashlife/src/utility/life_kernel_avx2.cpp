@@ -0,0 +1,132 @@
+#include "life_kernel.h"
+
+// only the code in this file uses these instructions, everything included above this is built for any x86-64
+#pragma GCC target("avx2")
+#include <immintrin.h>
+#include "life_kernel_network.h"
+
+namespace {
+
+struct Avx2 {
+	typedef __m256i Vec;
+	static const int WORDS = 1;
+
+	static Vec load(const uint8_t* p) { return _mm256_load_si256((const __m256i*)p); }
+	static void store(uint8_t* p, Vec v) { _mm256_store_si256((__m256i*)p, v); }
+	static Vec orv(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+	static Vec andv(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+	static Vec andnot(Vec a, Vec b) { return _mm256_andnot_si256(b, a); }
+	static Vec select(Vec a, Vec b, Vec c) { return _mm256_or_si256(_mm256_and_si256(a, b), _mm256_andnot_si256(a, c)); }
+	static Vec zero() { return _mm256_setzero_si256(); }
+	static Vec ones() { return _mm256_set1_epi8(0xFF); }
+
+	static uint64_t changed(Vec a, Vec b) {
+		auto diff = _mm256_xor_si256(a, b);
+		return !_mm256_testz_si256(diff, diff);
+	}
+
+	// the byte before the word is already in the row (the left padding for the first word), so an unaligned load lines it up
+	static Vec shiftRight(const uint8_t* rawBits, Vec bits) {
+		auto before = _mm256_loadu_si256((const __m256i*)(rawBits - 1));							// byte k of before is byte k-1 of bits
+		auto inByte = _mm256_and_si256(_mm256_srli_epi16(bits, 1), _mm256_set1_epi8(0x7F));		// MSB is cell 0, so a right shift moves cells right
+		auto fromBefore = _mm256_and_si256(_mm256_slli_epi16(before, 7), _mm256_set1_epi8(0x80));	// last cell of the byte before becomes the first cell
+		return _mm256_or_si256(inByte, fromBefore);
+	}
+
+	static Vec shiftLeft(const uint8_t* rawBits, Vec bits) {
+		auto after = _mm256_loadu_si256((const __m256i*)(rawBits + 1));							// byte k of after is byte k+1 of bits
+		auto inByte = _mm256_and_si256(_mm256_slli_epi16(bits, 1), _mm256_set1_epi8(0xFE));
+		auto fromAfter = _mm256_and_si256(_mm256_srli_epi16(after, 7), _mm256_set1_epi8(0x01));
+		return _mm256_or_si256(inByte, fromAfter);
+	}
+
+	// each nibble looked up in a table of counts
+	static Vec byteCounts(Vec bits) {
+		const auto table = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4, 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+		const auto low = _mm256_set1_epi8(0x0F);
+		auto lo = _mm256_shuffle_epi8(table, _mm256_and_si256(bits, low));
+		auto hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(bits, 4), low));
+		return _mm256_add_epi8(lo, hi);
+	}
+
+	static Vec addBytes(Vec a, Vec b) { return _mm256_add_epi8(a, b); }
+
+	static void wordSums(Vec counts, uint64_t* sums) {
+		auto lanes = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+		auto pair = _mm_add_epi64(_mm256_castsi256_si128(lanes), _mm256_extracti128_si256(lanes, 1));
+		sums[0] += _mm_cvtsi128_si64(pair) + _mm_extract_epi64(pair, 1);
+	}
+
+	static Vec rowIndex(int row) { return _mm256_set1_epi64x(row); }
+
+	// rows fit in the low 32 bits, which is all AVX2 has an unsigned min and max for
+	static void markRows(Vec bits, Vec row, Vec& first, Vec& last) {
+		auto empty = _mm256_cmpeq_epi64(bits, _mm256_setzero_si256());
+		first = _mm256_min_epu32(first, _mm256_or_si256(row, empty));
+		last = _mm256_max_epu32(last, _mm256_andnot_si256(empty, row));
+	}
+
+	// if we have exactly 3 neighbors we're def alive
+	// if we have 2 neighbors, and we're alive, we stay alive
+	static Vec conway(Vec moreThan0, Vec moreThan1, Vec moreThan2, Vec moreThan3, Vec state) {
+		auto twoMaybeThree = _mm256_andnot_si256(moreThan3, _mm256_and_si256(moreThan1, moreThan0));
+		auto exactlyThree = _mm256_and_si256(twoMaybeThree, moreThan2);
+		return _mm256_or_si256(exactlyThree, _mm256_and_si256(twoMaybeThree, state));
+	}
+};
+
+template <class R>
+class Avx2Kernel: public LifeKernel {
+public:
+	explicit Avx2Kernel(const LifeRule& rule) : LifeKernel(rule), logic(rule) {}
+
+	const char* name() const {
+		return "avx2";
+	}
+
+	uint64_t nextWords(uint8_t** cells, int row, int column, int words, uint8_t* out) const {
+		return nextWordsWith<Avx2>(cells, row, column, words, out, logic);
+	}
+
+	uint64_t nextWordsWrapped(uint8_t** cells, int row, int column, int words, uint8_t* out, int rowStart, int rowEnd) const {
+		return nextWordsWith<Avx2>(cells, row, column, words, out, logic, rowStart, rowEnd);
+	}
+
+	uint64_t nextRowsCounted(uint8_t** cells, int firstRow, int lastRow, int column, int words, uint8_t** out,
+			int rowStart, int rowEnd, bool countPrevious, WordStats* stats) const {
+		return nextRowsCountedWith<Avx2>(cells, firstRow, lastRow, column, words, out, logic, rowStart, rowEnd, countPrevious, stats);
+	}
+
+	void expand(const uint8_t* bits, int bytes, char* pixels) const {
+		__m256i maskBits = _mm256_set1_epi64x(0x0102040810204080LL);
+		__m256i zeros = _mm256_setzero_si256();
+		__m256i ones = _mm256_set1_epi8(0xFF);
+
+		for (int i = 0; i < bytes; i += 4) { // 4 bytes = 32 pixels at a time
+			uint8_t a = bits[i  ];
+			uint8_t b = bits[i+1];
+			uint8_t c = bits[i+2];
+			uint8_t d = bits[i+3];
+
+			__m256i fullBytes = _mm256_set_epi8( // not sure why reverse arg order needed
+				d, d, d, d, d, d, d, d,
+				c, c, c, c, c, c, c, c,
+				b, b, b, b, b, b, b, b,
+				a, a, a, a, a, a, a, a
+			);
+			fullBytes = _mm256_and_si256(fullBytes, maskBits);
+			fullBytes = _mm256_cmpeq_epi8(fullBytes, zeros);
+			fullBytes = _mm256_xor_si256(fullBytes, ones); // same as bitwise not
+			_mm256_storeu_si256((__m256i*)&pixels[i*8], fullBytes);
+		}
+	}
+
+private:
+	const R logic;
+};
+
+}
+
+const LifeKernel* avx2Kernel(const LifeRule& rule) {
+	return kernelForRule<Avx2Kernel>(rule);
+}
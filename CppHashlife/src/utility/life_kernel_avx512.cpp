@@ -0,0 +1,191 @@
+#include "life_kernel.h"
+
+// only the code in this file uses these instructions, everything included above this is built for any x86-64
+#pragma GCC target("avx2,avx512f,avx512bw,avx512vl")
+#include <immintrin.h>
+#include "life_kernel_network.h"
+
+// ternary logic does each mask-and-merge in the shifts, the final rule, and (by the compiler fusing pairs of the
+// sorting network's and/or whose middle result isn't used elsewhere) part of the CMP_SWAP network in one instruction
+namespace {
+
+const int SELECT = 0xCA;			// a ? b : c
+const int AND_AND_NOT = 0x40;		// a & b & ~c
+const int AND_OR = 0xE0;			// a & (b | c)
+const int AND_NOT = 0x30;			// a & ~b, c is ignored
+
+// 2 words at once
+struct Avx512 {
+	typedef __m512i Vec;
+	static const int WORDS = 2;
+
+	// rows are only 32 byte aligned
+	static Vec load(const uint8_t* p) { return _mm512_loadu_si512((const void*)p); }
+	static void store(uint8_t* p, Vec v) { _mm512_storeu_si512((void*)p, v); }
+	static Vec orv(Vec a, Vec b) { return _mm512_or_si512(a, b); }
+	static Vec andv(Vec a, Vec b) { return _mm512_and_si512(a, b); }
+	static Vec andnot(Vec a, Vec b) { return _mm512_ternarylogic_epi64(a, b, b, AND_NOT); }
+	static Vec select(Vec a, Vec b, Vec c) { return _mm512_ternarylogic_epi64(a, b, c, SELECT); }
+	static Vec zero() { return _mm512_setzero_si512(); }
+	static Vec ones() { return _mm512_set1_epi8(0xFF); }
+
+	static uint64_t changed(Vec a, Vec b) {
+		__mmask8 diff = _mm512_test_epi64_mask(_mm512_xor_si512(a, b), _mm512_xor_si512(a, b));
+		return ((diff & 0x0F) ? 1 : 0) | ((diff & 0xF0) ? 2 : 0);
+	}
+
+	static Vec shiftRight(const uint8_t* rawBits, Vec bits) {
+		auto before = _mm512_loadu_si512((const void*)(rawBits - 1));
+		return _mm512_ternarylogic_epi64(_mm512_set1_epi8(0x7F), _mm512_srli_epi16(bits, 1), _mm512_slli_epi16(before, 7), SELECT);
+	}
+
+	static Vec shiftLeft(const uint8_t* rawBits, Vec bits) {
+		auto after = _mm512_loadu_si512((const void*)(rawBits + 1));
+		return _mm512_ternarylogic_epi64(_mm512_set1_epi8(0xFE), _mm512_slli_epi16(bits, 1), _mm512_srli_epi16(after, 7), SELECT);
+	}
+
+	// each nibble looked up in a table of counts, the backend is picked without asking for the VPOPCNT extensions
+	static Vec byteCounts(Vec bits) {
+		const auto table = _mm512_broadcast_i32x4(_mm_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4));
+		const auto low = _mm512_set1_epi8(0x0F);
+		auto lo = _mm512_shuffle_epi8(table, _mm512_and_si512(bits, low));
+		auto hi = _mm512_shuffle_epi8(table, _mm512_and_si512(_mm512_srli_epi16(bits, 4), low));
+		return _mm512_add_epi8(lo, hi);
+	}
+
+	static Vec addBytes(Vec a, Vec b) { return _mm512_add_epi8(a, b); }
+
+	// the low 4 lanes are the first word
+	static void wordSums(Vec counts, uint64_t* sums) {
+		auto lanes = _mm512_sad_epu8(counts, _mm512_setzero_si512());
+		sums[0] += _mm512_mask_reduce_add_epi64(0x0F, lanes);
+		sums[1] += _mm512_mask_reduce_add_epi64(0xF0, lanes);
+	}
+
+	static Vec rowIndex(int row) { return _mm512_set1_epi64(row); }
+
+	static void markRows(Vec bits, Vec row, Vec& first, Vec& last) {
+		__mmask8 live = _mm512_test_epi64_mask(bits, bits);
+		first = _mm512_mask_min_epu64(first, live, first, row);
+		last = _mm512_mask_max_epu64(last, live, last, row);
+	}
+
+	static Vec conway(Vec moreThan0, Vec moreThan1, Vec moreThan2, Vec moreThan3, Vec state) {
+		auto twoMaybeThree = _mm512_ternarylogic_epi64(moreThan0, moreThan1, moreThan3, AND_AND_NOT);
+		return _mm512_ternarylogic_epi64(twoMaybeThree, moreThan2, state, AND_OR);
+	}
+};
+
+// the last word of a row with an odd number of words
+struct Avx512Half {
+	typedef __m256i Vec;
+	static const int WORDS = 1;
+
+	static Vec load(const uint8_t* p) { return _mm256_load_si256((const __m256i*)p); }
+	static void store(uint8_t* p, Vec v) { _mm256_store_si256((__m256i*)p, v); }
+	static Vec orv(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+	static Vec andv(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+	static Vec andnot(Vec a, Vec b) { return _mm256_andnot_si256(b, a); }
+	static Vec select(Vec a, Vec b, Vec c) { return _mm256_ternarylogic_epi64(a, b, c, SELECT); }
+	static Vec zero() { return _mm256_setzero_si256(); }
+	static Vec ones() { return _mm256_set1_epi8(0xFF); }
+
+	static uint64_t changed(Vec a, Vec b) {
+		auto diff = _mm256_xor_si256(a, b);
+		return !_mm256_testz_si256(diff, diff);
+	}
+
+	static Vec shiftRight(const uint8_t* rawBits, Vec bits) {
+		auto before = _mm256_loadu_si256((const __m256i*)(rawBits - 1));
+		return _mm256_ternarylogic_epi64(_mm256_set1_epi8(0x7F), _mm256_srli_epi16(bits, 1), _mm256_slli_epi16(before, 7), SELECT);
+	}
+
+	static Vec shiftLeft(const uint8_t* rawBits, Vec bits) {
+		auto after = _mm256_loadu_si256((const __m256i*)(rawBits + 1));
+		return _mm256_ternarylogic_epi64(_mm256_set1_epi8(0xFE), _mm256_slli_epi16(bits, 1), _mm256_srli_epi16(after, 7), SELECT);
+	}
+
+	static Vec byteCounts(Vec bits) {
+		const auto table = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4, 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+		const auto low = _mm256_set1_epi8(0x0F);
+		auto lo = _mm256_shuffle_epi8(table, _mm256_and_si256(bits, low));
+		auto hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(bits, 4), low));
+		return _mm256_add_epi8(lo, hi);
+	}
+
+	static Vec addBytes(Vec a, Vec b) { return _mm256_add_epi8(a, b); }
+
+	static void wordSums(Vec counts, uint64_t* sums) {
+		auto lanes = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+		auto pair = _mm_add_epi64(_mm256_castsi256_si128(lanes), _mm256_extracti128_si256(lanes, 1));
+		sums[0] += _mm_cvtsi128_si64(pair) + _mm_extract_epi64(pair, 1);
+	}
+
+	static Vec rowIndex(int row) { return _mm256_set1_epi64x(row); }
+
+	static void markRows(Vec bits, Vec row, Vec& first, Vec& last) {
+		__mmask8 live = _mm256_test_epi64_mask(bits, bits);
+		first = _mm256_mask_min_epu64(first, live, first, row);
+		last = _mm256_mask_max_epu64(last, live, last, row);
+	}
+
+	static Vec conway(Vec moreThan0, Vec moreThan1, Vec moreThan2, Vec moreThan3, Vec state) {
+		auto twoMaybeThree = _mm256_ternarylogic_epi64(moreThan0, moreThan1, moreThan3, AND_AND_NOT);
+		return _mm256_ternarylogic_epi64(twoMaybeThree, moreThan2, state, AND_OR);
+	}
+};
+
+template <class R>
+class Avx512Kernel: public LifeKernel {
+public:
+	explicit Avx512Kernel(const LifeRule& rule) : LifeKernel(rule), logic(rule) {}
+
+	const char* name() const {
+		return "avx512";
+	}
+
+	uint64_t nextWords(uint8_t** cells, int row, int column, int words, uint8_t* out) const {
+		return nextWordsWrapped(cells, row, column, words, out, 0, 0);
+	}
+
+	uint64_t nextWordsWrapped(uint8_t** cells, int row, int column, int words, uint8_t* out, int rowStart, int rowEnd) const {
+		uint64_t changed = nextWordsWith<Avx512>(cells, row, column, words, out, logic, rowStart, rowEnd);
+		if (words & 1) {
+			int last = words - 1;
+			changed |= nextWordsWith<Avx512Half>(cells, row, column + last*32, 1, out + last*32, logic, rowStart, rowEnd) << last;
+		}
+		return changed;
+	}
+
+	uint64_t nextRowsCounted(uint8_t** cells, int firstRow, int lastRow, int column, int words, uint8_t** out,
+			int rowStart, int rowEnd, bool countPrevious, WordStats* stats) const {
+		uint64_t changed = nextRowsCountedWith<Avx512>(cells, firstRow, lastRow, column, words, out, logic,
+			rowStart, rowEnd, countPrevious, stats);
+		if (words & 1) {
+			int last = words - 1;
+			changed |= nextRowsCountedWith<Avx512Half>(cells, firstRow, lastRow, column + last*32, 1, out, logic,
+				rowStart, rowEnd, countPrevious, stats + last) << last;
+		}
+		return changed;
+	}
+
+	// 64 pixels at a time, the mask register holds the bits once they're reversed within each byte
+	void expand(const uint8_t* bits, int bytes, char* pixels) const {
+		for (int i = 0; i < bytes; i += 8) {
+			uint64_t packed = *(const uint64_t*)&bits[i];
+			packed = ((packed >> 1) & 0x5555555555555555ULL) | ((packed & 0x5555555555555555ULL) << 1);
+			packed = ((packed >> 2) & 0x3333333333333333ULL) | ((packed & 0x3333333333333333ULL) << 2);
+			packed = ((packed >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((packed & 0x0F0F0F0F0F0F0F0FULL) << 4);
+			_mm512_storeu_si512((void*)&pixels[i*8], _mm512_movm_epi8(packed));
+		}
+	}
+
+private:
+	const R logic;
+};
+
+}
+
+const LifeKernel* avx512Kernel(const LifeRule& rule) {
+	return kernelForRule<Avx512Kernel>(rule);
+}
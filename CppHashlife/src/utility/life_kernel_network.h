@@ -0,0 +1,288 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <climits>
+#include <algorithm>
+
+// the part of the Life rule shared by every LifeKernel backend, only include this from a backend's .cpp
+// V is a struct of static vector operations on a type V::Vec, which holds V::WORDS 256 cell words:
+//   load, store, orv, andv, andnot (a & ~b), select (a ? b : c), zero, ones, changed (bitmask of words which differ)
+//   shiftRight / shiftLeft (the left / right neighbour of every cell, reading the bytes either side of the row pointer)
+//   conway (Conway's rule from the first 4 sorted neighbours and the current state)
+//   byteCounts (live cells in each byte), addBytes (bytewise add), wordSums (adds the bytes of each word onto sums[word]),
+//   rowIndex (row in every 64 bit lane), markRows (where a lane has any bit set, first = min(first, row) and
+//   last = max(last, row), as unsigned 32 bit values in the low half of each lane)
+
+// swaps i and j if j > i
+// this algo is invented by Astrid Yu, check out her website https://astrid.tech/
+#define CMP_SWAP(i, j) { \
+	auto x = neighbors[i]; \
+	neighbors[i] = V::orv(x, neighbors[j]); \
+	neighbors[j] = V::andv(x, neighbors[j]); \
+}
+
+// the network sorts all 8 neighbours, so n[k] is set wherever there are more than k of them,
+// and a run of counts a..b is n[a-1] & ~n[b]
+template <class V>
+static inline typename V::Vec countIn(const typename V::Vec* n, int mask) {
+	typename V::Vec result = V::zero();
+	for (int a = 0; a <= 8; a++) {
+		if (!((mask >> a) & 1)) continue;
+		int b = a;
+		while (b < 8 && ((mask >> (b+1)) & 1)) b++;
+
+		typename V::Vec run;
+		if (a == 0) run = b == 8 ? V::ones() : V::andnot(V::ones(), n[b]);
+		else run = b == 8 ? n[a-1] : V::andnot(n[a-1], n[b]);
+		result = V::orv(result, run);
+		a = b;
+	}
+	return result;
+}
+
+// each backend's hand written logic
+struct ConwayRule {
+	explicit ConwayRule(const LifeRule& rule) {}
+
+	template <class V>
+	typename V::Vec next(const typename V::Vec* n, const typename V::Vec& state) const {
+		return V::conway(n[0], n[1], n[2], n[3], state);
+	}
+};
+
+// a rule known at compile time, countIn folds down to a few instructions,
+// and the compiler drops every half of a CMP_SWAP whose result the rule never reads
+template <int BIRTH, int SURVIVAL>
+struct FixedRule {
+	explicit FixedRule(const LifeRule& rule) {}
+
+	template <class V>
+	typename V::Vec next(const typename V::Vec* n, const typename V::Vec& state) const {
+		return V::select(state, countIn<V>(n, SURVIVAL), countIn<V>(n, BIRTH));
+	}
+};
+
+// any other rule, the runs of each mask are walked for every word
+struct DynamicRule {
+	const int birth;
+	const int survival;
+
+	explicit DynamicRule(const LifeRule& rule) : birth(rule.birth), survival(rule.survival) {}
+
+	template <class V>
+	typename V::Vec next(const typename V::Vec* n, const typename V::Vec& state) const {
+		return V::select(state, countIn<V>(n, survival), countIn<V>(n, birth));
+	}
+};
+
+// the kernel K<R> for a rule, the rules we run often are compiled specially,
+// others get a new DynamicRule kernel each call so the caller has to keep it (LifeKernel::best does)
+template <template <class> class K>
+static const LifeKernel* kernelForRule(const LifeRule& rule) {
+	if (rule == CONWAY) {
+		static const K<ConwayRule> kernel(CONWAY);
+		return &kernel;
+	}
+	if (rule == HIGHLIFE) {
+		static const K<FixedRule<HIGHLIFE.birth, HIGHLIFE.survival>> kernel(HIGHLIFE);
+		return &kernel;
+	}
+	if (rule == DAY_AND_NIGHT) {
+		static const K<FixedRule<DAY_AND_NIGHT.birth, DAY_AND_NIGHT.survival>> kernel(DAY_AND_NIGHT);
+		return &kernel;
+	}
+	if (rule == SEEDS) {
+		static const K<FixedRule<SEEDS.birth, SEEDS.survival>> kernel(SEEDS);
+		return &kernel;
+	}
+	return new K<DynamicRule>(rule);
+}
+
+// a word at one end of a ring row, laid out like a row: 32 bytes of padding, the word, then a byte after it,
+// with the padding byte before it and the byte after it taken from the other end of the row where the row wraps
+template <class V>
+static inline const uint8_t* ringWord(const uint8_t* row, int column, int rowStart, int rowEnd, uint8_t* ring) {
+	const int bytes = V::WORDS*32;
+	ring[31] = row[column == rowStart ? rowEnd-1 : column-1];
+	memcpy(ring + 32, row + column, bytes);
+	ring[32 + bytes] = row[column + bytes == rowEnd ? rowStart : column + bytes];
+	return ring + 32;
+}
+
+// the new state of V::WORDS words, with the old one left in state
+template <class V, class R>
+static inline typename V::Vec nextState(const uint8_t* above, const uint8_t* middle, const uint8_t* below, const R& rule,
+		typename V::Vec& state) {
+	state = V::load(middle);
+	typename V::Vec neighbors[8];
+	neighbors[1] = V::load(above);						// top middle
+	neighbors[6] = V::load(below);						// bottom middle
+	neighbors[0] = V::shiftRight(above, neighbors[1]);	// top left
+	neighbors[2] = V::shiftLeft (above, neighbors[1]);	// top right
+	neighbors[3] = V::shiftRight(middle, state);		// middle left
+	neighbors[4] = V::shiftLeft (middle, state);		// middle right
+	neighbors[5] = V::shiftRight(below, neighbors[6]);	// bottom left
+	neighbors[7] = V::shiftLeft (below, neighbors[6]);	// bottom right
+
+	CMP_SWAP(3, 7);
+	CMP_SWAP(2, 6);
+	CMP_SWAP(1, 5);
+	CMP_SWAP(0, 4);
+
+	CMP_SWAP(5, 7);
+	CMP_SWAP(4, 6);
+	CMP_SWAP(1, 3);
+	CMP_SWAP(0, 2);
+	CMP_SWAP(3, 5);
+	CMP_SWAP(2, 4);
+
+	CMP_SWAP(6, 7);
+	CMP_SWAP(4, 5);
+	CMP_SWAP(2, 3);
+	CMP_SWAP(0, 1);
+
+	CMP_SWAP(3, 6);
+	CMP_SWAP(1, 4);
+	CMP_SWAP(5, 6);
+	CMP_SWAP(3, 4);
+	CMP_SWAP(1, 2);
+
+	// neighbors[k] is now set wherever there are more than k neighbours
+	return rule.template next<V>(neighbors, state);
+}
+
+// rowEnd 0 is a plain row, otherwise the row is a ring from rowStart to rowEnd, see LifeKernel::nextWordsWrapped
+template <class V, class R>
+static inline uint64_t nextWordsWith(uint8_t** cells, int row, int column, int words, uint8_t* out, const R& rule,
+		int rowStart = 0, int rowEnd = 0) {
+	alignas(64) uint8_t rings[3][V::WORDS*32 + 64];
+	uint64_t changed = 0;
+	for (int w = 0; w + V::WORDS <= words; w += V::WORDS) {
+		const int c = column + w*32;
+		const uint8_t* above = &cells[row-1][c];
+		const uint8_t* middle = &cells[row  ][c];
+		const uint8_t* below = &cells[row+1][c];
+		if (rowEnd != 0 && (c == rowStart || c + V::WORDS*32 == rowEnd)) {
+			above = ringWord<V>(cells[row-1], c, rowStart, rowEnd, rings[0]);
+			middle = ringWord<V>(cells[row  ], c, rowStart, rowEnd, rings[1]);
+			below = ringWord<V>(cells[row+1], c, rowStart, rowEnd, rings[2]);
+		}
+
+		typename V::Vec state;
+		auto next = nextState<V>(above, middle, below, rule, state);
+		changed |= V::changed(V::load(out + w*32), next) << w;
+		V::store(out + w*32, next);
+	}
+	return changed;
+}
+
+// the first and last live cell of a 32 byte word, MSB first, false if there's none
+// a quarter at a time, byte swapped so the first cell is the top bit
+static inline bool liveColumns(const uint8_t* word, int& left, int& right) {
+	uint64_t quarters[4];
+	memcpy(quarters, word, 32);
+	int first = 0;
+	while (first < 4 && quarters[first] == 0) first++;
+	if (first == 4) return false;
+	int last = 3;
+	while (quarters[last] == 0) last--;
+	left = first*64 + __builtin_clzll(__builtin_bswap64(quarters[first]));
+	right = last*64 + 63 - __builtin_ctzll(__builtin_bswap64(quarters[last]));
+	return true;
+}
+
+// see LifeKernel::nextRowsCounted, row by row like nextWords with every word's counts kept on the stack,
+// per byte counts are added up for 16 rows (at most 128 a byte) before they're summed into 64 bit lanes,
+// and the first and last live row of each 64 cells is kept in vectors without leaving them, rows start at 1
+template <class V, class R>
+static inline uint64_t nextRowsCountedWith(uint8_t** cells, int firstRow, int lastRow, int column, int words, uint8_t** out,
+		const R& rule, int rowStart, int rowEnd, bool countPrevious, WordStats* stats) {
+	typedef typename V::Vec Vec;
+	alignas(64) uint8_t rings[3][V::WORDS*32 + 64];
+	const int groups = words / V::WORDS;
+	Vec population[64 / V::WORDS];
+	Vec births[64 / V::WORDS];
+	Vec previous[64 / V::WORDS];
+	Vec any[64 / V::WORDS];
+	Vec first[64 / V::WORDS];
+	Vec last[64 / V::WORDS];
+	uint64_t sums[3][64];
+	for (int g = 0; g < groups; g++) {
+		population[g] = births[g] = previous[g] = any[g] = last[g] = V::zero();
+		first[g] = V::ones();
+	}
+	for (int w = 0; w < words; w++) {
+		sums[0][w] = sums[1][w] = sums[2][w] = 0;
+	}
+
+	uint64_t changed = 0;
+	for (int row = firstRow; row < lastRow; row++) {
+		const Vec rowIndex = V::rowIndex(row);
+		for (int g = 0; g < groups; g++) {
+			const int c = column + g * V::WORDS*32;
+			const uint8_t* above = &cells[row-1][c];
+			const uint8_t* middle = &cells[row  ][c];
+			const uint8_t* below = &cells[row+1][c];
+			if (rowEnd != 0 && (c == rowStart || c + V::WORDS*32 == rowEnd)) {
+				above = ringWord<V>(cells[row-1], c, rowStart, rowEnd, rings[0]);
+				middle = ringWord<V>(cells[row  ], c, rowStart, rowEnd, rings[1]);
+				below = ringWord<V>(cells[row+1], c, rowStart, rowEnd, rings[2]);
+			}
+
+			Vec state;
+			auto next = nextState<V>(above, middle, below, rule, state);
+			uint8_t* to = &out[row][c];
+			changed |= V::changed(V::load(to), next) << (g * V::WORDS);
+			V::store(to, next);
+
+			population[g] = V::addBytes(population[g], V::byteCounts(next));
+			births[g] = V::addBytes(births[g], V::byteCounts(V::andnot(next, state)));
+			if (countPrevious) previous[g] = V::addBytes(previous[g], V::byteCounts(state));
+			any[g] = V::orv(any[g], next);
+			V::markRows(next, rowIndex, first[g], last[g]);
+		}
+
+		if ((row - firstRow) % 16 == 15 || row == lastRow-1) {
+			for (int g = 0; g < groups; g++) {
+				V::wordSums(population[g], &sums[0][g * V::WORDS]);
+				V::wordSums(births[g], &sums[1][g * V::WORDS]);
+				population[g] = births[g] = V::zero();
+				if (countPrevious) {
+					V::wordSums(previous[g], &sums[2][g * V::WORDS]);
+					previous[g] = V::zero();
+				}
+			}
+		}
+	}
+
+	alignas(64) uint8_t alive[V::WORDS*32];
+	alignas(64) uint64_t firsts[V::WORDS*4];
+	alignas(64) uint64_t lasts[V::WORDS*4];
+	for (int g = 0; g < groups; g++) {
+		V::store(alive, any[g]);
+		V::store((uint8_t*)firsts, first[g]);
+		V::store((uint8_t*)lasts, last[g]);
+		for (int k = 0; k < V::WORDS; k++) {
+			const int w = g * V::WORDS + k;
+			WordStats& word = stats[w];
+			word.population += sums[0][w];
+			word.births += sums[1][w];
+			word.previous += sums[2][w];
+			int left, right;
+			if (!liveColumns(&alive[k*32], left, right)) continue;
+			uint32_t top = UINT32_MAX, bottom = 0;
+			for (int lane = k*4; lane < k*4 + 4; lane++) {
+				top = std::min(top, (uint32_t)firsts[lane]);
+				bottom = std::max(bottom, (uint32_t)lasts[lane]);
+			}
+			if (word.top < 0 || (int)top < word.top) word.top = top;
+			if ((int)bottom > word.bottom) word.bottom = bottom;
+			if (word.left < 0 || left < word.left) word.left = left;
+			if (right > word.right) word.right = right;
+		}
+	}
+	return changed;
+}
+
+#undef CMP_SWAP
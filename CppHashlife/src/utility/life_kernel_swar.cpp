@@ -0,0 +1,170 @@
+#include "life_kernel.h"
+#include "life_kernel_network.h"
+#include <string.h>
+
+// plain 64 bit integers, for cpus without AVX2
+namespace {
+
+struct Swar {
+	struct Vec {
+		uint64_t q[4];
+	};
+	static const int WORDS = 1;
+
+	static Vec load(const uint8_t* p) {
+		Vec v;
+		memcpy(v.q, p, 32);
+		return v;
+	}
+
+	static void store(uint8_t* p, const Vec& v) {
+		memcpy(p, v.q, 32);
+	}
+
+	static Vec orv(const Vec& a, const Vec& b) {
+		Vec v;
+		for (int i = 0; i < 4; i++) v.q[i] = a.q[i] | b.q[i];
+		return v;
+	}
+
+	static Vec andv(const Vec& a, const Vec& b) {
+		Vec v;
+		for (int i = 0; i < 4; i++) v.q[i] = a.q[i] & b.q[i];
+		return v;
+	}
+
+	static Vec andnot(const Vec& a, const Vec& b) {
+		Vec v;
+		for (int i = 0; i < 4; i++) v.q[i] = a.q[i] & ~b.q[i];
+		return v;
+	}
+
+	static Vec select(const Vec& a, const Vec& b, const Vec& c) {
+		Vec v;
+		for (int i = 0; i < 4; i++) v.q[i] = (a.q[i] & b.q[i]) | (~a.q[i] & c.q[i]);
+		return v;
+	}
+
+	static Vec zero() {
+		Vec v = { { 0, 0, 0, 0 } };
+		return v;
+	}
+
+	static Vec ones() {
+		Vec v = { { ~0ULL, ~0ULL, ~0ULL, ~0ULL } };
+		return v;
+	}
+
+	static uint64_t changed(const Vec& a, const Vec& b) {
+		uint64_t diff = 0;
+		for (int i = 0; i < 4; i++) diff |= a.q[i] ^ b.q[i];
+		return diff != 0;
+	}
+
+	// same trick as the AVX2 kernel, shift within each byte and take the carried cell from the byte next door
+	static Vec shiftRight(const uint8_t* rawBits, const Vec& bits) {
+		Vec before = load(rawBits - 1);
+		Vec v;
+		for (int i = 0; i < 4; i++) {
+			v.q[i] = ((bits.q[i] >> 1) & 0x7F7F7F7F7F7F7F7FULL) | ((before.q[i] << 7) & 0x8080808080808080ULL);
+		}
+		return v;
+	}
+
+	static Vec shiftLeft(const uint8_t* rawBits, const Vec& bits) {
+		Vec after = load(rawBits + 1);
+		Vec v;
+		for (int i = 0; i < 4; i++) {
+			v.q[i] = ((bits.q[i] << 1) & 0xFEFEFEFEFEFEFEFEULL) | ((after.q[i] >> 7) & 0x0101010101010101ULL);
+		}
+		return v;
+	}
+
+	// the usual popcount steps, stopped once every byte holds its own count
+	static Vec byteCounts(const Vec& bits) {
+		Vec v;
+		for (int i = 0; i < 4; i++) {
+			uint64_t x = bits.q[i] - ((bits.q[i] >> 1) & 0x5555555555555555ULL);
+			x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+			v.q[i] = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+		}
+		return v;
+	}
+
+	static Vec addBytes(const Vec& a, const Vec& b) {
+		Vec v;
+		for (int i = 0; i < 4; i++) v.q[i] = a.q[i] + b.q[i];
+		return v;
+	}
+
+	// pairs of bytes into 16 bits first, a byte can hold up to 128
+	static void wordSums(const Vec& counts, uint64_t* sums) {
+		for (int i = 0; i < 4; i++) {
+			uint64_t x = (counts.q[i] & 0x00FF00FF00FF00FFULL) + ((counts.q[i] >> 8) & 0x00FF00FF00FF00FFULL);
+			sums[0] += (x * 0x0001000100010001ULL) >> 48;
+		}
+	}
+
+	static Vec rowIndex(int row) {
+		Vec v;
+		for (int i = 0; i < 4; i++) v.q[i] = row;
+		return v;
+	}
+
+	static void markRows(const Vec& bits, const Vec& row, Vec& first, Vec& last) {
+		for (int i = 0; i < 4; i++) {
+			if (bits.q[i] == 0) continue;
+			first.q[i] = std::min(first.q[i], row.q[i]);
+			last.q[i] = std::max(last.q[i], row.q[i]);
+		}
+	}
+
+	static Vec conway(const Vec& moreThan0, const Vec& moreThan1, const Vec& moreThan2, const Vec& moreThan3, const Vec& state) {
+		Vec v;
+		for (int i = 0; i < 4; i++) {
+			uint64_t twoMaybeThree = moreThan0.q[i] & moreThan1.q[i] & ~moreThan3.q[i];
+			v.q[i] = twoMaybeThree & (moreThan2.q[i] | state.q[i]);
+		}
+		return v;
+	}
+};
+
+template <class R>
+class SwarKernel: public LifeKernel {
+public:
+	explicit SwarKernel(const LifeRule& rule) : LifeKernel(rule), logic(rule) {}
+
+	const char* name() const {
+		return "swar";
+	}
+
+	uint64_t nextWords(uint8_t** cells, int row, int column, int words, uint8_t* out) const {
+		return nextWordsWith<Swar>(cells, row, column, words, out, logic);
+	}
+
+	uint64_t nextWordsWrapped(uint8_t** cells, int row, int column, int words, uint8_t* out, int rowStart, int rowEnd) const {
+		return nextWordsWith<Swar>(cells, row, column, words, out, logic, rowStart, rowEnd);
+	}
+
+	uint64_t nextRowsCounted(uint8_t** cells, int firstRow, int lastRow, int column, int words, uint8_t** out,
+			int rowStart, int rowEnd, bool countPrevious, WordStats* stats) const {
+		return nextRowsCountedWith<Swar>(cells, firstRow, lastRow, column, words, out, logic, rowStart, rowEnd, countPrevious, stats);
+	}
+
+	void expand(const uint8_t* bits, int bytes, char* pixels) const {
+		for (int i = 0; i < bytes; i++) {
+			for (int j = 0; j < 8; j++) {
+				pixels[i*8 + j] = (bits[i] & (0x80 >> j)) ? 0xFF : 0x00;
+			}
+		}
+	}
+
+private:
+	const R logic;
+};
+
+}
+
+const LifeKernel* swarKernel(const LifeRule& rule) {
+	return kernelForRule<SwarKernel>(rule);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <ctype.h>
+#include <stdint.h>
+#include <string>
+
+// an outer totalistic rule in B/S notation, bit k of birth is set if a dead cell with k live neighbours is born,
+// and bit k of survival if a live cell with k live neighbours stays alive
+// header only so find_net can search for networks for the same rules the kernels run
+struct LifeRule {
+	uint16_t birth;
+	uint16_t survival;
+
+	bool operator==(const LifeRule& other) const {
+		return birth == other.birth && survival == other.survival;
+	}
+
+	bool operator!=(const LifeRule& other) const {
+		return !(*this == other);
+	}
+
+	bool operator<(const LifeRule& other) const {
+		return birth < other.birth || (birth == other.birth && survival < other.survival);
+	}
+
+	bool next(bool alive, int neighbours) const {
+		return ((alive ? survival : birth) >> neighbours) & 1;
+	}
+
+	std::string toString() const {
+		std::string text = "B";
+		for (int k = 0; k <= 8; k++) {
+			if ((birth >> k) & 1) text += (char)('0' + k);
+		}
+		text += "/S";
+		for (int k = 0; k <= 8; k++) {
+			if ((survival >> k) & 1) text += (char)('0' + k);
+		}
+		return text;
+	}
+
+	// B36/S23 in any case and either order, or the older S/B notation 23/36
+	static bool parse(const std::string& text, LifeRule& rule, std::string& error) {
+		size_t slash = text.find('/');
+		if (slash == std::string::npos) {
+			error = "rule " + text + " needs a / between birth and survival";
+			return false;
+		}
+
+		std::string first = text.substr(0, slash);
+		std::string second = text.substr(slash+1);
+		bool firstIsBirth = !first.empty() && (first[0] == 'B' || first[0] == 'b');
+		bool secondIsBirth = !second.empty() && (second[0] == 'B' || second[0] == 'b');
+		bool lettered = !first.empty() && !isdigit((unsigned char)first[0]);
+		if (!lettered) secondIsBirth = true; // S/B notation, survival comes first
+
+		uint16_t masks[2] = { 0, 0 };
+		const std::string* parts[2] = { &first, &second };
+		for (int p = 0; p < 2; p++) {
+			const std::string& part = *parts[p];
+			for (size_t i = 0; i < part.size(); i++) {
+				char c = part[i];
+				if (i == 0 && lettered && (c == 'B' || c == 'b' || c == 'S' || c == 's')) continue;
+				if (c < '0' || c > '8') {
+					error = "rule " + text + " has '" + c + "', only counts 0 to 8 are supported";
+					return false;
+				}
+				masks[p] |= 1 << (c - '0');
+			}
+		}
+		if (lettered && firstIsBirth == secondIsBirth) {
+			error = "rule " + text + " needs one B part and one S part";
+			return false;
+		}
+
+		rule.birth = firstIsBirth ? masks[0] : masks[1];
+		rule.survival = firstIsBirth ? masks[1] : masks[0];
+		if (rule.birth & 1) {
+			// every dead cell off the edge of the board would be born
+			error = "rule " + text + " has B0, which isn't supported";
+			return false;
+		}
+		return true;
+	}
+};
+
+constexpr LifeRule CONWAY = { 1 << 3, (1 << 2) | (1 << 3) };											// B3/S23
+constexpr LifeRule HIGHLIFE = { (1 << 3) | (1 << 6), (1 << 2) | (1 << 3) };								// B36/S23
+constexpr LifeRule DAY_AND_NIGHT = { (1 << 3) | (1 << 6) | (1 << 7) | (1 << 8),
+	(1 << 3) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 8) };												// B3678/S34678
+constexpr LifeRule SEEDS = { 1 << 2, 0 };																// B2/S
@@ -1,7 +1,7 @@
 #include "packed_array_2d.h"
 #include <iostream>
 
-PackedArray2D::PackedArray2D(int wdith, int height) : width(width), height(height), array(width*height) {}
+PackedArray2D::PackedArray2D(int width, int height) : width(width), height(height), array(width*height) {}
 
 uint8_t PackedArray2D::get(int i, int j) const {
 	return array.get(j*width + i);
@@ -4,7 +4,7 @@
 
 class PackedArray2D {
 public:
-	PackedArray2D(int wdith, int height);
+	PackedArray2D(int width, int height);
 
 	uint8_t get(int i, int j) const;
 	uint8_t get(int k) const;
@@ -0,0 +1,586 @@
+#include "pattern_io.h"
+#include "../life.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <array>
+#include <vector>
+
+namespace {
+
+const int END = std::char_traits<char>::eof();
+
+// reads straight from the stream's buffer, a character at a time
+struct Input {
+	std::streambuf* buf;
+
+	int peek() { return buf->sgetc(); }
+	int next() { return buf->sbumpc(); }
+
+	void skipLine() {
+		int c = next();
+		while (c != END && c != '\n') c = next();
+	}
+
+	// the rest of the line, only used for headers and comments so it's cut off at a sensible length
+	std::string line() {
+		std::string s;
+		int c = next();
+		while (c != END && c != '\n') {
+			if (c != '\r' && s.size() < 4096) s += (char)c;
+			c = next();
+		}
+		return s;
+	}
+
+	void skipSpaces() {
+		while (peek() == ' ' || peek() == '\t' || peek() == '\r') next();
+	}
+
+	bool integer(int64_t& value) {
+		skipSpaces();
+		bool negative = peek() == '-';
+		if (negative || peek() == '+') next();
+		if (peek() < '0' || peek() > '9') return false;
+		value = 0;
+		while (peek() >= '0' && peek() <= '9') {
+			if (value > (INT64_MAX - 9) / 10) return false;
+			value = value * 10 + (next() - '0');
+		}
+		if (negative) value = -value;
+		return true;
+	}
+};
+
+bool fail(PatternInfo& info, const std::string& error) {
+	info.error = error;
+	return false;
+}
+
+std::string trim(const std::string& s) {
+	size_t start = s.find_first_not_of(" \t");
+	size_t end = s.find_last_not_of(" \t");
+	return start == std::string::npos ? "" : s.substr(start, end - start + 1);
+}
+
+// x = 3, y = 5, rule = B3/S23
+void parseHeader(const std::string& header, PatternInfo& info) {
+	size_t start = 0;
+	while (start < header.size()) {
+		size_t comma = header.find(',', start);
+		if (comma == std::string::npos) comma = header.size();
+		std::string item = header.substr(start, comma - start);
+		size_t eq = item.find('=');
+		if (eq != std::string::npos) {
+			std::string key = trim(item.substr(0, eq));
+			std::string value = trim(item.substr(eq+1));
+			if (key == "x") info.width = atoll(value.c_str());
+			else if (key == "y") info.height = atoll(value.c_str());
+			else if (key == "rule") info.rule = value;
+		}
+		start = comma + 1;
+	}
+}
+
+// live cells in a row of a leaf byte, as runs
+void byteRuns(PatternSink& sink, uint8_t bits, int64_t row, int64_t column) {
+	int j = 0;
+	while (bits != 0) {
+		int skip = __builtin_clz((uint32_t)bits << 24);
+		bits <<= skip;
+		j += skip;
+		int length = __builtin_clz(~((uint32_t)bits << 24));
+		sink.run(row, column + j, length);
+		bits <<= length;
+		j += length;
+	}
+}
+
+bool parseRLE(Input& in, PatternSink& sink, PatternInfo& info) {
+	info.format = "rle";
+	int64_t row = 0;
+	int64_t column = 0;
+	int64_t count = 0;
+	bool lineStart = true;
+	bool body = false;
+
+	while (true) {
+		int c = in.peek();
+		if (c == END) {
+			return true; // plenty of files in the wild forget the !
+		}
+
+		if (lineStart && !body && c == '#') {
+			in.skipLine();
+			continue;
+		}
+		if (lineStart && !body && c == 'x') {
+			parseHeader(in.line(), info);
+			continue;
+		}
+
+		in.next();
+		lineStart = c == '\n';
+		if (c >= '0' && c <= '9') {
+			if (count > (int64_t)1 << 48) return fail(info, "run count too big");
+			count = count * 10 + (c - '0');
+			body = true;
+			continue;
+		}
+
+		int64_t n = count == 0 ? 1 : count;
+		count = 0;
+		body = body || (c != '\n' && c != '\r' && c != ' ' && c != '\t');
+		if (c == 'b' || c == '.') {
+			column += n;
+		} else if (c == 'o' || (c >= 'A' && c <= 'X')) { // multi-state files use letters for states, anything not dead is alive here
+			sink.run(row, column, n);
+			column += n;
+		} else if (c == '$') {
+			row += n;
+			column = 0;
+		} else if (c == '!') {
+			return true;
+		} else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+			count = n == 1 ? 0 : n; // a count can be split from its tag by a line break
+		} else {
+			return fail(info, std::string("unexpected character '") + (char)c + "' in RLE");
+		}
+	}
+}
+
+bool parsePlaintext(Input& in, PatternSink& sink, PatternInfo& info) {
+	info.format = "plaintext";
+	int64_t row = 0;
+	int64_t column = 0;
+	int64_t runStart = -1;
+
+	while (true) {
+		int c = in.next();
+		if (c == '!' && column == 0) {
+			in.skipLine();
+			continue;
+		}
+
+		bool alive = c == 'O' || c == '*';
+		if (alive && runStart < 0) runStart = column;
+		if (!alive && runStart >= 0) {
+			sink.run(row, runStart, column - runStart);
+			runStart = -1;
+		}
+
+		if (c == END) {
+			return true;
+		} else if (c == '\n') {
+			row++;
+			column = 0;
+		} else if (c == '.' || alive) {
+			column++;
+		} else if (c != '\r' && c != ' ' && c != '\t') {
+			return fail(info, std::string("unexpected character '") + (char)c + "' in plaintext");
+		}
+	}
+}
+
+bool parseLife106(Input& in, PatternSink& sink, PatternInfo& info) {
+	info.format = "life106";
+	// cells next to each other in a row are joined into one run
+	int64_t runRow = 0;
+	int64_t runColumn = 0;
+	int64_t runLength = 0;
+
+	while (true) {
+		in.skipSpaces();
+		int c = in.peek();
+		if (c == END) break;
+		if (c == '\n') {
+			in.next();
+			continue;
+		}
+		if (c == '#') {
+			in.skipLine();
+			continue;
+		}
+
+		int64_t x, y;
+		if (!in.integer(x) || !in.integer(y)) {
+			return fail(info, "expected a pair of coordinates in Life 1.06");
+		}
+		if (runLength > 0 && y == runRow && x == runColumn + runLength) {
+			runLength++;
+		} else {
+			if (runLength > 0) sink.run(runRow, runColumn, runLength);
+			runRow = y;
+			runColumn = x;
+			runLength = 1;
+		}
+	}
+	if (runLength > 0) sink.run(runRow, runColumn, runLength);
+	return true;
+}
+
+// level 3 nodes are 8x8 leaves stored as a byte per row, index 0 is the empty node
+struct MacroNode {
+	int level;
+	uint32_t children[4];
+	uint8_t rows[8];
+};
+
+void emitMacrocell(const std::vector<MacroNode>& nodes, uint32_t index, int64_t row, int64_t column, PatternSink& sink) {
+	if (index == 0) return;
+	const MacroNode& n = nodes[index];
+	if (!sink.intersects(row, column, (int64_t)1 << n.level)) return;
+
+	if (n.level == 3) {
+		for (int i = 0; i < 8; i++) {
+			byteRuns(sink, n.rows[i], row + i, column);
+		}
+		return;
+	}
+
+	int64_t half = (int64_t)1 << (n.level - 1);
+	emitMacrocell(nodes, n.children[0], row, column, sink);
+	emitMacrocell(nodes, n.children[1], row, column + half, sink);
+	emitMacrocell(nodes, n.children[2], row + half, column, sink);
+	emitMacrocell(nodes, n.children[3], row + half, column + half, sink);
+}
+
+bool parseMacrocell(Input& in, PatternSink& sink, PatternInfo& info) {
+	info.format = "mc";
+	std::vector<MacroNode> nodes(1);
+	nodes[0].level = 0;
+
+	while (true) {
+		int c = in.peek();
+		if (c == END) break;
+		if (c == '\n' || c == '\r') {
+			in.next();
+			continue;
+		}
+		if (c == '[') {
+			in.skipLine();
+			continue;
+		}
+		if (c == '#') {
+			std::string line = in.line();
+			if (line.compare(0, 2, "#R") == 0) info.rule = trim(line.substr(2));
+			else if (line.compare(0, 2, "#G") == 0) info.generation = atoll(line.substr(2).c_str());
+			continue;
+		}
+
+		MacroNode n;
+		memset(&n, 0, sizeof(n));
+		if (c >= '0' && c <= '9') {
+			int64_t level, child;
+			if (!in.integer(level) || level < 4 || level > 62) {
+				return fail(info, "bad node level in macrocell (only 2 state patterns are supported)");
+			}
+			n.level = (int)level;
+			for (int i = 0; i < 4; i++) {
+				if (!in.integer(child) || child < 0 || child >= (int64_t)nodes.size()) {
+					return fail(info, "bad child index in macrocell");
+				}
+				if (child != 0 && nodes[child].level != n.level - 1) {
+					return fail(info, "child level doesn't match in macrocell");
+				}
+				n.children[i] = (uint32_t)child;
+			}
+			in.skipLine();
+		} else {
+			n.level = 3;
+			int row = 0;
+			int column = 0;
+			c = in.next();
+			while (c != END && c != '\n') {
+				if (c == '$') {
+					row++;
+					column = 0;
+				} else if (c == '.' || c == '*') {
+					if (row >= 8 || column >= 8) return fail(info, "leaf bigger than 8x8 in macrocell");
+					if (c == '*') n.rows[row] |= 0x80 >> column;
+					column++;
+				} else if (c != '\r') {
+					return fail(info, std::string("unexpected character '") + (char)c + "' in macrocell leaf");
+				}
+				c = in.next();
+			}
+		}
+		nodes.push_back(n);
+	}
+
+	if (nodes.size() == 1) return fail(info, "macrocell has no nodes");
+	emitMacrocell(nodes, (uint32_t)nodes.size()-1, 0, 0, sink);
+	return true;
+}
+
+// the next cell at or after column in a row which is alive (or dead, with invert 0xFF), or width if there isn't one
+int nextCell(uint8_t** cells, int row, int column, int width, uint8_t invert) {
+	const uint8_t* bytes = &cells[row+1][32];
+	while (column < width) {
+		uint8_t bits = (bytes[column/8] ^ invert) & (0xFF >> (column%8));
+		if (bits != 0) {
+			return std::min(width, column - column%8 + __builtin_clz((uint32_t)bits << 24));
+		}
+		column += 8 - column%8;
+	}
+	return width;
+}
+
+int nextAlive(uint8_t** cells, int row, int column, int width) {
+	return nextCell(cells, row, column, width, 0x00);
+}
+
+int nextDead(uint8_t** cells, int row, int column, int width) {
+	return nextCell(cells, row, column, width, 0xFF);
+}
+
+// RLE lines shouldn't be longer than 70 characters, output is collected into a buffer and written in big blocks
+struct RLEWriter {
+	std::ostream& out;
+	int lineLength;
+	std::string buffer;
+
+	void token(int64_t count, char tag) {
+		if (count == 0) return;
+		char text[24];
+		int length = sizeof(text);
+		text[--length] = tag;
+		if (count > 1) {
+			for (; count > 0; count /= 10) text[--length] = '0' + count % 10;
+		}
+		int tokenLength = sizeof(text) - length;
+		if (lineLength + tokenLength > 70) {
+			buffer += '\n';
+			lineLength = 0;
+		}
+		buffer.append(&text[length], tokenLength);
+		lineLength += tokenLength;
+		if (buffer.size() > (1 << 16)) flush();
+	}
+
+	void flush() {
+		out.write(buffer.data(), buffer.size());
+		buffer.clear();
+	}
+};
+
+typedef std::array<uint32_t, 5> MacroKey; // level and children
+
+uint32_t buildMacrocell(uint8_t** cells, int width, int height, int level, int row, int column,
+		std::map<uint64_t, uint32_t>& leaves, std::map<MacroKey, uint32_t>& branches, uint32_t& count, std::ostream& out) {
+	if (row >= height || column >= width) return 0;
+
+	if (level == 3) {
+		uint64_t bits = 0;
+		uint8_t rows[8];
+		for (int i = 0; i < 8; i++) {
+			rows[i] = 0;
+			if (row + i < height) {
+				rows[i] = cells[row+i+1][32 + column/8];
+				if (width - column < 8) rows[i] &= 0xFF << (8 - (width - column));
+			}
+			bits |= (uint64_t)rows[i] << (i*8);
+		}
+		if (bits == 0) return 0;
+
+		auto found = leaves.find(bits);
+		if (found != leaves.end()) return found->second;
+		int lastRow = 7;
+		while (rows[lastRow] == 0) lastRow--;
+		for (int i = 0; i <= lastRow; i++) {
+			for (int j = 0; j < 8 - __builtin_ctz(rows[i] | 0x100); j++) {
+				out << ((rows[i] & (0x80 >> j)) ? '*' : '.');
+			}
+			out << '$';
+		}
+		out << '\n';
+		return leaves[bits] = ++count;
+	}
+
+	int half = 1 << (level-1);
+	MacroKey key = {
+		(uint32_t)level,
+		buildMacrocell(cells, width, height, level-1, row, column, leaves, branches, count, out),
+		buildMacrocell(cells, width, height, level-1, row, column + half, leaves, branches, count, out),
+		buildMacrocell(cells, width, height, level-1, row + half, column, leaves, branches, count, out),
+		buildMacrocell(cells, width, height, level-1, row + half, column + half, leaves, branches, count, out)
+	};
+	if (key[1] == 0 && key[2] == 0 && key[3] == 0 && key[4] == 0) return 0;
+
+	auto found = branches.find(key);
+	if (found != branches.end()) return found->second;
+	out << key[0] << ' ' << key[1] << ' ' << key[2] << ' ' << key[3] << ' ' << key[4] << '\n';
+	return branches[key] = ++count;
+}
+
+}
+
+PackedSink::PackedSink(uint8_t** cells, int width, int height, int64_t originRow, int64_t originColumn) :
+	cells(cells), width(width), height(height), originRow(originRow), originColumn(originColumn), clipped(0)
+{}
+
+void PackedSink::run(int64_t row, int64_t column, int64_t length) {
+	row += originRow;
+	column += originColumn;
+	if (row < 0 || row >= height) {
+		clipped += length;
+		return;
+	}
+	int64_t first = std::max<int64_t>(0, column);
+	int64_t last = std::min<int64_t>(width, column + length); // exclusive
+	if (first >= last) {
+		clipped += length;
+		return;
+	}
+	clipped += length - (last - first);
+
+	uint8_t* bytes = &cells[row+1][32];
+	uint8_t firstMask = 0xFF >> (first % 8);
+	uint8_t lastMask = 0xFF << (7 - (last-1) % 8);
+	if (first / 8 == (last-1) / 8) {
+		bytes[first / 8] |= firstMask & lastMask;
+		return;
+	}
+	bytes[first / 8] |= firstMask;
+	memset(&bytes[first / 8 + 1], 0xFF, (last-1) / 8 - first / 8 - 1);
+	bytes[(last-1) / 8] |= lastMask;
+}
+
+bool PackedSink::intersects(int64_t row, int64_t column, int64_t size) const {
+	row += originRow;
+	column += originColumn;
+	return row < height && row + size > 0 && column < width && column + size > 0;
+}
+
+int64_t PackedSink::getClipped() const {
+	return clipped;
+}
+
+LifeSink::LifeSink(Life* life, int width, int height, int64_t originRow, int64_t originColumn) :
+	life(life), width(width), height(height), originRow(originRow), originColumn(originColumn)
+{}
+
+void LifeSink::run(int64_t row, int64_t column, int64_t length) {
+	row += originRow;
+	column += originColumn;
+	if (row < 0 || row >= height) return;
+	int64_t last = std::min<int64_t>(width, column + length);
+	for (int64_t j = std::max<int64_t>(0, column); j < last; j++) {
+		life->setCell((int)row, (int)j, true);
+	}
+}
+
+bool LifeSink::intersects(int64_t row, int64_t column, int64_t size) const {
+	row += originRow;
+	column += originColumn;
+	return row < height && row + size > 0 && column < width && column + size > 0;
+}
+
+bool readPattern(std::istream& in, PatternSink& sink, PatternInfo& info) {
+	Input input = { in.rdbuf() };
+	int c = input.peek();
+	if (c == '[') return parseMacrocell(input, sink, info);
+	if (c == '!' || c == '.' || c == 'O' || c == '*') return parsePlaintext(input, sink, info);
+	if (c == '#') {
+		// Life 1.06 starts with #Life 1.06, anything else starting with # is an RLE comment
+		input.next();
+		if (input.peek() == 'L') {
+			std::string line = input.line();
+			if (line.compare(0, 9, "Life 1.06") == 0) return parseLife106(input, sink, info);
+			return fail(info, "unsupported format #" + line);
+		}
+		input.skipLine();
+	}
+	return parseRLE(input, sink, info);
+}
+
+bool readRLE(std::istream& in, PatternSink& sink, PatternInfo& info) {
+	Input input = { in.rdbuf() };
+	return parseRLE(input, sink, info);
+}
+
+bool readPlaintext(std::istream& in, PatternSink& sink, PatternInfo& info) {
+	Input input = { in.rdbuf() };
+	return parsePlaintext(input, sink, info);
+}
+
+bool readLife106(std::istream& in, PatternSink& sink, PatternInfo& info) {
+	Input input = { in.rdbuf() };
+	return parseLife106(input, sink, info);
+}
+
+bool readMacrocell(std::istream& in, PatternSink& sink, PatternInfo& info) {
+	Input input = { in.rdbuf() };
+	return parseMacrocell(input, sink, info);
+}
+
+void writeRLE(std::ostream& out, uint8_t** cells, int width, int height, const std::string& rule) {
+	out << "x = " << width << ", y = " << height;
+	if (!rule.empty()) out << ", rule = " << rule;
+	out << '\n';
+
+	RLEWriter writer = { out, 0, "" };
+	int64_t rowEnds = 0; // written lazily, so trailing empty rows aren't written at all
+	for (int i = 0; i < height; i++) {
+		int column = nextAlive(cells, i, 0, width);
+		if (column < width) {
+			writer.token(rowEnds, '$');
+			rowEnds = 0;
+		}
+		int written = 0;
+		while (column < width) {
+			int end = nextDead(cells, i, column, width);
+			writer.token(column - written, 'b');
+			writer.token(end - column, 'o');
+			written = end;
+			column = nextAlive(cells, i, end, width);
+		}
+		rowEnds++;
+	}
+	writer.token(1, '!');
+	writer.flush();
+	out << '\n';
+}
+
+void writePlaintext(std::ostream& out, uint8_t** cells, int width, int height) {
+	int lastRow = height - 1;
+	while (lastRow >= 0 && nextAlive(cells, lastRow, 0, width) == width) lastRow--;
+
+	for (int i = 0; i <= lastRow; i++) {
+		int written = 0;
+		int column = nextAlive(cells, i, 0, width);
+		while (column < width) {
+			int end = nextDead(cells, i, column, width);
+			out << std::string(column - written, '.') << std::string(end - column, 'O');
+			written = end;
+			column = nextAlive(cells, i, end, width);
+		}
+		out << '\n';
+	}
+}
+
+void writeLife106(std::ostream& out, uint8_t** cells, int width, int height) {
+	out << "#Life 1.06\n";
+	for (int i = 0; i < height; i++) {
+		for (int j = nextAlive(cells, i, 0, width); j < width; j = nextAlive(cells, i, j+1, width)) {
+			out << j << ' ' << i << '\n';
+		}
+	}
+}
+
+void writeMacrocell(std::ostream& out, uint8_t** cells, int width, int height, const std::string& rule) {
+	out << "[M2] (hashlife)\n";
+	if (!rule.empty()) out << "#R " << rule << '\n';
+
+	int level = 3;
+	while ((1 << level) < std::max(width, height)) level++;
+
+	std::map<uint64_t, uint32_t> leaves;
+	std::map<MacroKey, uint32_t> branches;
+	uint32_t count = 0;
+	buildMacrocell(cells, width, height, level, 0, 0, leaves, branches, count, out);
+	if (count == 0) out << "$\n"; // an empty board still needs a root
+}
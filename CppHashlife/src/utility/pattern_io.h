@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include <string>
+
+class Life;
+
+// reading and writing patterns in the formats Golly and LifeWiki use: RLE, plaintext (.cells), Life 1.06 and macrocell (.mc)
+// readers stream the input a character at a time and hand every run of live cells straight to a PatternSink,
+// so nothing the size of the pattern is ever built in memory (except macrocell's node list, which is the file itself)
+
+struct PatternInfo {
+	std::string format; // "rle", "plaintext", "life106" or "mc"
+	std::string rule; // as written in the file, empty if it didn't say
+	int64_t width = 0; // from the RLE header, 0 if unknown
+	int64_t height = 0;
+	int64_t generation = 0; // macrocell #G line
+	std::string error; // set when a reader returns false
+};
+
+// rows go down and columns go right from the pattern's origin, which is its top left corner,
+// except for Life 1.06 where it's whatever (0, 0) is in the file
+class PatternSink {
+public:
+	virtual ~PatternSink() {}
+
+	// cells row, column .. column+length-1 are alive
+	virtual void run(int64_t row, int64_t column, int64_t length) = 0;
+
+	// whether any of the size x size square at row, column can be seen, so macrocell readers can skip whole subtrees
+	virtual bool intersects(int64_t row, int64_t column, int64_t size) const { return true; }
+};
+
+// writes into size+2 packed rows in the SIMDLife layout (size/8+33 bytes, data from byte 32),
+// with the pattern's origin at originRow, originColumn, and anything which falls off the board dropped
+class PackedSink: public PatternSink {
+public:
+	PackedSink(uint8_t** cells, int width, int height, int64_t originRow, int64_t originColumn);
+
+	void run(int64_t row, int64_t column, int64_t length);
+	bool intersects(int64_t row, int64_t column, int64_t size) const;
+
+	int64_t getClipped() const; // live cells which didn't fit on the board
+
+private:
+	uint8_t** cells;
+	const int width;
+	const int height;
+	const int64_t originRow;
+	const int64_t originColumn;
+	int64_t clipped;
+
+};
+
+// for engines without a packed layout, one setCell per live cell
+class LifeSink: public PatternSink {
+public:
+	LifeSink(Life* life, int width, int height, int64_t originRow, int64_t originColumn);
+
+	void run(int64_t row, int64_t column, int64_t length);
+	bool intersects(int64_t row, int64_t column, int64_t size) const;
+
+private:
+	Life* life;
+	const int width;
+	const int height;
+	const int64_t originRow;
+	const int64_t originColumn;
+
+};
+
+// picks the reader from the first line, false (with info.error set) if the input is malformed
+bool readPattern(std::istream& in, PatternSink& sink, PatternInfo& info);
+
+bool readRLE(std::istream& in, PatternSink& sink, PatternInfo& info);
+bool readPlaintext(std::istream& in, PatternSink& sink, PatternInfo& info);
+bool readLife106(std::istream& in, PatternSink& sink, PatternInfo& info);
+bool readMacrocell(std::istream& in, PatternSink& sink, PatternInfo& info);
+
+// writers take the same packed rows as PackedSink, and write the whole width x height board
+void writeRLE(std::ostream& out, uint8_t** cells, int width, int height, const std::string& rule);
+void writePlaintext(std::ostream& out, uint8_t** cells, int width, int height);
+void writeLife106(std::ostream& out, uint8_t** cells, int width, int height);
+void writeMacrocell(std::ostream& out, uint8_t** cells, int width, int height, const std::string& rule);
@@ -0,0 +1,167 @@
+#include "row_arena.h"
+#include <immintrin.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <utility>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static std::atomic<int> nextColour(0);
+
+RowArena::RowArena() : slab(nullptr), bytes(0), mapped(false), huge(false), rowCount(0), stride(0), table(nullptr) {}
+
+RowArena::RowArena(int rowCount, int rowBytes, int alignedByte, bool hugePages) :
+	slab(nullptr), bytes(0), mapped(false), huge(false), rowCount(rowCount), stride(0), table(nullptr)
+{
+	stride = strideFor(rowBytes);
+
+	// each arena is moved on by a different number of lines: big slabs all start on a page (or a huge page),
+	// so two generations would otherwise have every cell at the same offset and fight over the same cache sets
+	const size_t lead = leadFor(alignedByte) + (size_t)(nextColour++ % COLOURS) * COLOUR_LINES * LINE;
+	const size_t used = lead + (size_t)stride * rowCount;
+	uint8_t* base = nullptr;
+
+#ifdef __linux__
+	if (hugePages && used >= HUGE_PAGE) {
+		// mmap only promises 4KB alignment, and transparent huge pages need 2MB aligned 2MB ranges
+		bytes = used + HUGE_PAGE;
+		void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p != MAP_FAILED) {
+			slab = (uint8_t*)p;
+			mapped = true;
+			base = (uint8_t*)(((uintptr_t)slab + HUGE_PAGE-1) & ~(uintptr_t)(HUGE_PAGE-1));
+			huge = madvise(base, (used + HUGE_PAGE-1) & ~(HUGE_PAGE-1), MADV_HUGEPAGE) == 0;
+		}
+	}
+#endif
+	if (base == nullptr) {
+		bytes = used;
+		slab = (uint8_t*)_mm_malloc(bytes, LINE);
+		memset(slab, 0, bytes); // fresh mappings are already zero
+		base = slab;
+	}
+
+	makeTable(base + lead);
+}
+
+// whole cache lines, plus one more when that's a multiple of 4KB,
+// otherwise the rows above and below a cell are in the same L1 set and keep evicting each other
+int RowArena::strideFor(int rowBytes) {
+	int stride = (rowBytes + LINE-1) / LINE * LINE;
+	return stride % 4096 == 0 ? stride + LINE : stride;
+}
+
+// the first row starts LINE - alignedByte into the slab, so every row's alignedByte is on a line
+int RowArena::leadFor(int alignedByte) {
+	return (LINE - alignedByte % LINE) % LINE;
+}
+
+bool RowArena::fromFile(const char* path, size_t offset, int rowCount, int rowBytes, int alignedByte, RowArena& arena) {
+	RowArena loaded;
+	loaded.rowCount = rowCount;
+	loaded.stride = strideFor(rowBytes);
+	const size_t lead = leadFor(alignedByte);
+	const size_t used = lead + (size_t)loaded.stride * rowCount;
+
+#ifdef __linux__
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < offset + used) {
+		close(fd);
+		return false;
+	}
+	// private and writable, the board is ticked in place and the pages it writes become its own
+	void* p = mmap(nullptr, used, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, (off_t)offset);
+	close(fd); // the mapping keeps the file
+	if (p != MAP_FAILED) {
+		loaded.slab = (uint8_t*)p;
+		loaded.bytes = used;
+		loaded.mapped = true;
+		loaded.makeTable(loaded.slab + lead);
+		arena = std::move(loaded);
+		return true;
+	}
+#endif
+
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr) return false;
+	loaded.bytes = used;
+	loaded.slab = (uint8_t*)_mm_malloc(used, LINE);
+	bool ok = fseek(file, (long)offset, SEEK_SET) == 0 && fread(loaded.slab, 1, used, file) == used;
+	fclose(file);
+	if (!ok) return false;
+	loaded.makeTable(loaded.slab + lead);
+	arena = std::move(loaded);
+	return true;
+}
+
+void RowArena::makeTable(uint8_t* first) {
+	table = new uint8_t*[rowCount];
+	for (int i = 0; i < rowCount; i++) {
+		table[i] = first + (size_t)stride * i;
+	}
+}
+
+RowArena::~RowArena() {
+	release();
+}
+
+RowArena::RowArena(RowArena&& other) : RowArena() {
+	*this = std::move(other);
+}
+
+RowArena& RowArena::operator=(RowArena&& other) {
+	if (this != &other) {
+		release();
+		std::swap(slab, other.slab);
+		std::swap(bytes, other.bytes);
+		std::swap(mapped, other.mapped);
+		std::swap(huge, other.huge);
+		std::swap(rowCount, other.rowCount);
+		std::swap(stride, other.stride);
+		std::swap(table, other.table);
+	}
+	return *this;
+}
+
+void RowArena::release() {
+#ifdef __linux__
+	if (mapped) munmap(slab, bytes);
+#endif
+	if (!mapped && slab != nullptr) _mm_free(slab);
+	delete[] table;
+	slab = nullptr;
+	table = nullptr;
+	bytes = 0;
+	mapped = false;
+	huge = false;
+	rowCount = 0;
+	stride = 0;
+}
+
+uint8_t** RowArena::rows() const {
+	return table;
+}
+
+int RowArena::getRowCount() const {
+	return rowCount;
+}
+
+int RowArena::getStride() const {
+	return stride;
+}
+
+size_t RowArena::getBytes() const {
+	return bytes;
+}
+
+bool RowArena::isHuge() const {
+	return huge;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// every row of a board in one zeroed slab, a fixed stride apart, so walking down the board is one stream
+// the prefetchers can follow, and a big board is a few huge pages instead of thousands of TLB entries
+// rows() is still a table of row pointers, so code taking uint8_t** doesn't change (and a torus can still wrap by pointer)
+class RowArena {
+public:
+	static const int LINE = 64;
+	static const size_t HUGE_PAGE = 2 << 20;
+	static const int COLOURS = 16; // offsets arenas are spread over
+	static const int COLOUR_LINES = 17; // lines between them, odd so no two are the same mod 4KB
+
+	RowArena();
+	// byte alignedByte of every row starts a cache line, huge pages are only asked for if the slab is at least one
+	RowArena(int rowCount, int rowBytes, int alignedByte = 0, bool hugePages = true);
+	~RowArena();
+
+	RowArena(RowArena&& other);
+	RowArena& operator=(RowArena&& other);
+	RowArena(const RowArena&) = delete;
+	RowArena& operator=(const RowArena&) = delete;
+
+	// rowCount rows laid out like a slab (without moving it on a few lines), from offset in a file, which has to be
+	// a multiple of 4KB. the file is mapped copy on write where there's mmap, so only the pages touched are read
+	// and writes to the rows never reach the file, without mmap it's read in. false if the file is too short
+	static bool fromFile(const char* path, size_t offset, int rowCount, int rowBytes, int alignedByte, RowArena& arena);
+	// what fromFile expects to find in the file: before the first row, and from one row to the next
+	static int leadFor(int alignedByte);
+	static int strideFor(int rowBytes);
+
+	uint8_t** rows() const;
+	int getRowCount() const;
+	int getStride() const;
+	size_t getBytes() const;
+	bool isHuge() const; // madvise(MADV_HUGEPAGE) was asked for and accepted, the kernel still decides whether to use them
+
+private:
+	uint8_t* slab; // what was allocated, rows start a little after it
+	size_t bytes;
+	bool mapped;
+	bool huge;
+	int rowCount;
+	int stride;
+	uint8_t** table;
+
+	void release();
+	void makeTable(uint8_t* first);
+
+};
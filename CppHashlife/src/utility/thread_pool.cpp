@@ -0,0 +1,78 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int threadCount) :
+	task(nullptr), taskCount(0), nextTask(0), busyWorkers(0), round(0), stopping(false)
+{
+	for (int i = 1; i < threadCount; i++) {
+		workers.push_back(std::thread([this, i]() { work(i); }));
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	mutex.lock();
+	stopping = true;
+	mutex.unlock();
+	startCondition.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+}
+
+int ThreadPool::size() const {
+	return workers.size() + 1;
+}
+
+void ThreadPool::run(int taskCount, const std::function<void(int, int)>& task) {
+	if (workers.empty()) {
+		for (int i = 0; i < taskCount; i++) {
+			task(i, 0);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->task = &task;
+		this->taskCount = taskCount;
+		this->nextTask = 0;
+		this->busyWorkers = workers.size();
+		round++;
+	}
+	startCondition.notify_all();
+
+	runTasks(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	doneCondition.wait(lock, [this]() { return busyWorkers == 0; });
+	this->task = nullptr;
+}
+
+void ThreadPool::work(int thread) {
+	uint64_t seenRound = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			startCondition.wait(lock, [this, seenRound]() { return stopping || round != seenRound; });
+			if (stopping) return;
+			seenRound = round;
+		}
+
+		runTasks(thread);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		busyWorkers--;
+		if (busyWorkers == 0) {
+			doneCondition.notify_one();
+		}
+	}
+}
+
+void ThreadPool::runTasks(int thread) {
+	// tasks are handed out one at a time, so uneven tasks still balance out
+	int i = nextTask.fetch_add(1);
+	while (i < taskCount) {
+		(*task)(i, thread);
+		i = nextTask.fetch_add(1);
+	}
+}
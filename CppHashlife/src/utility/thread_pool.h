@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// persistent pool of worker threads, the thread which calls run also does work
+class ThreadPool {
+public:
+	ThreadPool(int threadCount);
+	~ThreadPool();
+
+	int size() const;
+
+	// calls task(0, thread) ... task(taskCount-1, thread) spread across all threads, returns once they are all done
+	// thread is 0 for the calling thread and 1 ... size()-1 for the workers, so it can index per-thread memory
+	void run(int taskCount, const std::function<void(int, int)>& task);
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable startCondition;
+	std::condition_variable doneCondition;
+
+	const std::function<void(int, int)>* task;
+	int taskCount;
+	std::atomic<int> nextTask;
+	int busyWorkers;
+	uint64_t round;
+	bool stopping;
+
+	void work(int thread);
+	void runTasks(int thread);
+
+};
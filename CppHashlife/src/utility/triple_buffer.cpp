@@ -0,0 +1,30 @@
+#include "triple_buffer.h"
+
+TripleBuffer::TripleBuffer() : middle(1), back(0), front(2) {}
+
+int TripleBuffer::getBack() const {
+	return back;
+}
+
+int TripleBuffer::getFront() const {
+	return front;
+}
+
+bool TripleBuffer::publish() {
+	// release so the frame's contents are visible to whoever takes this slot
+	uint8_t old = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+	back = old & 3;
+	return old & FRESH;
+}
+
+bool TripleBuffer::isTaken() const {
+	return !(middle.load(std::memory_order_relaxed) & FRESH);
+}
+
+bool TripleBuffer::acquire() {
+	if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+	// nothing but the writer's publish can change middle in between, and that leaves it fresh, so this always gets a new frame
+	uint8_t old = middle.exchange(front, std::memory_order_acq_rel);
+	front = old & 3;
+	return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// lock free handoff of frames from one writer thread to one reader thread, the caller owns 3 slots of frame memory,
+// this only says which slot is whose: the writer fills back, the reader reads front, and the latest frame waits in the middle
+// neither side ever blocks, and the reader always gets the newest complete frame
+class TripleBuffer {
+public:
+	TripleBuffer();
+
+	int getBack() const; // the slot the writer may fill
+	int getFront() const; // the slot the reader may read
+
+	// writer: back becomes the latest frame and the writer gets a free slot back,
+	// true if that replaced a frame the reader never took
+	bool publish();
+
+	// writer: whether the reader has taken the latest frame, so a new one would be seen
+	bool isTaken() const;
+
+	// reader: moves front to the latest frame, false if there's been nothing new since the last call
+	bool acquire();
+
+private:
+	static const uint8_t FRESH = 4; // the middle slot holds a frame the reader hasn't taken, the low 2 bits are its index
+
+	std::atomic<uint8_t> middle;
+	int back;
+	int front;
+
+};
+
+// counts for frames the physics thread hands to the renderer
+struct FrameStats {
+	uint64_t published = 0; // frames handed over
+	uint64_t dropped = 0; // handed over but replaced before they were drawn
+	uint64_t skipped = 0; // generations never handed over because the renderer hadn't taken the last one yet
+	uint64_t drawn = 0; // new frames the renderer took
+	uint64_t publishNs = 0; // physics thread time spent copying out frames
+	uint64_t acquireNs = 0; // render thread time spent getting them
+};
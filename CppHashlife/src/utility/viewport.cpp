@@ -0,0 +1,248 @@
+#include "viewport.h"
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+int64_t Viewport::visibleCells(int windowSize) const {
+	return zoom >= 0 ? windowSize >> zoom : (int64_t)windowSize << -zoom;
+}
+
+void Viewport::zoomAt(int x, int y, int steps, int boardSize, int windowSize) {
+	int minZoom = 0;
+	while (minZoom > MIN_ZOOM && ((int64_t)windowSize << -minZoom) < boardSize) minZoom--;
+
+	int next = std::max(minZoom, std::min(MAX_ZOOM, zoom + steps));
+	// the cell under the pointer, then where the corner has to be to keep it there
+	int64_t cellRow = zoom >= 0 ? row + (y >> zoom) : row + ((int64_t)y << -zoom);
+	int64_t cellColumn = zoom >= 0 ? column + (x >> zoom) : column + ((int64_t)x << -zoom);
+	zoom = next;
+	row = zoom >= 0 ? cellRow - (y >> zoom) : cellRow - ((int64_t)y << -zoom);
+	column = zoom >= 0 ? cellColumn - (x >> zoom) : cellColumn - ((int64_t)x << -zoom);
+	clamp(boardSize, windowSize);
+}
+
+void Viewport::pan(int dx, int dy, int boardSize, int windowSize) {
+	if (zoom >= 0) {
+		// whole cells only, the remainder is dropped so slow drags still move when zoomed in
+		row += dy / (1 << zoom);
+		column += dx / (1 << zoom);
+	} else {
+		row += (int64_t)dy << -zoom;
+		column += (int64_t)dx << -zoom;
+	}
+	clamp(boardSize, windowSize);
+}
+
+void Viewport::clamp(int boardSize, int windowSize) {
+	zoom = std::max(MIN_ZOOM, std::min(MAX_ZOOM, zoom));
+	int64_t visible = visibleCells(windowSize);
+	int64_t block = zoom >= 0 ? 1 : (int64_t)1 << -zoom;
+	row = std::max<int64_t>(0, std::min(row, boardSize - visible)) / block * block;
+	column = std::max<int64_t>(0, std::min(column, boardSize - visible)) / block * block;
+}
+
+// 64 cells from column on, bit 63 the leftmost, with nothing past the end of the row
+static inline uint64_t loadBits(const uint8_t* row, int64_t column, int size) {
+	const uint8_t* data = row + 32;
+	const int64_t rowBytes = (size + 7) / 8;
+	int64_t byte = column >> 3;
+	int shift = column & 7;
+	uint64_t bits;
+	uint64_t next;
+	if (byte + 9 <= rowBytes) {
+		memcpy(&bits, &data[byte], 8);
+		bits = __builtin_bswap64(bits);
+		next = data[byte + 8];
+	} else {
+		bits = 0;
+		for (int b = 0; b < 8; b++) {
+			bits = (bits << 8) | (byte + b < rowBytes ? data[byte + b] : 0);
+		}
+		next = byte + 8 < rowBytes ? data[byte + 8] : 0;
+	}
+	return shift == 0 ? bits : (bits << shift) | (next >> (8 - shift));
+}
+
+// masks for adding neighbouring 2^s bit fields, the low field of each pair
+static const uint64_t PAIR_MASKS[6] = {
+	0x5555555555555555ULL, 0x3333333333333333ULL, 0x0F0F0F0F0F0F0F0FULL,
+	0x00FF00FF00FF00FFULL, 0x0000FFFF0000FFFFULL, 0x00000000FFFFFFFFULL,
+};
+
+static inline uint8_t shade(uint64_t alive, int blockLog2) {
+	return alive == 0 ? 0 : 64 + ((191 * alive) >> (2 * blockLog2));
+}
+
+static void renderCells(uint8_t* const* cells, int size, const Viewport& view, int windowSize, uint8_t* out, ViewImage& image) {
+	const int count = (int)view.visibleCells(windowSize);
+	const int rowBytes = count / 8;
+	image.density = false;
+	image.width = count;
+	image.height = count;
+
+	for (int p = 0; p < count; p++) {
+		uint8_t* outRow = &out[p * rowBytes];
+		int64_t i = view.row + p;
+		if (i < 0 || i >= size) {
+			memset(outRow, 0, rowBytes);
+			continue;
+		}
+		for (int b = 0; b < rowBytes; b += 8) {
+			uint64_t bits = __builtin_bswap64(loadBits(cells[i+1], view.column + b*8, size));
+			memcpy(&outRow[b], &bits, std::min(8, rowBytes - b));
+		}
+	}
+}
+
+// loadBits for a word known to be inside the row, data is the row from the view's first byte
+static inline uint64_t fastBits(const uint8_t* data, int word, int shift) {
+	uint64_t bits;
+	memcpy(&bits, &data[word*8], 8);
+	bits = __builtin_bswap64(bits);
+	return shift == 0 ? bits : (bits << shift) | (data[word*8 + 8] >> (8 - shift));
+}
+
+// 2 cell blocks, counted and split into 4 bit lanes
+static inline void addPairs(uint64_t bits, uint64_t& even, uint64_t& odd) {
+	bits = (bits & PAIR_MASKS[0]) + ((bits >> 1) & PAIR_MASKS[0]);
+	even += bits & PAIR_MASKS[1];
+	odd += (bits >> 2) & PAIR_MASKS[1];
+}
+
+// counts of every 4 cells
+static inline uint64_t quadCounts(uint64_t bits) {
+	bits = (bits & PAIR_MASKS[0]) + ((bits >> 1) & PAIR_MASKS[0]);
+	return (bits & PAIR_MASKS[1]) + ((bits >> 2) & PAIR_MASKS[1]);
+}
+
+// zoomed out, a block is 2^K cells a side, a template so the masks and shifts below are all constants
+template<int K>
+static void renderBlocks(uint8_t* const* cells, int size, const Viewport& view, int windowSize, uint8_t* out, ViewImage& image) {
+	const int64_t block = (int64_t)1 << K;
+	const int64_t cellsAcross = (int64_t)windowSize << K;
+	const int words = (int)((cellsAcross + 63) / 64);
+	image.density = view.density;
+	image.width = windowSize;
+	image.height = windowSize;
+
+	// below 64 cell blocks, a word holds 64 >> K blocks. for density the word is popcounted down to 2^K bit fields,
+	// then odd and even fields are split into lanes twice as wide, which can add up a whole block's rows without overflowing
+	// from K = 2, rows only go down to 4 bit fields (at most 4), 3 rows are added there and the rest of the popcount
+	// is done on the sum, which more than halves the work per row
+	const int lanes = K < 6 ? 64 >> K : 1;
+	const int pairMask = K < 6 ? K : 5;
+	const uint64_t laneMask = K < 5 ? ((uint64_t)1 << (2 << K)) - 1 : ~(uint64_t)0;
+	const uint64_t fieldMask = K < 6 ? ((uint64_t)1 << (K < 6 ? 1 << K : 0)) - 1 : ~(uint64_t)0;
+	std::vector<uint64_t> even(words);
+	std::vector<uint64_t> odd(words);
+	std::vector<uint64_t> quads(K >= 2 ? words : 0);
+	const int quadSteps = K < 6 ? K : 6;
+
+	for (int p = 0; p < windowSize; p++) {
+		std::fill(even.begin(), even.end(), 0);
+		std::fill(odd.begin(), odd.end(), 0);
+
+		int64_t firstRow = view.row + p * block;
+		int64_t lastRow = std::min<int64_t>(size, firstRow + block);
+		// words which can be read without running off the row, so the loop over them is branch free
+		const int64_t rowBytes = (size + 7) / 8;
+		const int fastWords = (int)std::max<int64_t>(0, std::min<int64_t>(words, (rowBytes - 9 - view.column/8) / 8 + 1));
+		const int shift = view.column & 7;
+		int quadRows = 0;
+		for (int64_t i = std::max<int64_t>(0, firstRow); i < lastRow; i++) {
+			const uint8_t* row = cells[i+1];
+			const uint8_t* data = &row[32 + view.column/8];
+			int w = 0;
+			if (!view.density) {
+				for (; w < fastWords; w++) even[w] |= fastBits(data, w, shift);
+			} else if (K == 1) {
+				for (; w < fastWords; w++) addPairs(fastBits(data, w, shift), even[w], odd[w]);
+			} else {
+				for (; w < fastWords; w++) quads[w] += quadCounts(fastBits(data, w, shift));
+			}
+			for (; w < words && view.column + (int64_t)w * 64 < size; w++) {
+				uint64_t bits = loadBits(row, view.column + (int64_t)w * 64, size);
+				if (!view.density) even[w] |= bits;
+				else if (K == 1) addPairs(bits, even[w], odd[w]);
+				else quads[w] += quadCounts(bits);
+			}
+
+			if (K >= 2 && view.density && (++quadRows == 3 || i == lastRow - 1)) {
+				for (int w = 0; w < words; w++) {
+					uint64_t bits = quads[w];
+					for (int s = 2; s < quadSteps; s++) {
+						bits = (bits & PAIR_MASKS[s]) + ((bits >> (1 << s)) & PAIR_MASKS[s]);
+					}
+					if (K >= 6) {
+						even[w] += bits;
+					} else {
+						even[w] += bits & PAIR_MASKS[pairMask];
+						odd[w] += (bits >> (K < 6 ? 1 << K : 0)) & PAIR_MASKS[pairMask];
+					}
+					quads[w] = 0;
+				}
+				quadRows = 0;
+			}
+		}
+
+		if (K >= 6) {
+			// whole words per block
+			const int perPixel = K >= 6 ? 1 << (K - 6) : 1;
+			uint8_t* densityRow = &out[p * windowSize];
+			uint8_t* bitRow = &out[p * windowSize/8];
+			if (!view.density) memset(bitRow, 0, windowSize/8);
+			for (int x = 0; x < windowSize; x++) {
+				uint64_t alive = 0;
+				for (int w = x * perPixel; w < (x+1) * perPixel && w < words; w++) {
+					alive += view.density ? even[w] : even[w] != 0;
+				}
+				if (view.density) densityRow[x] = shade(alive, K);
+				else if (alive) bitRow[x/8] |= 0x80 >> (x%8);
+			}
+		} else if (view.density) {
+			// field f from the left starts at bit 64 - (f+1)*2^K, the even lanes hold the fields at even positions
+			uint8_t* outRow = &out[p * windowSize];
+			for (int w = 0; w < words; w++) {
+				uint8_t* pixels = &outRow[w * lanes];
+				for (int position = 0; position < lanes; position += 2) {
+					pixels[lanes-1 - position] = shade((even[w] >> (position << K)) & laneMask, K);
+					pixels[lanes-2 - position] = shade((odd[w] >> (position << K)) & laneMask, K);
+				}
+			}
+		} else {
+			// each field's bits folded down into its lowest, then the lowest bits gathered into pixels
+			uint8_t* outRow = &out[p * windowSize/8];
+			uint64_t pixels = 0;
+			for (int w = 0; w < words; w++) {
+				uint64_t bits = even[w];
+				for (int position = lanes-1; position >= 0; position--) {
+					pixels = (pixels << 1) | (((bits >> (position << K)) & fieldMask) != 0);
+				}
+				// words hold a whole number of bytes of pixels once there are at least 8
+				int pixelCount = (w+1) * lanes;
+				if (pixelCount % 64 == 0 || w == words-1) {
+					int bytes = (pixelCount % 64 == 0 ? 64 : pixelCount % 64) / 8;
+					int start = (pixelCount - 1) / 64 * 8;
+					for (int b = 0; b < bytes; b++) {
+						outRow[start + b] = pixels >> (8 * (bytes - 1 - b));
+					}
+					pixels = 0;
+				}
+			}
+		}
+	}
+}
+
+void renderView(uint8_t* const* cells, int size, const Viewport& view, int windowSize, uint8_t* out, ViewImage& image) {
+	switch (view.zoom) {
+		case -1: renderBlocks<1>(cells, size, view, windowSize, out, image); break;
+		case -2: renderBlocks<2>(cells, size, view, windowSize, out, image); break;
+		case -3: renderBlocks<3>(cells, size, view, windowSize, out, image); break;
+		case -4: renderBlocks<4>(cells, size, view, windowSize, out, image); break;
+		case -5: renderBlocks<5>(cells, size, view, windowSize, out, image); break;
+		case -6: renderBlocks<6>(cells, size, view, windowSize, out, image); break;
+		case -7: renderBlocks<7>(cells, size, view, windowSize, out, image); break;
+		case -8: renderBlocks<8>(cells, size, view, windowSize, out, image); break;
+		default: renderCells(cells, size, view, windowSize, out, image); break;
+	}
+}
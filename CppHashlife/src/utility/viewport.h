@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+// which part of the board the window shows, row 0 of the window is at the bottom, like the texture it's drawn from
+struct Viewport {
+	int64_t row = 0; // the cell in the window's bottom left pixel
+	int64_t column = 0;
+	int zoom = 0; // 2^zoom pixels per cell when positive, 2^-zoom cells a side per pixel when negative
+	bool density = true; // zoomed out, shade pixels by how many of their cells are alive, instead of lighting any with one
+
+	static const int MAX_ZOOM = 5; // 32 cells across a 1024 window
+	static const int MIN_ZOOM = -8; // 256 cells a side per pixel, 256k across a 1024 window
+
+	// cells across the window
+	int64_t visibleCells(int windowSize) const;
+
+	// steps in (positive) or out, keeping the cell under pixel x, y where it is,
+	// never further out than it takes to fit the whole board in the window
+	void zoomAt(int x, int y, int steps, int boardSize, int windowSize);
+	void pan(int dx, int dy, int boardSize, int windowSize); // in pixels
+
+	// keeps the zoom in range and the board in view, and zoomed out, starts on a whole pixel so every pixel is a whole block of cells
+	void clamp(int boardSize, int windowSize);
+};
+
+// what renderView wrote
+struct ViewImage {
+	bool density; // a byte per pixel, 0 for none alive, else 64 + 191 * the fraction alive, otherwise a bit per cell
+	int width; // in cells for bits, pixels for density
+	int height;
+};
+
+// fills out from size+2 packed rows in the SIMDLife layout ((size+7)/8+33 bytes, data from byte 32), which needs
+// windowSize*windowSize bytes of room. zoomed in or at 1:1 it's the visible cells, width/8 bytes a row,
+// bit 7 the leftmost, for the shader to scale up. zoomed out every pixel is a 2^-zoom square block,
+// reduced with word wide ors or lane popcounts, so the cost goes with the visible cells and the window, not the board
+void renderView(uint8_t* const* cells, int size, const Viewport& view, int windowSize, uint8_t* out, ViewImage& image);